@@ -5,9 +5,37 @@
 #include <ctype.h>
 #include <dirent.h>
 #include <sys/stat.h>
+#include <fcntl.h>
 #include <unistd.h>
+#include <errno.h>
+#include <limits.h>
+#include <sys/mman.h>
+#include <signal.h>
+#include <setjmp.h>
+#ifdef FILEX_HAVE_IO_URING
+#include <liburing.h>
+#endif
 
-// Dossiers à exclure de la recherche récursive (optimisation pour macOS/Linux)
+// Noyaux vectoriels de memmem_icase (sélection à l'exécution)
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__) && defined(__SSE2__)
+#define MEMMEM_ICASE_X86 1
+#include <immintrin.h>
+#else
+#define MEMMEM_ICASE_X86 0
+#endif
+#if defined(__aarch64__) && defined(__GNUC__)
+#define MEMMEM_ICASE_NEON 1
+#include <arm_neon.h>
+#else
+#define MEMMEM_ICASE_NEON 0
+#endif
+#ifdef __linux__
+#include <poll.h>
+#include <sys/inotify.h>
+#endif
+
+// Dossiers à exclure de la recherche récursive (optimisation pour macOS/Linux):
+// règles par défaut de exclude_rules_create()
 static const char* EXCLUDED_DIRS[] = {
     // Dépendances et builds
     "node_modules",
@@ -49,137 +77,487 @@ static const char* EXCLUDED_DIRS[] = {
 };
 
 FileList* file_list_create(void) {
-    FileList* list = (FileList*)malloc(sizeof(FileList));
+    FileList* list = (FileList*)calloc(1, sizeof(FileList));
     if (!list) return NULL;
     
-    list->capacity = 1000;
+    // Segments et blocs sont alloués à la demande
+    list->memory_budget = FILE_LIST_DEFAULT_BUDGET;
+    atomic_init(&list->refcount, 1);
+    return list;
+}
+
+// Libère tous les segments et blocs (la liste redevient vide)
+static void file_list_release_storage(FileList* list) {
+    for (int i = 0; i < list->chunk_count; i++) {
+        free(list->chunks[i]);
+    }
+    for (int i = 0; i < list->block_count; i++) {
+        free(list->blocks[i]);
+    }
+    list->chunk_count = 0;
+    list->block_count = 0;
+    list->block_used = 0;
+    list->first_chunk_entries = 0;
+    list->first_block_size = 0;
     list->count = 0;
-    list->entries = (FileEntry*)malloc(sizeof(FileEntry) * list->capacity);
-    
-    if (!list->entries) {
-        free(list);
-        return NULL;
+    list->dir_count = 0;
+    list->memory_used = 0;
+    list->truncated = false;
+}
+
+FileList* file_list_retain(FileList* list) {
+    if (list) {
+        atomic_fetch_add_explicit(&list->refcount, 1, memory_order_relaxed);
     }
-    
     return list;
 }
 
 void file_list_destroy(FileList* list) {
-    if (list) {
-        if (list->entries) {
-            free(list->entries);
-        }
+    // acq_rel: les lectures des autres détenteurs précèdent la libération
+    if (list && atomic_fetch_sub_explicit(&list->refcount, 1, memory_order_acq_rel) == 1) {
+        file_list_release_storage(list);
+        free(list->chunks);
+        free(list->blocks);
         free(list);
     }
 }
 
-static bool file_list_add(FileList* list, const FileEntry* entry) {
-    if (list->count >= MAX_FILES) {
-        return false;
+void file_list_set_budget(FileList* list, size_t memory_budget) {
+    if (list) {
+        list->memory_budget = memory_budget > 0 ? memory_budget : FILE_LIST_DEFAULT_BUDGET;
     }
+}
+
+FileEntry* file_list_get(const FileList* list, int index) {
+    return &list->chunks[index / FILE_LIST_CHUNK_ENTRIES][index % FILE_LIST_CHUNK_ENTRIES];
+}
+
+// Agrandit une table de pointeurs (segments ou blocs). Seuls les pointeurs
+// sont recopiés, jamais les entrées ni les chemins.
+static bool grow_pointer_table(void*** table, int* capacity, int needed) {
+    if (needed <= *capacity) return true;
     
-    if (list->count >= list->capacity) {
-        int new_capacity = list->capacity * 2;
-        if (new_capacity > MAX_FILES) {
-            new_capacity = MAX_FILES;
-        }
-        
-        FileEntry* new_entries = (FileEntry*)realloc(list->entries, sizeof(FileEntry) * new_capacity);
-        if (!new_entries) {
-            return false;
-        }
-        
-        list->entries = new_entries;
-        list->capacity = new_capacity;
+    int new_capacity = *capacity > 0 ? *capacity * 2 : 16;
+    while (new_capacity < needed) {
+        new_capacity *= 2;
     }
     
-    list->entries[list->count++] = *entry;
+    void** new_table = (void**)realloc(*table, sizeof(void*) * new_capacity);
+    if (!new_table) return false;
+    
+    *table = new_table;
+    *capacity = new_capacity;
     return true;
 }
 
-// Fonction pour récupérer les métadonnées d'un fichier
-static void get_file_metadata(const char* path, FileEntry* entry) {
-    struct stat st;
-    if (stat(path, &st) == 0) {
-        entry->mod_time = st.st_mtime;
-        entry->permissions = st.st_mode;
-        entry->owner_uid = st.st_uid;
-        entry->owner_gid = st.st_gid;
-    } else {
-        entry->mod_time = 0;
-        entry->permissions = 0;
-        entry->owner_uid = 0;
-        entry->owner_gid = 0;
+// Alloue un segment ou un bloc en respectant le budget
+static void* file_list_alloc(FileList* list, size_t size) {
+    if (list->memory_used + size > list->memory_budget) {
+        list->truncated = true;
+        return NULL;
+    }
+    
+    void* memory = malloc(size);
+    if (!memory) {
+        list->truncated = true;
+        return NULL;
     }
+    
+    list->memory_used += size;
+    return memory;
 }
 
-bool explore_directory(const char* path, FileList* list, int depth, bool show_hidden) {
-    DIR* dir = opendir(path);
-    if (!dir) {
-        fprintf(stderr, "Impossible d'ouvrir le répertoire: %s\n", path);
+// Taille allouée pour le segment ou le bloc d'indice index
+static inline int file_list_chunk_entries(const FileList* list, int index) {
+    return index == 0 ? list->first_chunk_entries : FILE_LIST_CHUNK_ENTRIES;
+}
+
+static inline size_t file_list_block_size(const FileList* list, int index) {
+    return index == 0 ? list->first_block_size : FILE_LIST_STRING_BLOCK;
+}
+
+static bool file_list_append_chunk(FileList* list) {
+    if (!grow_pointer_table((void***)&list->chunks, &list->chunk_capacity, list->chunk_count + 1)) {
+        list->truncated = true;
         return false;
     }
     
-    struct dirent* entry;
-    while ((entry = readdir(dir)) != NULL) {
-        // Ignorer . et ..
-        if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0) {
-            continue;
-        }
-        
-        // Ignorer les fichiers cachés si non demandé
-        if (!show_hidden && entry->d_name[0] == '.') {
-            continue;
+    int entries = list->chunk_count == 0 && !list->pinned ? FILE_LIST_FIRST_CHUNK_ENTRIES : FILE_LIST_CHUNK_ENTRIES;
+    FileEntry* chunk = (FileEntry*)file_list_alloc(list, sizeof(FileEntry) * entries);
+    if (!chunk) return false;
+    
+    if (list->chunk_count == 0) {
+        list->first_chunk_entries = entries;
+    }
+    list->chunks[list->chunk_count++] = chunk;
+    return true;
+}
+
+// Agrandit une zone du premier segment ou bloc (realloc, dans le budget)
+static void* file_list_grow_first(FileList* list, void* memory, size_t size, size_t new_size) {
+    if (list->memory_used + (new_size - size) > list->memory_budget) {
+        list->truncated = true;
+        return NULL;
+    }
+    
+    void* grown = realloc(memory, new_size);
+    if (!grown) {
+        list->truncated = true;
+        return NULL;
+    }
+    
+    list->memory_used += new_size - size;
+    return grown;
+}
+
+// Double le premier segment (plein, plus petit que les suivants)
+static bool file_list_grow_first_chunk(FileList* list) {
+    int entries = list->first_chunk_entries * 2;
+    if (entries > FILE_LIST_CHUNK_ENTRIES) entries = FILE_LIST_CHUNK_ENTRIES;
+    
+    FileEntry* chunk = (FileEntry*)file_list_grow_first(list, list->chunks[0], sizeof(FileEntry) * list->first_chunk_entries,
+                                                        sizeof(FileEntry) * entries);
+    if (!chunk) return false;
+    
+    list->chunks[0] = chunk;
+    list->first_chunk_entries = entries;
+    return true;
+}
+
+// Bloc pour un chemin de needed octets: premier bloc doublé tant qu'il n'a
+// pas sa taille fixe, sinon nouveau bloc
+static bool file_list_append_block(FileList* list, size_t needed) {
+    if (list->block_count == 1 && list->first_block_size < FILE_LIST_STRING_BLOCK &&
+        list->block_used + needed <= FILE_LIST_STRING_BLOCK) {
+        size_t size = list->first_block_size * 2;
+        while (size < list->block_used + needed) {
+            size *= 2;
         }
+        if (size > FILE_LIST_STRING_BLOCK) size = FILE_LIST_STRING_BLOCK;
         
-        char full_path[MAX_PATH_LENGTH];
-        snprintf(full_path, sizeof(full_path), "%s/%s", path, entry->d_name);
+        char* block = (char*)file_list_grow_first(list, list->blocks[0], list->first_block_size, size);
+        if (!block) return false;
         
-        struct stat st;
-        if (stat(full_path, &st) == -1) {
-            continue;
+        list->blocks[0] = block;
+        list->first_block_size = size;
+        return true;
+    }
+    
+    // Les offsets de l'arène sont sur 32 bits
+    if ((uint64_t)(list->block_count + 1) * FILE_LIST_STRING_BLOCK > UINT32_MAX) {
+        list->truncated = true;
+        return false;
+    }
+    
+    if (!grow_pointer_table((void***)&list->blocks, &list->block_capacity, list->block_count + 1)) {
+        list->truncated = true;
+        return false;
+    }
+    
+    size_t size = FILE_LIST_STRING_BLOCK;
+    if (list->block_count == 0 && !list->pinned) {
+        size = FILE_LIST_FIRST_BLOCK;
+        while (size < needed) {
+            size *= 2;
         }
+    }
+    char* block = (char*)file_list_alloc(list, size);
+    if (!block) return false;
+    
+    if (list->block_count == 0) {
+        list->first_block_size = size;
+    }
+    list->blocks[list->block_count++] = block;
+    list->block_used = 0;
+    return true;
+}
+
+bool file_list_assign(FileList* dest, const FileList* src) {
+    if (!dest || !src) return false;
+    if (dest == src) return true;
+    
+    file_list_release_storage(dest);
+    
+    if (!grow_pointer_table((void***)&dest->chunks, &dest->chunk_capacity, src->chunk_count) ||
+        !grow_pointer_table((void***)&dest->blocks, &dest->block_capacity, src->block_count)) {
+        return false;
+    }
+    
+    // Même découpage que la source: les offsets restent valides
+    for (int i = 0; i < src->chunk_count; i++) {
+        int used = src->count - i * FILE_LIST_CHUNK_ENTRIES;
+        if (used > FILE_LIST_CHUNK_ENTRIES) used = FILE_LIST_CHUNK_ENTRIES;
         
-        FileEntry file_entry;
-        strncpy(file_entry.path, full_path, sizeof(file_entry.path) - 1);
-        file_entry.path[sizeof(file_entry.path) - 1] = '\0';
-        
-        strncpy(file_entry.name, entry->d_name, sizeof(file_entry.name) - 1);
-        file_entry.name[sizeof(file_entry.name) - 1] = '\0';
-        
-        file_entry.size = st.st_size;
-        file_entry.depth = depth;
-        
-        // Récupérer les métadonnées
-        get_file_metadata(full_path, &file_entry);
+        FileEntry* chunk = (FileEntry*)malloc(sizeof(FileEntry) * file_list_chunk_entries(src, i));
+        if (!chunk) {
+            file_list_release_storage(dest);
+            return false;
+        }
+        if (used > 0) {
+            memcpy(chunk, src->chunks[i], sizeof(FileEntry) * used);
+        }
+        dest->chunks[dest->chunk_count++] = chunk;
+    }
+    
+    for (int i = 0; i < src->block_count; i++) {
+        size_t used = (i == src->block_count - 1) ? src->block_used : FILE_LIST_STRING_BLOCK;
         
-        if (S_ISDIR(st.st_mode)) {
-            file_entry.type = FILE_TYPE_DIRECTORY;
-            file_list_add(list, &file_entry);
-            
-            // Exploration récursive
-            explore_directory(full_path, list, depth + 1, show_hidden);
-        } else {
-            file_entry.type = FILE_TYPE_FILE;
-            file_list_add(list, &file_entry);
+        char* block = (char*)malloc(file_list_block_size(src, i));
+        if (!block) {
+            file_list_release_storage(dest);
+            return false;
         }
+        memcpy(block, src->blocks[i], used);
+        dest->blocks[dest->block_count++] = block;
     }
     
-    closedir(dir);
+    dest->count = src->count;
+    dest->dir_count = src->dir_count;
+    dest->block_used = src->block_used;
+    dest->first_chunk_entries = src->first_chunk_entries;
+    dest->first_block_size = src->first_block_size;
+    dest->memory_used = src->memory_used;
+    dest->truncated = src->truncated;
     return true;
 }
 
-bool explore_directory_shallow(const char* path, FileList* list, bool show_hidden) {
-    DIR* dir = opendir(path);
+FileList* file_list_copy(const FileList* list) {
+    if (!list) return NULL;
+    
+    FileList* copy = file_list_create();
+    if (!copy) return NULL;
+    
+    copy->memory_budget = list->memory_budget;
+    if (!file_list_assign(copy, list)) {
+        file_list_destroy(copy);
+        return NULL;
+    }
+    return copy;
+}
+
+bool file_list_make_writable(FileList** list) {
+    if (!list || !*list) return false;
+    if (atomic_load_explicit(&(*list)->refcount, memory_order_acquire) == 1) return true;
+    
+    FileList* copy = file_list_copy(*list);
+    if (!copy) return false;
+    
+    file_list_destroy(*list);
+    *list = copy;
+    return true;
+}
+
+const char* file_entry_path(const FileList* list, const FileEntry* entry) {
+    return list->blocks[entry->path_offset / FILE_LIST_STRING_BLOCK] + entry->path_offset % FILE_LIST_STRING_BLOCK;
+}
+
+const char* file_entry_name(const FileList* list, const FileEntry* entry) {
+    return file_entry_path(list, entry) + entry->name_offset;
+}
+
+// Type et métadonnées d'une entrée depuis un stat déjà effectué
+static void file_entry_set_stat(FileEntry* entry, const struct stat* st) {
+    entry->type = S_ISDIR(st->st_mode) ? FILE_TYPE_DIRECTORY : FILE_TYPE_FILE;
+    entry->size = st->st_size;
+    
+    // Métadonnées
+    entry->mod_time = st->st_mtime;
+    entry->permissions = st->st_mode;
+    entry->owner_uid = st->st_uid;
+    entry->owner_gid = st->st_gid;
+}
+
+// Prépare l'entrée d'indice count et copie son chemin dans l'arène
+// (NULL si budget atteint); l'appelant la remplit puis incrémente count
+static FileEntry* file_list_push(FileList* list, const char* full_path, size_t path_length) {
+    if (list->count == list->chunk_count * FILE_LIST_CHUNK_ENTRIES) {
+        if (!file_list_append_chunk(list)) {
+            return NULL;
+        }
+    } else if (list->chunk_count == 1 && list->count == list->first_chunk_entries) {
+        if (!file_list_grow_first_chunk(list)) {
+            return NULL;
+        }
+    }
+    
+    // Un chemin ne chevauche jamais deux blocs
+    if (list->block_count == 0 ||
+        list->block_used + path_length + 1 > file_list_block_size(list, list->block_count - 1)) {
+        if (!file_list_append_block(list, path_length + 1)) {
+            return NULL;
+        }
+    }
+    
+    char* block = list->blocks[list->block_count - 1];
+    size_t offset = (size_t)(list->block_count - 1) * FILE_LIST_STRING_BLOCK + list->block_used;
+    memcpy(block + list->block_used, full_path, path_length + 1);
+    list->block_used += path_length + 1;
+    
+    FileEntry* entry = file_list_get(list, list->count);
+    entry->path_offset = (uint32_t)offset;
+    entry->path_length = (uint16_t)path_length;
+    return entry;
+}
+
+// Ajoute une entrée depuis un stat déjà effectué; name_offset désigne le début
+// du nom dans full_path. Retourne false (et marque la liste tronquée) si le
+// budget mémoire est atteint.
+static bool file_list_add(FileList* list, const char* full_path, size_t path_length, size_t name_offset, const struct stat* st, int depth) {
+    FileEntry* entry = file_list_push(list, full_path, path_length);
+    if (!entry) return false;
+    
+    entry->name_offset = (uint16_t)name_offset;
+    entry->depth = depth;
+    entry->match_offset = 0;
+    entry->match_line = 0;
+    entry->score = 0;
+    file_entry_set_stat(entry, st);
+    
+    if (entry->type == FILE_TYPE_DIRECTORY) {
+        list->dir_count++;
+    }
+    list->count++;
+    return true;
+}
+
+// Copie une entrée d'une autre liste (chemin recopié dans l'arène de list)
+static bool file_list_add_entry(FileList* list, const FileList* src, const FileEntry* source) {
+    FileEntry* entry = file_list_push(list, file_entry_path(src, source), source->path_length);
+    if (!entry) return false;
+    
+    uint32_t path_offset = entry->path_offset;
+    *entry = *source;
+    entry->path_offset = path_offset;
+    
+    if (entry->type == FILE_TYPE_DIRECTORY) {
+        list->dir_count++;
+    }
+    list->count++;
+    return true;
+}
+
+// Dimensionne les tables de pointeurs pour tout le budget et alloue le
+// premier segment et le premier bloc entiers: rien n'est plus jamais
+// réalloué, d'autres threads peuvent donc lire les entrées déjà publiées
+// pendant que le propriétaire en ajoute
+static bool file_list_reserve_tables(FileList* list) {
+    list->pinned = true;
+
+    size_t chunks = list->memory_budget / (sizeof(FileEntry) * FILE_LIST_CHUNK_ENTRIES) + 1;
+    size_t blocks = list->memory_budget / FILE_LIST_STRING_BLOCK + 1;
+    
+    // Au-delà, les offsets 32 bits de l'arène refusent l'ajout avant la table
+    size_t max_blocks = UINT32_MAX / FILE_LIST_STRING_BLOCK + 1;
+    size_t max_chunks = (UINT32_MAX / 2) / FILE_LIST_CHUNK_ENTRIES + 1;
+    if (blocks > max_blocks) blocks = max_blocks;
+    if (chunks > max_chunks) chunks = max_chunks;
+    
+    return grow_pointer_table((void***)&list->chunks, &list->chunk_capacity, (int)chunks) &&
+           grow_pointer_table((void***)&list->blocks, &list->block_capacity, (int)blocks);
+}
+
+// Retire une entrée en décalant les suivantes (son chemin reste dans l'arène)
+static void file_list_remove(FileList* list, int index) {
+    if (index < 0 || index >= list->count) return;
+    
+    if (file_list_get(list, index)->type == FILE_TYPE_DIRECTORY) {
+        list->dir_count--;
+    }
+    for (int i = index; i < list->count - 1; i++) {
+        *file_list_get(list, i) = *file_list_get(list, i + 1);
+    }
+    list->count--;
+}
+
+
+// === Énumération relative au fd du dossier ===
+// Les walkers ouvrent chaque sous-dossier avec openat() depuis le fd du parent
+// et récupèrent les métadonnées avec fstatat(): le noyau ne résout plus le
+// chemin complet à chaque appel, et un seul stat est fait par entrée.
+
+// Ouvre un dossier relativement à parent_fd (AT_FDCWD pour un chemin complet)
+static DIR* open_directory_at(int parent_fd, const char* name) {
+    int fd = openat(parent_fd, name, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd < 0) {
+        return NULL;
+    }
+    
+    DIR* dir = fdopendir(fd);
     if (!dir) {
-        fprintf(stderr, "Impossible d'ouvrir le répertoire: %s\n", path);
-        return false;
+        close(fd);
+    }
+    return dir;
+}
+
+// Déduit le type de l'entrée depuis d_type quand le système de fichiers le
+// fournit. Retourne false s'il faut un stat (DT_UNKNOWN, liens symboliques).
+static bool entry_type_hint(const struct dirent* entry, bool* is_dir) {
+#ifdef DT_UNKNOWN
+    switch (entry->d_type) {
+        case DT_DIR:
+            *is_dir = true;
+            return true;
+        case DT_UNKNOWN:
+        case DT_LNK:
+            return false;
+        default:
+            *is_dir = false;
+            return true;
+    }
+#else
+    (void)entry;
+    (void)is_dir;
+    return false;
+#endif
+}
+
+// Copie le chemin du dossier dans buffer avec un '/' final.
+// Retourne la longueur du préfixe (0 si le chemin est trop long).
+static size_t path_set_directory(char* buffer, const char* dir_path) {
+    size_t len = strlen(dir_path);
+    if (len + 2 > MAX_PATH_LENGTH) {
+        return 0;
+    }
+    memcpy(buffer, dir_path, len);
+    if (len == 0 || buffer[len - 1] != '/') {
+        buffer[len++] = '/';
+    }
+    buffer[len] = '\0';
+    return len;
+}
+
+// Ajoute le nom après le préfixe du dossier (sans reformater tout le chemin).
+// Retourne la longueur du chemin complet (0 si trop long).
+static size_t path_append_name(char* buffer, size_t dir_len, const char* name) {
+    size_t name_len = strlen(name);
+    if (dir_len + name_len + 1 > MAX_PATH_LENGTH) {
+        return 0;
+    }
+    memcpy(buffer + dir_len, name, name_len + 1);
+    return dir_len + name_len;
+}
+
+// Transforme le chemin complet d'un sous-dossier en préfixe pour ses entrées
+static size_t path_push_directory(char* buffer, size_t path_len) {
+    if (path_len + 2 > MAX_PATH_LENGTH) {
+        return 0;
     }
+    buffer[path_len] = '/';
+    buffer[path_len + 1] = '\0';
+    return path_len + 1;
+}
+
+static bool is_dot_entry(const char* name) {
+    return name[0] == '.' && (name[1] == '\0' || (name[1] == '.' && name[2] == '\0'));
+}
+
+static void explore_directory_at(DIR* dir, char* path_buffer, size_t dir_len, FileList* list, int depth, bool show_hidden) {
+    int fd = dirfd(dir);
     
     struct dirent* entry;
     while ((entry = readdir(dir)) != NULL) {
         // Ignorer . et ..
-        if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0) {
+        if (is_dot_entry(entry->d_name)) {
             continue;
         }
         
@@ -188,72 +566,62 @@ bool explore_directory_shallow(const char* path, FileList* list, bool show_hidde
             continue;
         }
         
-        char full_path[MAX_PATH_LENGTH];
-        snprintf(full_path, sizeof(full_path), "%s/%s", path, entry->d_name);
+        size_t path_len = path_append_name(path_buffer, dir_len, entry->d_name);
+        if (path_len == 0) {
+            continue;
+        }
         
         struct stat st;
-        if (stat(full_path, &st) == -1) {
+        if (fstatat(fd, entry->d_name, &st, 0) == -1) {
             continue;
         }
         
-        FileEntry file_entry;
-        strncpy(file_entry.path, full_path, sizeof(file_entry.path) - 1);
-        file_entry.path[sizeof(file_entry.path) - 1] = '\0';
-        
-        strncpy(file_entry.name, entry->d_name, sizeof(file_entry.name) - 1);
-        file_entry.name[sizeof(file_entry.name) - 1] = '\0';
-        
-        file_entry.size = st.st_size;
-        file_entry.depth = 0;
-        
-        // Récupérer les métadonnées
-        get_file_metadata(full_path, &file_entry);
+        file_list_add(list, path_buffer, path_len, dir_len, &st, depth);
         
         if (S_ISDIR(st.st_mode)) {
-            file_entry.type = FILE_TYPE_DIRECTORY;
-        } else {
-            file_entry.type = FILE_TYPE_FILE;
+            // Exploration récursive
+            size_t sub_len = path_push_directory(path_buffer, path_len);
+            DIR* sub = sub_len ? open_directory_at(fd, entry->d_name) : NULL;
+            if (sub) {
+                explore_directory_at(sub, path_buffer, sub_len, list, depth + 1, show_hidden);
+                closedir(sub);
+            }
         }
-        
-        file_list_add(list, &file_entry);
     }
-    
-    closedir(dir);
-    return true;
 }
 
-bool search_files_recursive(const char* path, const char* search_term, FileList* list, int depth, bool show_hidden) {
-    // Limites de sécurité
-    if (depth > MAX_SEARCH_DEPTH) {
-        return true;  // Continuer mais ne pas descendre plus profond
+bool explore_directory(const char* path, FileList* list, int depth, bool show_hidden) {
+    DIR* dir = open_directory_at(AT_FDCWD, path);
+    if (!dir) {
+        fprintf(stderr, "Impossible d'ouvrir le répertoire: %s\n", path);
+        return false;
     }
     
-    if (list->count >= MAX_SEARCH_RESULTS) {
-        return false;  // Limite de résultats atteinte
+    char path_buffer[MAX_PATH_LENGTH];
+    size_t dir_len = path_set_directory(path_buffer, path);
+    if (dir_len > 0) {
+        explore_directory_at(dir, path_buffer, dir_len, list, depth, show_hidden);
     }
     
-    DIR* dir = opendir(path);
+    closedir(dir);
+    return true;
+}
+
+bool explore_directory_shallow(const char* path, FileList* list, bool show_hidden) {
+    DIR* dir = open_directory_at(AT_FDCWD, path);
     if (!dir) {
-        return true;  // Continuer même si on ne peut pas ouvrir ce dossier
+        fprintf(stderr, "Impossible d'ouvrir le répertoire: %s\n", path);
+        return false;
     }
     
-    // Convertir le terme de recherche en minuscules
-    char lower_search[256];
-    for (int i = 0; search_term[i] && i < 255; i++) {
-        lower_search[i] = tolower(search_term[i]);
-        lower_search[i + 1] = '\0';
-    }
+    char path_buffer[MAX_PATH_LENGTH];
+    size_t dir_len = path_set_directory(path_buffer, path);
+    int fd = dirfd(dir);
     
     struct dirent* entry;
-    while ((entry = readdir(dir)) != NULL) {
-        // Vérifier la limite de résultats
-        if (list->count >= MAX_SEARCH_RESULTS) {
-            closedir(dir);
-            return false;
-        }
-        
+    while (dir_len > 0 && (entry = readdir(dir)) != NULL) {
         // Ignorer . et ..
-        if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0) {
+        if (is_dot_entry(entry->d_name)) {
             continue;
         }
         
@@ -262,80 +630,594 @@ bool search_files_recursive(const char* path, const char* search_term, FileList*
             continue;
         }
         
-        // Vérifier si le dossier est dans la liste d'exclusion
-        bool excluded = false;
-        for (int i = 0; EXCLUDED_DIRS[i] != NULL; i++) {
-            if (strcmp(entry->d_name, EXCLUDED_DIRS[i]) == 0) {
-                excluded = true;
-                break;
-            }
-        }
-        if (excluded) {
+        size_t path_len = path_append_name(path_buffer, dir_len, entry->d_name);
+        if (path_len == 0) {
             continue;
         }
         
-        char full_path[MAX_PATH_LENGTH];
-        snprintf(full_path, sizeof(full_path), "%s/%s", path, entry->d_name);
-        
+        // Un seul stat par entrée, relatif au dossier ouvert
         struct stat st;
-        if (stat(full_path, &st) == -1) {
+        if (fstatat(fd, entry->d_name, &st, 0) == -1) {
             continue;
         }
         
-        // Vérifier si le nom correspond à la recherche
-        char lower_name[256];
-        for (int i = 0; entry->d_name[i] && i < 255; i++) {
-            lower_name[i] = tolower(entry->d_name[i]);
-            lower_name[i + 1] = '\0';
-        }
-        
-        bool matches = strstr(lower_name, lower_search) != NULL;
-        
-        if (matches) {
-            FileEntry file_entry;
-            strncpy(file_entry.path, full_path, sizeof(file_entry.path) - 1);
-            file_entry.path[sizeof(file_entry.path) - 1] = '\0';
-            
-            strncpy(file_entry.name, entry->d_name, sizeof(file_entry.name) - 1);
-            file_entry.name[sizeof(file_entry.name) - 1] = '\0';
-            
-            file_entry.size = st.st_size;
-            file_entry.depth = depth;
-            
-            // Récupérer les métadonnées
-            get_file_metadata(full_path, &file_entry);
-            
-            if (S_ISDIR(st.st_mode)) {
-                file_entry.type = FILE_TYPE_DIRECTORY;
-            } else {
-                file_entry.type = FILE_TYPE_FILE;
-            }
-            
-            file_list_add(list, &file_entry);
-        }
-        
-        // Continuer la recherche récursive dans les sous-dossiers
-        if (S_ISDIR(st.st_mode)) {
-            if (!search_files_recursive(full_path, search_term, list, depth + 1, show_hidden)) {
-                closedir(dir);
-                return false;  // Limite atteinte
-            }
-        }
+        file_list_add(list, path_buffer, path_len, dir_len, &st, 0);
     }
     
     closedir(dir);
     return true;
 }
 
-void file_list_clear(FileList* list) {
-    if (list) {
-        list->count = 0;
+// === Règles d'exclusion ===
+// Syntaxe .gitignore: noms, globs (*, ?, [...], **), "!motif" pour
+// réinclure, '/' final pour les dossiers seulement, '/' initial ou interne
+// pour un chemin relatif au dossier des règles. Dans un jeu, la dernière
+// règle qui correspond l'emporte. Les noms littéraux (cas courant, dont
+// EXCLUDED_DIRS) sont dans une table de hachage précédée d'un filtre sur la
+// longueur; les globs sont écartés par leur queue littérale avant d'être
+// évalués. Les .gitignore forment une chaîne de cadres: le dossier le plus
+// profond décide d'abord, les règles de l'utilisateur en dernier.
+
+typedef struct {
+    char* pattern;
+    uint64_t hash;              // Littéraux seulement
+    uint32_t length;
+    uint32_t suffix_length;     // Queue littérale d'un glob (rejet par memcmp)
+    int order;                  // Rang de la règle dans son jeu
+    bool negate;
+    bool dir_only;
+    bool anchored;              // Comparé au chemin relatif plutôt qu'au nom
+} ExcludeRule;
+
+typedef struct {
+    ExcludeRule* literals;      // Adressage ouvert (pattern NULL: libre)
+    int literal_capacity;       // Puissance de 2 (0: aucune table)
+    int literal_count;
+    uint64_t length_mask;       // Bit n: un littéral de n octets (63: 63 et plus)
+    ExcludeRule* globs;         // Par rang croissant
+    int glob_count;
+    int glob_capacity;
+    int rule_count;
+} ExcludeSet;
+
+struct ExcludeRules {
+    atomic_int refcount;
+    ExcludeSet set;
+    bool gitignore;             // Appliquer aussi les .gitignore rencontrés
+    bool shared;                // Confiées à une recherche: plus modifiables
+};
+
+// Règles applicables dans un dossier et ses descendants
+typedef struct ExcludeFrame {
+    atomic_int refcount;
+    struct ExcludeFrame* parent;    // Règles moins prioritaires (dossier englobant)
+    const ExcludeSet* set;
+    ExcludeSet own;                 // Règles d'un .gitignore
+    ExcludeRules* rules;            // Règles de l'utilisateur (cadre du bas)
+    size_t base_length;             // Préfixe du dossier des règles, '/' final compris
+    bool gitignore;
+} ExcludeFrame;
+
+#define EXCLUDE_GITIGNORE_MAX_SIZE (256 * 1024)  // Au-delà, le .gitignore est ignoré
+#define EXCLUDE_MAX_ANCESTORS 64                 // Dossiers remontés pour trouver le dépôt
+
+static uint64_t exclude_hash(const char* name, size_t length) {
+    uint64_t hash = 14695981039346656037ULL;
+    for (size_t i = 0; i < length; i++) {
+        hash ^= (unsigned char)name[i];
+        hash *= 1099511628211ULL;
     }
+    return hash;
 }
 
-static int compare_entries(const void* a, const void* b) {
-    const FileEntry* entry_a = (const FileEntry*)a;
-    const FileEntry* entry_b = (const FileEntry*)b;
+static void exclude_set_free(ExcludeSet* set) {
+    for (int i = 0; i < set->literal_capacity; i++) {
+        free(set->literals[i].pattern);
+    }
+    for (int i = 0; i < set->glob_count; i++) {
+        free(set->globs[i].pattern);
+    }
+    free(set->literals);
+    free(set->globs);
+    memset(set, 0, sizeof(*set));
+}
+
+static void exclude_set_insert_literal(ExcludeSet* set, const ExcludeRule* rule) {
+    int mask = set->literal_capacity - 1;
+    int slot = (int)(rule->hash & (uint64_t)mask);
+    while (set->literals[slot].pattern) {
+        slot = (slot + 1) & mask;
+    }
+    set->literals[slot] = *rule;
+}
+
+static bool exclude_set_add_literal(ExcludeSet* set, const ExcludeRule* rule) {
+    // Facteur de charge <= 1/2: les sondages restent courts
+    if ((set->literal_count + 1) * 2 > set->literal_capacity) {
+        int new_capacity = set->literal_capacity ? set->literal_capacity * 2 : 16;
+        ExcludeRule* new_literals = (ExcludeRule*)calloc(new_capacity, sizeof(ExcludeRule));
+        if (!new_literals) return false;
+        
+        ExcludeRule* old_literals = set->literals;
+        int old_capacity = set->literal_capacity;
+        set->literals = new_literals;
+        set->literal_capacity = new_capacity;
+        for (int i = 0; i < old_capacity; i++) {
+            if (old_literals[i].pattern) {
+                exclude_set_insert_literal(set, &old_literals[i]);
+            }
+        }
+        free(old_literals);
+    }
+    
+    exclude_set_insert_literal(set, rule);
+    set->literal_count++;
+    set->length_mask |= 1ULL << (rule->length < 63 ? rule->length : 63);
+    return true;
+}
+
+static bool exclude_set_add_glob(ExcludeSet* set, ExcludeRule* rule) {
+    if (set->glob_count == set->glob_capacity) {
+        int new_capacity = set->glob_capacity ? set->glob_capacity * 2 : 8;
+        ExcludeRule* new_globs = (ExcludeRule*)realloc(set->globs, sizeof(ExcludeRule) * new_capacity);
+        if (!new_globs) return false;
+        set->globs = new_globs;
+        set->glob_capacity = new_capacity;
+    }
+    
+    // Queue littérale: tout texte qui correspond doit finir par elle
+    uint32_t suffix = 0;
+    while (suffix < rule->length && !strchr("*?[]\\", rule->pattern[rule->length - 1 - suffix])) {
+        suffix++;
+    }
+    rule->suffix_length = suffix;
+    set->globs[set->glob_count++] = *rule;
+    return true;
+}
+
+// Compile une ligne de règle. Les lignes vides et commentaires sont
+// acceptées sans effet; false si la règle est invalide ou faute de mémoire.
+static bool exclude_set_add(ExcludeSet* set, const char* line, size_t length) {
+    // Espaces finaux ignorés, sauf échappés
+    while (length > 0 && (line[length - 1] == ' ' || line[length - 1] == '\t' || line[length - 1] == '\r') &&
+           !(length > 1 && line[length - 2] == '\\')) {
+        length--;
+    }
+    if (length == 0 || line[0] == '#') {
+        return true;
+    }
+    
+    ExcludeRule rule;
+    memset(&rule, 0, sizeof(rule));
+    if (line[0] == '!') {
+        rule.negate = true;
+        line++;
+        length--;
+    }
+    if (length > 0 && line[length - 1] == '/') {
+        rule.dir_only = true;
+        length--;
+    }
+    if (length > 0 && line[0] == '/') {
+        rule.anchored = true;
+        line++;
+        length--;
+    }
+    if (length == 0 || length > UINT16_MAX) {
+        return false;
+    }
+    
+    // Un '/' interne ancre aussi la règle au dossier des règles
+    if (memchr(line, '/', length)) {
+        rule.anchored = true;
+    }
+    bool glob = rule.anchored;
+    for (size_t i = 0; !glob && i < length; i++) {
+        glob = strchr("*?[\\", line[i]) != NULL;
+    }
+    
+    rule.pattern = (char*)malloc(length + 1);
+    if (!rule.pattern) return false;
+    memcpy(rule.pattern, line, length);
+    rule.pattern[length] = '\0';
+    rule.length = (uint32_t)length;
+    rule.order = set->rule_count;
+    
+    bool added;
+    if (glob) {
+        added = exclude_set_add_glob(set, &rule);
+    } else {
+        rule.hash = exclude_hash(rule.pattern, length);
+        added = exclude_set_add_literal(set, &rule);
+    }
+    if (!added) {
+        free(rule.pattern);
+        return false;
+    }
+    set->rule_count++;
+    return true;
+}
+
+// Compile chaque ligne d'un texte de règles
+static void exclude_set_add_lines(ExcludeSet* set, const char* text, size_t length) {
+    const char* end = text + length;
+    while (text < end) {
+        const char* newline = (const char*)memchr(text, '\n', (size_t)(end - text));
+        const char* line_end = newline ? newline : end;
+        exclude_set_add(set, text, (size_t)(line_end - text));
+        text = line_end + 1;
+    }
+}
+
+// Classe [...] à la position p (après le '['); *next reçoit la suite du motif.
+// Retourne -1 si la classe n'est pas fermée ('[' est alors un littéral).
+static int glob_match_class(const char* p, const char* pattern_end, char c, const char** next) {
+    bool negate = p < pattern_end && (*p == '!' || *p == '^');
+    if (negate) p++;
+    
+    bool matched = false;
+    bool first = true;
+    while (p < pattern_end && (*p != ']' || first)) {
+        first = false;
+        char low = *p;
+        if (low == '\\' && p + 1 < pattern_end) {
+            low = *++p;
+        }
+        char high = low;
+        if (p + 2 < pattern_end && p[1] == '-' && p[2] != ']') {
+            high = p[2];
+            p += 2;
+        }
+        if ((unsigned char)c >= (unsigned char)low && (unsigned char)c <= (unsigned char)high) {
+            matched = true;
+        }
+        p++;
+    }
+    if (p >= pattern_end) {
+        return -1;
+    }
+    *next = p + 1;
+    return matched != negate;
+}
+
+// Glob sur [text, text_end). En mode chemin, '*', '?' et les classes ne
+// traversent pas '/', "**/" correspond à zéro ou plusieurs dossiers et un
+// "**" final à tout le reste.
+static bool glob_match(const char* p, const char* pattern_end, const char* text, const char* text_end, bool pathname) {
+    while (p < pattern_end) {
+        if (*p == '*') {
+            bool globstar = pathname && p + 1 < pattern_end && p[1] == '*';
+            while (p < pattern_end && *p == '*') {
+                p++;
+            }
+            if (p == pattern_end) {
+                return globstar || !pathname || !memchr(text, '/', (size_t)(text_end - text));
+            }
+            if (globstar && *p == '/') {
+                // "**/": la suite au début du texte ou après n'importe quel '/'
+                p++;
+                for (const char* s = text; s; ) {
+                    if (glob_match(p, pattern_end, s, text_end, pathname)) return true;
+                    s = (const char*)memchr(s, '/', (size_t)(text_end - s));
+                    if (s) s++;
+                }
+                return false;
+            }
+            for (const char* s = text; ; s++) {
+                if (glob_match(p, pattern_end, s, text_end, pathname)) return true;
+                if (s == text_end || (pathname && !globstar && *s == '/')) return false;
+            }
+        }
+        
+        if (text == text_end) {
+            return false;
+        }
+        char c = *text;
+        if (*p == '?') {
+            if (pathname && c == '/') return false;
+            p++;
+            text++;
+            continue;
+        }
+        if (*p == '[') {
+            const char* next;
+            int matched = (pathname && c == '/') ? 0 : glob_match_class(p + 1, pattern_end, c, &next);
+            if (matched == 0) return false;
+            if (matched == 1) {
+                p = next;
+                text++;
+                continue;
+            }
+            // Classe non fermée: '[' littéral
+        } else if (*p == '\\' && p + 1 < pattern_end) {
+            p++;
+        }
+        if (*p != c) {
+            return false;
+        }
+        p++;
+        text++;
+    }
+    return text == text_end;
+}
+
+// Décision d'un jeu pour une entrée: 1 exclue, -1 réincluse, 0 aucune règle
+static int exclude_set_match(const ExcludeSet* set, const char* name, size_t name_length, const char* relative, size_t relative_length, bool is_dir) {
+    int best = -1;
+    bool negate = false;
+    
+    if (set->literal_count > 0 && ((set->length_mask >> (name_length < 63 ? name_length : 63)) & 1)) {
+        uint64_t hash = exclude_hash(name, name_length);
+        int mask = set->literal_capacity - 1;
+        for (int slot = (int)(hash & (uint64_t)mask); set->literals[slot].pattern; slot = (slot + 1) & mask) {
+            const ExcludeRule* rule = &set->literals[slot];
+            if (rule->hash == hash && rule->length == name_length && rule->order > best &&
+                (!rule->dir_only || is_dir) && memcmp(rule->pattern, name, name_length) == 0) {
+                best = rule->order;
+                negate = rule->negate;
+            }
+        }
+    }
+    
+    // Du dernier au premier: seul un glob plus récent que le littéral compte
+    for (int i = set->glob_count - 1; i >= 0 && set->globs[i].order > best; i--) {
+        const ExcludeRule* rule = &set->globs[i];
+        if (rule->dir_only && !is_dir) {
+            continue;
+        }
+        const char* text = rule->anchored ? relative : name;
+        size_t text_length = rule->anchored ? relative_length : name_length;
+        if (text_length < rule->suffix_length ||
+            memcmp(text + text_length - rule->suffix_length, rule->pattern + rule->length - rule->suffix_length, rule->suffix_length) != 0) {
+            continue;
+        }
+        if (glob_match(rule->pattern, rule->pattern + rule->length, text, text + text_length, rule->anchored)) {
+            best = rule->order;
+            negate = rule->negate;
+            break;
+        }
+    }
+    
+    if (best < 0) return 0;
+    return negate ? -1 : 1;
+}
+
+ExcludeRules* exclude_rules_create(void) {
+    ExcludeRules* rules = (ExcludeRules*)calloc(1, sizeof(ExcludeRules));
+    if (!rules) return NULL;
+    
+    atomic_init(&rules->refcount, 1);
+    for (int i = 0; EXCLUDED_DIRS[i] != NULL; i++) {
+        if (!exclude_set_add(&rules->set, EXCLUDED_DIRS[i], strlen(EXCLUDED_DIRS[i]))) {
+            exclude_rules_destroy(rules);
+            return NULL;
+        }
+    }
+    return rules;
+}
+
+ExcludeRules* exclude_rules_retain(ExcludeRules* rules) {
+    if (rules) {
+        atomic_fetch_add_explicit(&rules->refcount, 1, memory_order_relaxed);
+    }
+    return rules;
+}
+
+void exclude_rules_destroy(ExcludeRules* rules) {
+    if (rules && atomic_fetch_sub_explicit(&rules->refcount, 1, memory_order_acq_rel) == 1) {
+        exclude_set_free(&rules->set);
+        free(rules);
+    }
+}
+
+bool exclude_rules_add(ExcludeRules* rules, const char* pattern) {
+    if (!rules || !pattern || rules->shared) return false;
+    return exclude_set_add(&rules->set, pattern, strlen(pattern));
+}
+
+// Lit un fichier de règles (borné à EXCLUDE_GITIGNORE_MAX_SIZE); buffer à libérer
+static char* exclude_read_file(int dir_fd, const char* name, size_t* length) {
+    int fd = openat(dir_fd, name, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return NULL;
+    
+    struct stat st;
+    char* text = NULL;
+    if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0 && st.st_size <= EXCLUDE_GITIGNORE_MAX_SIZE) {
+        text = (char*)malloc((size_t)st.st_size);
+        ssize_t bytes = text ? read(fd, text, (size_t)st.st_size) : -1;
+        if (bytes <= 0) {
+            free(text);
+            text = NULL;
+        } else {
+            *length = (size_t)bytes;
+        }
+    }
+    close(fd);
+    return text;
+}
+
+bool exclude_rules_add_file(ExcludeRules* rules, const char* file_path) {
+    if (!rules || !file_path || rules->shared) return false;
+    
+    size_t length = 0;
+    char* text = exclude_read_file(AT_FDCWD, file_path, &length);
+    if (!text) return false;
+    exclude_set_add_lines(&rules->set, text, length);
+    free(text);
+    return true;
+}
+
+void exclude_rules_set_gitignore(ExcludeRules* rules, bool enabled) {
+    if (rules && !rules->shared) {
+        rules->gitignore = enabled;
+    }
+}
+
+bool exclude_rules_default_path(char* buffer, size_t size) {
+    const char* config_home = getenv("XDG_CONFIG_HOME");
+    int written;
+    if (config_home && config_home[0] == '/') {
+        written = snprintf(buffer, size, "%s/filex/exclude", config_home);
+    } else {
+        const char* home = getenv("HOME");
+        if (!home || home[0] == '\0') return false;
+        written = snprintf(buffer, size, "%s/.config/filex/exclude", home);
+    }
+    return written > 0 && (size_t)written < size;
+}
+
+// Règles des recherches sans règles configurées (EXCLUDED_DIRS)
+static ExcludeRules* default_exclude_rules;
+static pthread_once_t default_exclude_once = PTHREAD_ONCE_INIT;
+
+static void default_exclude_init(void) {
+    default_exclude_rules = exclude_rules_create();
+}
+
+static ExcludeFrame* exclude_frame_retain(ExcludeFrame* frame) {
+    if (frame) {
+        atomic_fetch_add_explicit(&frame->refcount, 1, memory_order_relaxed);
+    }
+    return frame;
+}
+
+static void exclude_frame_release(ExcludeFrame* frame) {
+    while (frame && atomic_fetch_sub_explicit(&frame->refcount, 1, memory_order_acq_rel) == 1) {
+        ExcludeFrame* parent = frame->parent;
+        exclude_set_free(&frame->own);
+        exclude_rules_destroy(frame->rules);
+        free(frame);
+        frame = parent;
+    }
+}
+
+// Cadre des règles du fichier name (relatif à dir_fd), au-dessus de parent.
+// NULL si le fichier est absent ou sans règle.
+static ExcludeFrame* exclude_frame_load(ExcludeFrame* parent, int dir_fd, const char* name, size_t base_length) {
+    size_t length = 0;
+    char* text = exclude_read_file(dir_fd, name, &length);
+    if (!text) return NULL;
+    
+    ExcludeFrame* frame = (ExcludeFrame*)calloc(1, sizeof(ExcludeFrame));
+    if (frame) {
+        exclude_set_add_lines(&frame->own, text, length);
+        if (frame->own.rule_count == 0) {
+            exclude_set_free(&frame->own);
+            free(frame);
+            frame = NULL;
+        }
+    }
+    free(text);
+    if (!frame) return NULL;
+    
+    atomic_init(&frame->refcount, 1);
+    frame->parent = exclude_frame_retain(parent);
+    frame->set = &frame->own;
+    frame->base_length = base_length;
+    frame->gitignore = parent->gitignore;
+    return frame;
+}
+
+// Cadre d'un dossier ouvert (dir_len: longueur de son préfixe): celui du
+// parent, ou un nouveau si le dossier a un .gitignore. Retourne une référence.
+static ExcludeFrame* exclude_frame_enter(ExcludeFrame* parent, int dir_fd, size_t dir_len) {
+    ExcludeFrame* frame = NULL;
+    if (parent && parent->gitignore && dir_len > 0) {
+        frame = exclude_frame_load(parent, dir_fd, ".gitignore", dir_len);
+    }
+    return frame ? frame : exclude_frame_retain(parent);
+}
+
+// Vrai si le dossier prefix (avec '/' final) est la racine d'un dépôt
+static bool exclude_is_repository(const char* prefix, size_t prefix_length) {
+    char path[MAX_PATH_LENGTH];
+    if (prefix_length + sizeof(".git") > sizeof(path)) return false;
+    memcpy(path, prefix, prefix_length);
+    memcpy(path + prefix_length, ".git", sizeof(".git"));
+    struct stat st;
+    return stat(path, &st) == 0;
+}
+
+// Cadre de la racine d'un parcours (root: préfixe avec '/' final): règles
+// de l'utilisateur (EXCLUDED_DIRS si NULL) puis, avec les .gitignore, ceux
+// des dossiers entre la racine du dépôt englobant et root (exclu: chargé à
+// son entrée comme tout dossier). Retourne une référence (NULL: aucune règle).
+static ExcludeFrame* exclude_frame_root(ExcludeRules* rules, const char* root, size_t root_len) {
+    if (!rules) {
+        pthread_once(&default_exclude_once, default_exclude_init);
+        rules = default_exclude_rules;
+        if (!rules) return NULL;
+    }
+    
+    ExcludeFrame* frame = (ExcludeFrame*)calloc(1, sizeof(ExcludeFrame));
+    if (!frame) return NULL;
+    atomic_init(&frame->refcount, 1);
+    frame->rules = exclude_rules_retain(rules);
+    frame->set = &rules->set;
+    frame->base_length = root_len;
+    frame->gitignore = rules->gitignore;
+    
+    if (!rules->gitignore || root[0] != '/' || exclude_is_repository(root, root_len)) {
+        return frame;
+    }
+    
+    // Remonter jusqu'au dossier qui contient .git
+    size_t prefixes[EXCLUDE_MAX_ANCESTORS];
+    int count = 0;
+    bool found = false;
+    size_t length = root_len - 1;
+    while (!found && length > 0 && count < EXCLUDE_MAX_ANCESTORS) {
+        while (length > 0 && root[length - 1] != '/') {
+            length--;
+        }
+        if (length == 0) break;
+        prefixes[count++] = length;
+        found = exclude_is_repository(root, length);
+        length--;
+    }
+    
+    // Du plus englobant au plus proche: le plus proche est le plus prioritaire
+    for (int i = count - 1; found && i >= 0; i--) {
+        char path[MAX_PATH_LENGTH];
+        if (prefixes[i] + sizeof(".gitignore") > sizeof(path)) continue;
+        memcpy(path, root, prefixes[i]);
+        memcpy(path + prefixes[i], ".gitignore", sizeof(".gitignore"));
+        ExcludeFrame* ancestor = exclude_frame_load(frame, AT_FDCWD, path, prefixes[i]);
+        if (ancestor) {
+            exclude_frame_release(frame);
+            frame = ancestor;
+        }
+    }
+    return frame;
+}
+
+// Vrai si l'entrée path (nom à partir de name_offset) est exclue
+static bool exclude_frame_match(const ExcludeFrame* frame, const char* path, size_t path_length, size_t name_offset, bool is_dir) {
+    for (; frame; frame = frame->parent) {
+        if (frame->set->rule_count == 0 || path_length <= frame->base_length) {
+            continue;
+        }
+        int decision = exclude_set_match(frame->set, path + name_offset, path_length - name_offset,
+                                         path + frame->base_length, path_length - frame->base_length, is_dir);
+        if (decision != 0) {
+            return decision > 0;
+        }
+    }
+    return false;
+}
+
+void file_list_clear(FileList* list) {
+    if (list) {
+        file_list_release_storage(list);
+    }
+}
+
+// Liste en cours de tri (qsort ne transmet pas de contexte au comparateur)
+static _Thread_local const FileList* sort_list = NULL;
+
+static int compare_entries(const void* a, const void* b) {
+    const FileEntry* entry_a = (const FileEntry*)a;
+    const FileEntry* entry_b = (const FileEntry*)b;
     
     // Les dossiers en premier
     if (entry_a->type != entry_b->type) {
@@ -348,13 +1230,61 @@ static int compare_entries(const void* a, const void* b) {
     }
     
     // Enfin par nom
-    return strcmp(entry_a->name, entry_b->name);
+    return strcmp(file_entry_name(sort_list, entry_a), file_entry_name(sort_list, entry_b));
 }
 
-void file_list_sort(FileList* list) {
-    if (list && list->entries && list->count > 0) {
-        qsort(list->entries, list->count, sizeof(FileEntry), compare_entries);
+// Ordre d'une recherche approximative: meilleur score d'abord, puis le nom le
+// plus court (la requête en couvre une plus grande part), puis par nom
+static int compare_ranked_entries(const FileEntry* entry_a, const char* name_a, const FileEntry* entry_b, const char* name_b) {
+    if (entry_a->score != entry_b->score) {
+        return entry_a->score > entry_b->score ? -1 : 1;
+    }
+    
+    size_t length_a = entry_a->path_length - entry_a->name_offset;
+    size_t length_b = entry_b->path_length - entry_b->name_offset;
+    if (length_a != length_b) {
+        return length_a < length_b ? -1 : 1;
+    }
+    
+    return strcmp(name_a, name_b);
+}
+
+static int compare_entries_by_score(const void* a, const void* b) {
+    const FileEntry* entry_a = (const FileEntry*)a;
+    const FileEntry* entry_b = (const FileEntry*)b;
+    return compare_ranked_entries(entry_a, file_entry_name(sort_list, entry_a), entry_b, file_entry_name(sort_list, entry_b));
+}
+
+static void file_list_sort_with(FileList* list, int (*compare)(const void*, const void*)) {
+    if (!list || list->count <= 1) return;
+    
+    // qsort a besoin d'un tableau contigu: rassembler, trier, redistribuer
+    FileEntry* sorted = (FileEntry*)malloc(sizeof(FileEntry) * list->count);
+    if (!sorted) return;
+    
+    for (int i = 0; i < list->count; i += FILE_LIST_CHUNK_ENTRIES) {
+        int n = list->count - i < FILE_LIST_CHUNK_ENTRIES ? list->count - i : FILE_LIST_CHUNK_ENTRIES;
+        memcpy(sorted + i, list->chunks[i / FILE_LIST_CHUNK_ENTRIES], sizeof(FileEntry) * n);
+    }
+    
+    sort_list = list;
+    qsort(sorted, list->count, sizeof(FileEntry), compare);
+    sort_list = NULL;
+    
+    for (int i = 0; i < list->count; i += FILE_LIST_CHUNK_ENTRIES) {
+        int n = list->count - i < FILE_LIST_CHUNK_ENTRIES ? list->count - i : FILE_LIST_CHUNK_ENTRIES;
+        memcpy(list->chunks[i / FILE_LIST_CHUNK_ENTRIES], sorted + i, sizeof(FileEntry) * n);
     }
+    
+    free(sorted);
+}
+
+void file_list_sort(FileList* list) {
+    file_list_sort_with(list, compare_entries);
+}
+
+void file_list_sort_by_score(FileList* list) {
+    file_list_sort_with(list, compare_entries_by_score);
 }
 
 static bool is_valid_name(const char* name) {
@@ -401,644 +1331,6735 @@ bool create_file(const char* parent_path, const char* name) {
 }
 
 // === Gestion du cache ===
+// Table de hachage (chaînage) + liste LRU intrusive, bornées par un budget en
+// octets: on évince depuis la queue de la LRU jusqu'à repasser sous le budget.
+#ifdef __linux__
+static void cache_watch_start(DirectoryCache* cache);
+static void cache_watch_stop(DirectoryCache* cache);
+#endif
+
+// FNV-1a sur le chemin, show_hidden mélangé au résultat
+static uint64_t cache_hash(const char* path, bool show_hidden) {
+    uint64_t hash = 14695981039346656037ULL;
+    for (const unsigned char* p = (const unsigned char*)path; *p; p++) {
+        hash ^= *p;
+        hash *= 1099511628211ULL;
+    }
+    hash ^= show_hidden ? 0x9e3779b97f4a7c15ULL : 0;
+    return hash;
+}
+
+// Coût d'une entrée: l'entrée elle-même, la mémoire de son listing et le
+// hachage de ses noms
+static size_t cache_entry_bytes(const CacheEntry* entry) {
+    return sizeof(CacheEntry) + strlen(entry->path) + 1 + sizeof(FileList) +
+           entry->files->memory_used + sizeof(int) * (size_t)entry->name_capacity;
+}
+
 DirectoryCache* cache_create(void) {
     DirectoryCache* cache = (DirectoryCache*)malloc(sizeof(DirectoryCache));
     if (!cache) return NULL;
     
-    cache->count = 0;
-    for (int i = 0; i < MAX_CACHE_ENTRIES; i++) {
-        cache->entries[i].path[0] = '\0';
-        cache->entries[i].files = NULL;
-        cache->entries[i].last_access = 0;
-        cache->entries[i].show_hidden = false;
+    cache->buckets = (CacheEntry**)calloc(CACHE_INITIAL_BUCKETS, sizeof(CacheEntry*));
+    if (!cache->buckets) {
+        free(cache);
+        return NULL;
+    }
+    
+    if (pthread_mutex_init(&cache->mutex, NULL) != 0) {
+        free(cache->buckets);
+        free(cache);
+        return NULL;
     }
     
+    cache->bucket_count = CACHE_INITIAL_BUCKETS;
+    cache->count = 0;
+    cache->lru_head = NULL;
+    cache->lru_tail = NULL;
+    cache->memory_used = 0;
+    cache->memory_budget = CACHE_DEFAULT_BUDGET;
+    cache->hits = 0;
+    cache->misses = 0;
+    cache->evictions = 0;
+    cache->next_version = 1;
+    cache->watching = false;
+    cache->inotify_fd = -1;
+    cache->stop_pipe[0] = -1;
+    cache->stop_pipe[1] = -1;
+    cache->change_callback = NULL;
+    cache->change_user_data = NULL;
+    
+#ifdef __linux__
+    cache_watch_start(cache);
+#endif
+    
     return cache;
 }
 
 void cache_destroy(DirectoryCache* cache) {
     if (!cache) return;
     
-    for (int i = 0; i < cache->count; i++) {
-        if (cache->entries[i].files) {
-            file_list_destroy(cache->entries[i].files);
-        }
+#ifdef __linux__
+    cache_watch_stop(cache);
+#endif
+    
+    CacheEntry* entry = cache->lru_head;
+    while (entry) {
+        CacheEntry* next = entry->lru_next;
+        file_list_destroy(entry->files);
+        free(entry->name_slots);
+        free(entry);
+        entry = next;
     }
     
+    free(cache->buckets);
+    pthread_mutex_destroy(&cache->mutex);
     free(cache);
 }
 
-FileList* cache_get(DirectoryCache* cache, const char* path, bool show_hidden) {
-    if (!cache || !path) return NULL;
+void cache_set_change_callback(DirectoryCache* cache, void (*callback)(void* user_data), void* user_data) {
+    if (!cache) return;
+    
+    pthread_mutex_lock(&cache->mutex);
+    cache->change_callback = callback;
+    cache->change_user_data = user_data;
+    pthread_mutex_unlock(&cache->mutex);
+}
+
+void cache_get_stats(DirectoryCache* cache, CacheStats* stats) {
+    if (!cache || !stats) return;
+    
+    pthread_mutex_lock(&cache->mutex);
+    stats->hits = cache->hits;
+    stats->misses = cache->misses;
+    stats->evictions = cache->evictions;
+    stats->count = cache->count;
+    stats->memory_used = cache->memory_used;
+    stats->memory_budget = cache->memory_budget;
+    pthread_mutex_unlock(&cache->mutex);
+}
+
+// Recherche une entrée (appelant: mutex du cache verrouillé)
+static CacheEntry* cache_find(DirectoryCache* cache, const char* path, bool show_hidden) {
+    uint64_t hash = cache_hash(path, show_hidden);
+    CacheEntry* entry = cache->buckets[hash & (uint64_t)(cache->bucket_count - 1)];
     
-    for (int i = 0; i < cache->count; i++) {
-        if (strcmp(cache->entries[i].path, path) == 0 && 
-            cache->entries[i].show_hidden == show_hidden) {
-            // Mettre à jour l'heure d'accès
-            cache->entries[i].last_access = time(NULL);
-            return cache->entries[i].files;
+    for (; entry; entry = entry->hash_next) {
+        if (entry->hash == hash && entry->show_hidden == show_hidden &&
+            strcmp(entry->path, path) == 0) {
+            return entry;
         }
     }
-    
     return NULL;
 }
 
-void cache_put(DirectoryCache* cache, const char* path, FileList* files, bool show_hidden) {
-    if (!cache || !path || !files) return;
+// Place l'entrée en tête de la LRU (entrée hors liste)
+static void cache_lru_push_front(DirectoryCache* cache, CacheEntry* entry) {
+    entry->lru_prev = NULL;
+    entry->lru_next = cache->lru_head;
+    if (cache->lru_head) {
+        cache->lru_head->lru_prev = entry;
+    } else {
+        cache->lru_tail = entry;
+    }
+    cache->lru_head = entry;
+}
+
+static void cache_lru_unlink(DirectoryCache* cache, CacheEntry* entry) {
+    if (entry->lru_prev) {
+        entry->lru_prev->lru_next = entry->lru_next;
+    } else {
+        cache->lru_head = entry->lru_next;
+    }
+    if (entry->lru_next) {
+        entry->lru_next->lru_prev = entry->lru_prev;
+    } else {
+        cache->lru_tail = entry->lru_prev;
+    }
+}
+
+// Double la table de hachage quand elle est trop chargée
+static void cache_grow_buckets(DirectoryCache* cache) {
+    int bucket_count = cache->bucket_count * 2;
+    CacheEntry** buckets = (CacheEntry**)calloc((size_t)bucket_count, sizeof(CacheEntry*));
+    if (!buckets) return;  // Chaînes plus longues, mais toujours correctes
     
-    // Vérifier si déjà dans le cache
-    for (int i = 0; i < cache->count; i++) {
-        if (strcmp(cache->entries[i].path, path) == 0 && 
-            cache->entries[i].show_hidden == show_hidden) {
-            // Mettre à jour l'entrée existante
-            if (cache->entries[i].files) {
-                file_list_destroy(cache->entries[i].files);
-            }
-            cache->entries[i].files = files;
-            cache->entries[i].last_access = time(NULL);
-            return;
+    for (int i = 0; i < cache->bucket_count; i++) {
+        CacheEntry* entry = cache->buckets[i];
+        while (entry) {
+            CacheEntry* next = entry->hash_next;
+            CacheEntry** slot = &buckets[entry->hash & (uint64_t)(bucket_count - 1)];
+            entry->hash_next = *slot;
+            *slot = entry;
+            entry = next;
         }
     }
     
-    // Ajouter une nouvelle entrée
-    int index = -1;
+    free(cache->buckets);
+    cache->buckets = buckets;
+    cache->bucket_count = bucket_count;
+}
+
+// Arrête la surveillance d'un dossier si plus aucune entrée ne l'utilise
+static void cache_release_watch(DirectoryCache* cache, int watch_descriptor) {
+#ifdef __linux__
+    if (watch_descriptor < 0 || cache->inotify_fd < 0) return;
     
-    if (cache->count < MAX_CACHE_ENTRIES) {
-        // Il y a de la place
-        index = cache->count++;
-    } else {
-        // Cache plein, trouver la plus ancienne entrée
-        time_t oldest_time = cache->entries[0].last_access;
-        index = 0;
-        
-        for (int i = 1; i < MAX_CACHE_ENTRIES; i++) {
-            if (cache->entries[i].last_access < oldest_time) {
-                oldest_time = cache->entries[i].last_access;
-                index = i;
-            }
-        }
-        
-        // Libérer l'ancienne entrée
-        if (cache->entries[index].files) {
-            file_list_destroy(cache->entries[index].files);
+    for (CacheEntry* entry = cache->lru_head; entry; entry = entry->lru_next) {
+        if (entry->watch_descriptor == watch_descriptor) {
+            return;
         }
     }
-    
-    // Ajouter la nouvelle entrée
-    strncpy(cache->entries[index].path, path, MAX_PATH_LENGTH - 1);
-    cache->entries[index].path[MAX_PATH_LENGTH - 1] = '\0';
-    cache->entries[index].files = files;
-    cache->entries[index].last_access = time(NULL);
-    cache->entries[index].show_hidden = show_hidden;
+    inotify_rm_watch(cache->inotify_fd, watch_descriptor);
+#else
+    (void)cache;
+    (void)watch_descriptor;
+#endif
 }
 
-// === Recherche par contenu ===
-bool search_in_file_content(const char* file_path, const char* search_term) {
-    if (!file_path || !search_term) return false;
+// Retire et libère une entrée (appelant: mutex du cache verrouillé)
+static void cache_remove(DirectoryCache* cache, CacheEntry* entry, bool release_watch) {
+    CacheEntry** slot = &cache->buckets[entry->hash & (uint64_t)(cache->bucket_count - 1)];
+    while (*slot != entry) {
+        slot = &(*slot)->hash_next;
+    }
+    *slot = entry->hash_next;
     
-    FILE* file = fopen(file_path, "rb");
-    if (!file) return false;
+    cache_lru_unlink(cache, entry);
+    cache->count--;
+    cache->memory_used -= entry->bytes;
     
-    // Vérifier la taille du fichier
-    fseek(file, 0, SEEK_END);
-    long file_size = ftell(file);
-    fseek(file, 0, SEEK_SET);
+    int watch_descriptor = entry->watch_descriptor;
+    file_list_destroy(entry->files);
+    free(entry->name_slots);
+    free(entry);
     
-    // Ignorer les fichiers trop gros
-    if (file_size > MAX_CACHE_FILE_SIZE || file_size <= 0) {
-        fclose(file);
-        return false;
+    if (release_watch) {
+        cache_release_watch(cache, watch_descriptor);
     }
-    
-    // Lire le contenu
-    char* content = (char*)malloc(file_size + 1);
-    if (!content) {
-        fclose(file);
-        return false;
+}
+
+// Évince les entrées les moins récemment utilisées jusqu'à respecter le budget
+static void cache_enforce_budget(DirectoryCache* cache, size_t incoming) {
+    while (cache->lru_tail && cache->memory_used + incoming > cache->memory_budget) {
+        cache_remove(cache, cache->lru_tail, true);
+        cache->evictions++;
     }
+}
+
+void cache_set_budget(DirectoryCache* cache, size_t memory_budget) {
+    if (!cache) return;
+    
+    pthread_mutex_lock(&cache->mutex);
+    cache->memory_budget = memory_budget ? memory_budget : CACHE_DEFAULT_BUDGET;
+    cache_enforce_budget(cache, 0);
+    pthread_mutex_unlock(&cache->mutex);
+}
+
+unsigned long cache_get(DirectoryCache* cache, const char* path, bool show_hidden, FileList** snapshot) {
+    if (!cache || !path || !snapshot) return 0;
     
-    size_t bytes_read = fread(content, 1, file_size, file);
-    content[bytes_read] = '\0';
-    fclose(file);
+    pthread_mutex_lock(&cache->mutex);
     
-    // Vérifier si c'est du texte (pas binaire)
-    bool is_binary = false;
-    long check_size = bytes_read < 512 ? bytes_read : 512;
-    for (long i = 0; i < check_size; i++) {
-        unsigned char c = (unsigned char)content[i];
-        if (c < 32 && c != '\n' && c != '\r' && c != '\t') {
-            is_binary = true;
-            break;
-        }
-        if (c == 0) {
-            is_binary = true;
-            break;
-        }
+    unsigned long version = 0;
+    CacheEntry* entry = cache_find(cache, path, show_hidden);
+    if (entry) {
+        // Devient l'entrée la plus récemment utilisée
+        cache_lru_unlink(cache, entry);
+        cache_lru_push_front(cache, entry);
+        *snapshot = file_list_retain(entry->files);
+        version = entry->version;
+        cache->hits++;
+    } else {
+        cache->misses++;
     }
     
-    if (is_binary) {
-        free(content);
-        return false;
+    pthread_mutex_unlock(&cache->mutex);
+    return version;
+}
+
+unsigned long cache_get_version(DirectoryCache* cache, const char* path, bool show_hidden) {
+    if (!cache || !path) return 0;
+    
+    pthread_mutex_lock(&cache->mutex);
+    CacheEntry* entry = cache_find(cache, path, show_hidden);
+    unsigned long version = entry ? entry->version : 0;
+    pthread_mutex_unlock(&cache->mutex);
+    
+    return version;
+}
+
+unsigned long cache_put(DirectoryCache* cache, const char* path, FileList* files, bool show_hidden) {
+    if (!cache || !path || !files) return 0;
+    
+    pthread_mutex_lock(&cache->mutex);
+    
+    // Vérifier si déjà dans le cache
+    CacheEntry* existing = cache_find(cache, path, show_hidden);
+    if (existing) {
+        // Remplacer le listing (la surveillance est conservée)
+        file_list_destroy(existing->files);
+        existing->files = file_list_retain(files);
+        free(existing->name_slots);
+        existing->name_slots = NULL;
+        existing->name_capacity = 0;
+        existing->dead_bytes = 0;
+        cache->memory_used -= existing->bytes;
+        existing->bytes = cache_entry_bytes(existing);
+        cache->memory_used += existing->bytes;
+        existing->version = cache->next_version++;
+        cache_lru_unlink(cache, existing);
+        cache_lru_push_front(cache, existing);
+        
+        // Évincer les autres entrées si besoin (jamais celle-ci, en tête)
+        unsigned long version = existing->version;
+        if (existing->bytes > cache->memory_budget) {
+            cache_remove(cache, existing, true);
+            version = 0;
+        } else {
+            cache_enforce_budget(cache, 0);
+        }
+        pthread_mutex_unlock(&cache->mutex);
+        return version;
     }
     
-    // Convertir en minuscules pour recherche insensible à la casse
-    char lower_search[256];
-    for (int i = 0; search_term[i] && i < 255; i++) {
-        lower_search[i] = tolower(search_term[i]);
-        lower_search[i + 1] = '\0';
+    size_t path_length = strlen(path);
+    CacheEntry* entry = (path_length < MAX_PATH_LENGTH)
+        ? (CacheEntry*)malloc(sizeof(CacheEntry) + path_length + 1) : NULL;
+    if (!entry) {
+        pthread_mutex_unlock(&cache->mutex);
+        return 0;
     }
     
-    // Rechercher dans le contenu
-    bool found = false;
-    for (size_t i = 0; i < bytes_read; i++) {
-        char lower_c = tolower(content[i]);
-        if (lower_c == lower_search[0]) {
-            // Début potentiel de correspondance
-            bool match = true;
-            for (size_t j = 1; lower_search[j] != '\0' && (i + j) < bytes_read; j++) {
-                if (tolower(content[i + j]) != lower_search[j]) {
-                    match = false;
-                    break;
-                }
-            }
-            if (match && lower_search[1] == '\0') {
-                found = true;
-                break;
-            }
-            if (match) {
-                // Vérifier qu'on a la chaîne complète
-                size_t search_len = strlen(lower_search);
-                if (i + search_len <= bytes_read) {
-                    found = true;
-                    break;
-                }
-            }
+    memcpy(entry->path, path, path_length + 1);
+    entry->files = files;
+    entry->show_hidden = show_hidden;
+    entry->watch_descriptor = -1;
+    entry->name_slots = NULL;
+    entry->name_capacity = 0;
+    entry->dead_bytes = 0;
+    entry->hash = cache_hash(path, show_hidden);
+    entry->bytes = cache_entry_bytes(entry);
+    
+    // Un listing plus gros que tout le budget n'est pas mis en cache
+    if (entry->bytes > cache->memory_budget) {
+        pthread_mutex_unlock(&cache->mutex);
+        free(entry);
+        return 0;
+    }
+    
+    cache_enforce_budget(cache, entry->bytes);
+    file_list_retain(files);
+    
+    if (cache->count >= cache->bucket_count) {
+        cache_grow_buckets(cache);
+    }
+    
+    CacheEntry** slot = &cache->buckets[entry->hash & (uint64_t)(cache->bucket_count - 1)];
+    entry->hash_next = *slot;
+    *slot = entry;
+    cache_lru_push_front(cache, entry);
+    cache->count++;
+    cache->memory_used += entry->bytes;
+    entry->version = cache->next_version++;
+    
+#ifdef __linux__
+    // Surveiller le dossier pour garder le listing à jour
+    if (cache->inotify_fd >= 0) {
+        entry->watch_descriptor = inotify_add_watch(cache->inotify_fd, path,
+            IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_ATTRIB | IN_CLOSE_WRITE |
+            IN_DELETE_SELF | IN_MOVE_SELF | IN_ONLYDIR);
+    }
+#endif
+    
+    unsigned long version = entry->version;
+    pthread_mutex_unlock(&cache->mutex);
+    return version;
+}
+
+void cache_invalidate(DirectoryCache* cache, const char* path) {
+    if (!cache || !path) return;
+    
+    pthread_mutex_lock(&cache->mutex);
+    for (int hidden = 0; hidden < 2; hidden++) {
+        CacheEntry* entry = cache_find(cache, path, hidden != 0);
+        if (entry) {
+            cache_remove(cache, entry, true);
         }
     }
+    pthread_mutex_unlock(&cache->mutex);
+}
+
+#ifdef __linux__
+// === Surveillance inotify du cache ===
+// Un thread lit les événements inotify des dossiers en cache et corrige les
+// listings sur place (ajout, suppression, mise à jour des métadonnées), sans
+// rescanner le dossier. Les listings modifiés changent de version, ce qui
+// permet à la vue courante de se rafraîchir depuis le cache.
+// Un lot ne retient que le dernier événement de chaque nom (un fichier écrit
+// plusieurs fois n'est examiné qu'une fois); les stat sont faits hors du
+// verrou du cache. Chaque listing garde un hachage de ses noms, et une
+// entrée ajoutée est insérée à sa place dans l'ordre de file_list_sort.
+// Un listing partagé avec la vue, ou touché par beaucoup de changements,
+// est reconstruit en une copie qui fusionne les changements et compacte
+// son arène.
+
+// Dernier événement d'un nom dans un lot
+typedef struct {
+    int wd;
+    uint32_t mask;
+    int sequence;               // Ordre d'arrivée dans le lot
+    const char* name;           // Dans le tampon des événements
+    char* path;                 // Chemin à examiner (NULL: retrait, ou dossier plus en cache)
+    size_t name_offset;         // Début du nom dans path
+    bool exists;                // stat réussi: st décrit l'entrée (sans path: état
+                                // inconnu, l'entrée reste telle quelle)
+    struct stat st;
+} CacheChange;
+
+static int compare_cache_changes(const void* a, const void* b) {
+    const CacheChange* change_a = (const CacheChange*)a;
+    const CacheChange* change_b = (const CacheChange*)b;
+    if (change_a->wd != change_b->wd) {
+        return change_a->wd < change_b->wd ? -1 : 1;
+    }
+    int order = strcmp(change_a->name, change_b->name);
+    if (order != 0) return order;
+    return change_a->sequence - change_b->sequence;
+}
+
+// Ordre de file_list_sort dans un listing (toutes les entrées à profondeur 0)
+static int compare_listing_names(bool is_dir_a, const char* name_a, bool is_dir_b, const char* name_b) {
+    if (is_dir_a != is_dir_b) {
+        return is_dir_a ? -1 : 1;
+    }
+    return strcmp(name_a, name_b);
+}
+
+static int compare_added_changes(const void* a, const void* b) {
+    const CacheChange* change_a = *(const CacheChange* const*)a;
+    const CacheChange* change_b = *(const CacheChange* const*)b;
+    return compare_listing_names(S_ISDIR(change_a->st.st_mode), change_a->name,
+                                 S_ISDIR(change_b->st.st_mode), change_b->name);
+}
+
+// Ajoute l'entrée d'indice index au hachage des noms
+static void cache_names_insert(CacheEntry* cached, const char* name, int index) {
+    int mask = cached->name_capacity - 1;
+    int slot = (int)(cache_hash(name, false) & (uint64_t)mask);
+    while (cached->name_slots[slot] != 0) {
+        slot = (slot + 1) & mask;
+    }
+    cached->name_slots[slot] = index + 1;
+}
+
+// Construit le hachage des noms du listing s'il manque ou s'il est trop
+// chargé; false si la mémoire manque
+static bool cache_names_build(CacheEntry* cached) {
+    const FileList* list = cached->files;
+    if (cached->name_slots && list->count * 2 <= cached->name_capacity) return true;
     
-    free(content);
-    return found;
+    int capacity = 16;
+    while (capacity < list->count * 2) {
+        capacity *= 2;
+    }
+    int* slots = (int*)calloc((size_t)capacity, sizeof(int));
+    if (!slots) return false;
+    
+    free(cached->name_slots);
+    cached->name_slots = slots;
+    cached->name_capacity = capacity;
+    for (int i = 0; i < list->count; i++) {
+        cache_names_insert(cached, file_entry_name(list, file_list_get(list, i)), i);
+    }
+    return true;
 }
 
-bool search_files_by_content(const char* path, const char* search_term, FileList* list, int depth, bool show_hidden) {
-    // Limites de sécurité
-    if (depth > MAX_SEARCH_DEPTH) {
-        return true;
+// Case du hachage qui désigne name (-1: absent du listing)
+static int cache_names_find(const CacheEntry* cached, const char* name) {
+    const FileList* list = cached->files;
+    int mask = cached->name_capacity - 1;
+    for (int slot = (int)(cache_hash(name, false) & (uint64_t)mask); cached->name_slots[slot] != 0; slot = (slot + 1) & mask) {
+        const FileEntry* entry = file_list_get(list, cached->name_slots[slot] - 1);
+        if (strcmp(file_entry_name(list, entry), name) == 0) {
+            return slot;
+        }
+    }
+    return -1;
+}
+
+// Vide la case slot: les cases suivantes de la même séquence reculent pour
+// que les recherches ne s'arrêtent pas sur le trou
+static void cache_names_erase(CacheEntry* cached, int slot) {
+    const FileList* list = cached->files;
+    int mask = cached->name_capacity - 1;
+    int hole = slot;
+    for (int next = (hole + 1) & mask; cached->name_slots[next] != 0; next = (next + 1) & mask) {
+        const FileEntry* entry = file_list_get(list, cached->name_slots[next] - 1);
+        int home = (int)(cache_hash(file_entry_name(list, entry), false) & (uint64_t)mask);
+        if (((next - home) & mask) >= ((next - hole) & mask)) {
+            cached->name_slots[hole] = cached->name_slots[next];
+            hole = next;
+        }
+    }
+    cached->name_slots[hole] = 0;
+}
+
+// Décale de delta les indices à partir de from (entrées déplacées)
+static void cache_names_shift(CacheEntry* cached, int from, int delta) {
+    for (int slot = 0; slot < cached->name_capacity; slot++) {
+        if (cached->name_slots[slot] > from) {
+            cached->name_slots[slot] += delta;
+        }
+    }
+}
+
+// L'entrée décrit-elle déjà ce stat?
+static bool cache_entry_matches(const FileEntry* entry, const struct stat* st) {
+    return entry->size == st->st_size && entry->mod_time == st->st_mtime && entry->permissions == st->st_mode &&
+           entry->owner_uid == st->st_uid && entry->owner_gid == st->st_gid;
+}
+
+// Retire du listing (non partagé) l'entrée index désignée par la case slot
+static void cache_listing_remove(CacheEntry* cached, int slot, int index) {
+    cache_names_erase(cached, slot);
+    cached->dead_bytes += file_list_get(cached->files, index)->path_length + 1u;
+    file_list_remove(cached->files, index);
+    cache_names_shift(cached, index + 1, -1);
+}
+
+// Insère l'entrée de change à sa place dans le listing (non partagé)
+static bool cache_listing_insert(CacheEntry* cached, const CacheChange* change) {
+    FileList* list = cached->files;
+    bool is_dir = S_ISDIR(change->st.st_mode);
+    int low = 0;
+    int high = list->count;
+    while (low < high) {
+        int mid = low + (high - low) / 2;
+        const FileEntry* entry = file_list_get(list, mid);
+        if (compare_listing_names(entry->type == FILE_TYPE_DIRECTORY, file_entry_name(list, entry), is_dir, change->name) < 0) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
     }
     
-    if (list->count >= MAX_SEARCH_RESULTS) {
+    if (!file_list_add(list, change->path, strlen(change->path), change->name_offset, &change->st, 0)) {
         return false;
     }
+    FileEntry added = *file_list_get(list, list->count - 1);
+    for (int i = list->count - 1; i > low; i--) {
+        *file_list_get(list, i) = *file_list_get(list, i - 1);
+    }
+    *file_list_get(list, low) = added;
     
-    DIR* dir = opendir(path);
-    if (!dir) {
-        return true;
+    cache_names_shift(cached, low, 1);
+    if (list->count * 2 > cached->name_capacity) {
+        free(cached->name_slots);
+        cached->name_slots = NULL;
+        cached->name_capacity = 0;
+        return cache_names_build(cached);
     }
+    cache_names_insert(cached, change->name, low);
+    return true;
+}
+
+// Nouveau listing: celui de cached sans les entrées marquées dans dropped,
+// avec added (triés) fusionnés à leur place. Une seule copie, compacte: le
+// listing partagé avec la vue reste intact.
+static bool cache_listing_rebuild(CacheEntry* cached, const uint64_t* dropped, CacheChange** added, int added_count) {
+    FileList* old = cached->files;
+    FileList* list = file_list_create();
+    if (!list) return false;
+    list->memory_budget = old->memory_budget;
     
-    struct dirent* entry;
-    while ((entry = readdir(dir)) != NULL) {
-        if (list->count >= MAX_SEARCH_RESULTS) {
-            closedir(dir);
+    int i = 0;
+    int k = 0;
+    while (i < old->count || k < added_count) {
+        if (i < old->count && dropped && (dropped[i >> 6] >> (i & 63)) & 1) {
+            i++;
+            continue;
+        }
+        const FileEntry* entry = i < old->count ? file_list_get(old, i) : NULL;
+        bool ok;
+        if (entry && (k == added_count ||
+                      compare_listing_names(entry->type == FILE_TYPE_DIRECTORY, file_entry_name(old, entry),
+                                            S_ISDIR(added[k]->st.st_mode), added[k]->name) < 0)) {
+            ok = file_list_add_entry(list, old, entry);
+            i++;
+        } else {
+            ok = file_list_add(list, added[k]->path, strlen(added[k]->path), added[k]->name_offset, &added[k]->st, 0);
+            k++;
+        }
+        if (!ok) {
+            file_list_destroy(list);
             return false;
         }
+    }
+    
+    file_list_destroy(old);
+    cached->files = list;
+    free(cached->name_slots);
+    cached->name_slots = NULL;
+    cached->name_capacity = 0;
+    cached->dead_bytes = 0;
+    return true;
+}
+
+// Applique à cached les changements d'un de ses lots (un par nom).
+// Retourne true si le listing a changé.
+static bool cache_patch_listing(CacheEntry* cached, CacheChange* changes, int count) {
+    if (!cache_names_build(cached)) {
+        return false;
+    }
+    
+    FileList* list = cached->files;
+    bool rebuild = atomic_load_explicit(&list->refcount, memory_order_acquire) > 1 || count > CACHE_WATCH_IN_PLACE;
+    uint64_t* dropped = rebuild ? (uint64_t*)calloc((size_t)list->count / 64 + 1, sizeof(uint64_t)) : NULL;
+    CacheChange** added = rebuild ? (CacheChange**)malloc(sizeof(CacheChange*) * (size_t)count) : NULL;
+    if (rebuild && (!dropped || !added)) {
+        free(dropped);
+        free(added);
+        return false;
+    }
+    
+    bool changed = false;
+    int added_count = 0;
+    for (int c = 0; c < count; c++) {
+        CacheChange* change = &changes[c];
+        if (!cached->show_hidden && change->name[0] == '.') continue;
+        if (change->exists && !change->path) continue;
+        
+        int slot = cache_names_find(cached, change->name);
+        int index = slot >= 0 ? cached->name_slots[slot] - 1 : -1;
+        if (index < 0 && !change->exists) continue;
+        
+        // Changement de métadonnées: corrigé sur place (même position)
+        if (index >= 0 && change->exists) {
+            const FileEntry* entry = file_list_get(list, index);
+            if (cache_entry_matches(entry, &change->st)) continue;
+            if ((entry->type == FILE_TYPE_DIRECTORY) == (bool)S_ISDIR(change->st.st_mode) && !rebuild) {
+                file_entry_set_stat(file_list_get(list, index), &change->st);
+                changed = true;
+                continue;
+            }
+        }
         
-        if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0) {
+        // Retrait, ajout, ou changement de type (l'entrée change de place)
+        changed = true;
+        if (rebuild) {
+            if (index >= 0) {
+                dropped[index >> 6] |= 1ULL << (index & 63);
+            }
+            if (change->exists) {
+                added[added_count++] = change;
+            }
             continue;
         }
-        
-        if (!show_hidden && entry->d_name[0] == '.') {
+        if (index >= 0) {
+            cache_listing_remove(cached, slot, index);
+        }
+        if (change->exists && !cache_listing_insert(cached, change)) {
+            break;  // Budget du listing atteint: l'entrée manque
+        }
+    }
+    
+    if (rebuild && changed) {
+        qsort(added, (size_t)added_count, sizeof(CacheChange*), compare_added_changes);
+        cache_listing_rebuild(cached, dropped, added, added_count);
+    } else if (cached->dead_bytes > CACHE_COMPACT_DEAD_BYTES) {
+        cache_listing_rebuild(cached, NULL, NULL, 0);
+    }
+    free(dropped);
+    free(added);
+    return changed;
+}
+
+// Traite un lot d'événements (appelant: mutex du cache non verrouillé).
+// Retourne true si au moins un listing a changé.
+static bool cache_apply_events(DirectoryCache* cache, const char* buffer, ssize_t length) {
+    // 1. Dernier événement de chaque nom, hors verrou
+    size_t capacity = (size_t)length / sizeof(struct inotify_event) + 1;
+    CacheChange* changes = (CacheChange*)calloc(capacity, sizeof(CacheChange));
+    int count = 0;
+    bool overflow = changes == NULL;  // Sans mémoire, traité comme des événements perdus
+    for (const char* p = buffer; changes && p < buffer + length; ) {
+        const struct inotify_event* event = (const struct inotify_event*)p;
+        p += sizeof(struct inotify_event) + event->len;
+        if (event->mask & IN_Q_OVERFLOW) {
+            overflow = true;
+        } else if (event->len > 0 && event->name[0] != '\0' &&
+                   !(event->mask & (IN_DELETE_SELF | IN_MOVE_SELF | IN_IGNORED))) {
+            changes[count].wd = event->wd;
+            changes[count].mask = event->mask;
+            changes[count].sequence = count;
+            changes[count].name = event->name;
+            count++;
+        }
+    }
+    qsort(changes, (size_t)count, sizeof(CacheChange), compare_cache_changes);
+    int unique = 0;
+    for (int i = 0; i < count; i++) {
+        if (i + 1 < count && changes[i + 1].wd == changes[i].wd && strcmp(changes[i + 1].name, changes[i].name) == 0) {
             continue;
         }
+        changes[unique++] = changes[i];
+    }
+    count = unique;
+    
+    // 2. Chemins à examiner, depuis le dossier de chaque watch
+    pthread_mutex_lock(&cache->mutex);
+    for (int i = 0; i < count && !overflow; ) {
+        int wd = changes[i].wd;
+        const CacheEntry* cached = cache->lru_head;
+        while (cached && cached->watch_descriptor != wd) {
+            cached = cached->lru_next;
+        }
+        char path_buffer[MAX_PATH_LENGTH];
+        size_t dir_len = cached ? path_set_directory(path_buffer, cached->path) : 0;
+        for (; i < count && changes[i].wd == wd; i++) {
+            if (changes[i].mask & (IN_DELETE | IN_MOVED_FROM)) continue;
+            size_t path_len = dir_len ? path_append_name(path_buffer, dir_len, changes[i].name) : 0;
+            changes[i].path = path_len ? (char*)malloc(path_len + 1) : NULL;
+            changes[i].exists = true;
+            if (changes[i].path) {
+                memcpy(changes[i].path, path_buffer, path_len + 1);
+                changes[i].name_offset = dir_len;
+            }
+        }
+    }
+    pthread_mutex_unlock(&cache->mutex);
+    
+    // 3. Un stat par nom, hors verrou: un disque lent ne bloque pas la vue
+    for (int i = 0; i < count; i++) {
+        if (!changes[i].path || stat(changes[i].path, &changes[i].st) == 0) continue;
+        if (errno == ENOENT || errno == ENOTDIR) {
+            changes[i].exists = false;  // Déjà supprimé: retiré sans attendre l'événement
+        } else {
+            free(changes[i].path);      // État inconnu (ex. permission)
+            changes[i].path = NULL;
+        }
+    }
+    
+    // 4. Corrections sous le verrou
+    bool changed = false;
+    pthread_mutex_lock(&cache->mutex);
+    if (overflow) {
+        // Événements perdus: plus aucun listing n'est fiable
+        while (cache->lru_head) {
+            cache_remove(cache, cache->lru_head, true);
+        }
+        changed = true;
+    }
+    
+    for (const char* p = buffer; !overflow && p < buffer + length; ) {
+        const struct inotify_event* event = (const struct inotify_event*)p;
+        p += sizeof(struct inotify_event) + event->len;
+        if (!(event->mask & (IN_DELETE_SELF | IN_MOVE_SELF | IN_IGNORED))) continue;
         
-        // Vérifier exclusion
-        bool excluded = false;
-        for (int i = 0; EXCLUDED_DIRS[i] != NULL; i++) {
-            if (strcmp(entry->d_name, EXCLUDED_DIRS[i]) == 0) {
-                excluded = true;
-                break;
+        // Le dossier lui-même a disparu: invalider ses listings
+        CacheEntry* entry = cache->lru_head;
+        while (entry) {
+            CacheEntry* next = entry->lru_next;
+            if (entry->watch_descriptor == event->wd) {
+                cache_remove(cache, entry, false);
+                changed = true;
+            }
+            entry = next;
+        }
+        if (!(event->mask & IN_IGNORED)) {
+            inotify_rm_watch(cache->inotify_fd, event->wd);
+        }
+    }
+    
+    for (int i = 0; i < count && !overflow; ) {
+        int first = i;
+        while (i < count && changes[i].wd == changes[first].wd) {
+            i++;
+        }
+        for (CacheEntry* entry = cache->lru_head; entry; entry = entry->lru_next) {
+            if (entry->watch_descriptor != changes[first].wd ||
+                !cache_patch_listing(entry, changes + first, i - first)) {
+                continue;
             }
+            // Une version par listing et par lot; son coût a pu changer
+            entry->version = cache->next_version++;
+            cache->memory_used -= entry->bytes;
+            entry->bytes = cache_entry_bytes(entry);
+            cache->memory_used += entry->bytes;
+            changed = true;
         }
-        if (excluded) continue;
+    }
+    cache_enforce_budget(cache, 0);
+    pthread_mutex_unlock(&cache->mutex);
+    
+    for (int i = 0; i < count; i++) {
+        free(changes[i].path);
+    }
+    free(changes);
+    return changed;
+}
+
+// Lit les événements disponibles dans buffer, puis attend brièvement la
+// suite d'une rafale (au plus CACHE_WATCH_COALESCE_MS): elle est traitée en
+// un seul lot. Retourne les octets lus (0: aucun).
+static ssize_t cache_watch_read(DirectoryCache* cache, char* buffer, size_t size) {
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    
+    size_t used = 0;
+    while (size - used >= sizeof(struct inotify_event) + NAME_MAX + 1) {
+        ssize_t length = read(cache->inotify_fd, buffer + used, size - used);
+        if (length > 0) {
+            used += (size_t)length;
+            continue;
+        }
+        if (length < 0 && errno == EINTR) continue;
+        if (used == 0) break;
         
-        char full_path[MAX_PATH_LENGTH];
-        snprintf(full_path, sizeof(full_path), "%s/%s", path, entry->d_name);
+        struct timespec now;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        long elapsed = (now.tv_sec - start.tv_sec) * 1000 + (now.tv_nsec - start.tv_nsec) / 1000000;
+        if (elapsed >= CACHE_WATCH_COALESCE_MS) break;
         
-        struct stat st;
-        if (stat(full_path, &st) == -1) {
-            continue;
+        struct pollfd fds[2];
+        fds[0].fd = cache->inotify_fd;
+        fds[0].events = POLLIN;
+        fds[1].fd = cache->stop_pipe[0];
+        fds[1].events = POLLIN;
+        if (poll(fds, 2, (int)(CACHE_WATCH_COALESCE_MS - elapsed)) <= 0 || fds[1].revents) break;
+    }
+    return (ssize_t)used;
+}
+
+static void* cache_watch_thread_function(void* arg) {
+    DirectoryCache* cache = (DirectoryCache*)arg;
+    
+    // Aligné pour struct inotify_event
+    char buffer[64 * 1024] __attribute__((aligned(__alignof__(struct inotify_event))));
+    
+    for (;;) {
+        struct pollfd fds[2];
+        fds[0].fd = cache->inotify_fd;
+        fds[0].events = POLLIN;
+        fds[1].fd = cache->stop_pipe[0];
+        fds[1].events = POLLIN;
+        
+        if (poll(fds, 2, -1) < 0) {
+            if (errno == EINTR) continue;
+            break;
         }
         
-        if (S_ISDIR(st.st_mode)) {
-            // Recherche récursive
-            if (!search_files_by_content(full_path, search_term, list, depth + 1, show_hidden)) {
-                closedir(dir);
-                return false;
-            }
-        } else {
-            // Rechercher dans le contenu du fichier
-            if (search_in_file_content(full_path, search_term)) {
-                FileEntry file_entry;
-                strncpy(file_entry.path, full_path, sizeof(file_entry.path) - 1);
-                file_entry.path[sizeof(file_entry.path) - 1] = '\0';
-                
-                strncpy(file_entry.name, entry->d_name, sizeof(file_entry.name) - 1);
-                file_entry.name[sizeof(file_entry.name) - 1] = '\0';
-                
-                file_entry.size = st.st_size;
-                file_entry.depth = depth;
-                file_entry.type = FILE_TYPE_FILE;
-                
-                // Récupérer les métadonnées
-                get_file_metadata(full_path, &file_entry);
-                
-                file_list_add(list, &file_entry);
+        if (fds[1].revents) {
+            break;  // Arrêt demandé par cache_destroy
+        }
+        
+        bool changed = false;
+        for (;;) {
+            ssize_t length = cache_watch_read(cache, buffer, sizeof(buffer));
+            if (length <= 0) break;
+            if (cache_apply_events(cache, buffer, length)) {
+                changed = true;
             }
         }
+        
+        pthread_mutex_lock(&cache->mutex);
+        void (*callback)(void*) = cache->change_callback;
+        void* user_data = cache->change_user_data;
+        pthread_mutex_unlock(&cache->mutex);
+        
+        if (changed && callback) {
+            callback(user_data);
+        }
     }
     
-    closedir(dir);
-    return true;
+    return NULL;
 }
 
-// === Recherche asynchrone (threading) ===
-typedef struct {
-    AsyncSearch* search;
-} SearchThreadData;
-
-// Wrapper pour la recherche avec statistiques
-static bool search_recursive_with_stats(AsyncSearch* search, const char* path, const char* search_term, FileList* list, int depth, bool show_hidden) {
-    if (depth > MAX_SEARCH_DEPTH) {
-        return true;
+static void cache_watch_start(DirectoryCache* cache) {
+    cache->inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (cache->inotify_fd < 0) {
+        return;
     }
     
-    if (list->count >= MAX_SEARCH_RESULTS) {
-        return false;
+    if (pipe(cache->stop_pipe) != 0) {
+        close(cache->inotify_fd);
+        cache->inotify_fd = -1;
+        return;
     }
     
-    // Vérifier si annulé
-    pthread_mutex_lock(&search->mutex);
-    bool cancelled = (search->status == SEARCH_CANCELLED);
-    pthread_mutex_unlock(&search->mutex);
+    if (pthread_create(&cache->watch_thread, NULL, cache_watch_thread_function, cache) != 0) {
+        close(cache->stop_pipe[0]);
+        close(cache->stop_pipe[1]);
+        close(cache->inotify_fd);
+        cache->stop_pipe[0] = cache->stop_pipe[1] = -1;
+        cache->inotify_fd = -1;
+        return;
+    }
     
-    if (cancelled) {
-        return false;
+    cache->watching = true;
+}
+
+static void cache_watch_stop(DirectoryCache* cache) {
+    if (!cache->watching) return;
+    
+    char stop = 1;
+    if (write(cache->stop_pipe[1], &stop, 1) == 1) {
+        pthread_join(cache->watch_thread, NULL);
+    } else {
+        pthread_cancel(cache->watch_thread);
+        pthread_join(cache->watch_thread, NULL);
     }
     
-    DIR* dir = opendir(path);
-    if (!dir) {
-        return true;
+    close(cache->stop_pipe[0]);
+    close(cache->stop_pipe[1]);
+    close(cache->inotify_fd);
+    cache->inotify_fd = -1;
+    cache->watching = false;
+}
+#endif
+
+// === Recherche de sous-chaîne insensible à la casse ===
+// Filtre sur le premier et le dernier octet du motif (dans leurs deux casses)
+// par blocs de 16 (SSE2/NEON) ou 32 octets (AVX2), puis vérification des
+// seules positions candidates. Le noyau est choisi une fois à l'exécution.
+// Le repliement de casse est ASCII, comme tolower() dans la locale "C".
+
+static inline unsigned char ascii_lower(unsigned char c) {
+    return (c >= 'A' && c <= 'Z') ? (unsigned char)(c | 0x20) : c;
+}
+
+static inline unsigned char ascii_upper(unsigned char c) {
+    return (c >= 'a' && c <= 'z') ? (unsigned char)(c & ~0x20) : c;
+}
+
+// Compare le milieu du motif (déjà en minuscules) à une position candidate
+static inline bool icase_verify(const unsigned char* text, const unsigned char* lower_needle, size_t length) {
+    for (size_t i = 1; i + 1 < length; i++) {
+        if (ascii_lower(text[i]) != lower_needle[i]) {
+            return false;
+        }
     }
+    return true;
+}
+
+static const char* memmem_icase_scalar(const unsigned char* text, size_t text_length, const unsigned char* needle, size_t length, size_t start) {
+    unsigned char first = needle[0];
+    unsigned char last = needle[length - 1];
     
-    // Incrémenter le compteur de dossiers
-    pthread_mutex_lock(&search->mutex);
-    search->dirs_scanned++;
-    pthread_mutex_unlock(&search->mutex);
+    for (size_t i = start; i + length <= text_length; i++) {
+        if (ascii_lower(text[i]) == first && ascii_lower(text[i + length - 1]) == last &&
+            icase_verify(text + i, needle, length)) {
+            return (const char*)(text + i);
+        }
+    }
+    return NULL;
+}
+
+#if MEMMEM_ICASE_X86
+static const char* memmem_icase_sse2(const unsigned char* text, size_t text_length, const unsigned char* needle, size_t length) {
+    const __m128i first_lower = _mm_set1_epi8((char)needle[0]);
+    const __m128i first_upper = _mm_set1_epi8((char)ascii_upper(needle[0]));
+    const __m128i last_lower = _mm_set1_epi8((char)needle[length - 1]);
+    const __m128i last_upper = _mm_set1_epi8((char)ascii_upper(needle[length - 1]));
     
-    // Convertir le terme de recherche en minuscules
-    char lower_search[256];
-    for (int i = 0; search_term[i] && i < 255; i++) {
-        lower_search[i] = tolower(search_term[i]);
-        lower_search[i + 1] = '\0';
+    size_t i = 0;
+    for (; i + length - 1 + 16 <= text_length; i += 16) {
+        __m128i block_first = _mm_loadu_si128((const __m128i*)(text + i));
+        __m128i block_last = _mm_loadu_si128((const __m128i*)(text + i + length - 1));
+        
+        __m128i eq_first = _mm_or_si128(_mm_cmpeq_epi8(block_first, first_lower), _mm_cmpeq_epi8(block_first, first_upper));
+        __m128i eq_last = _mm_or_si128(_mm_cmpeq_epi8(block_last, last_lower), _mm_cmpeq_epi8(block_last, last_upper));
+        unsigned int mask = (unsigned int)_mm_movemask_epi8(_mm_and_si128(eq_first, eq_last));
+        
+        while (mask) {
+            unsigned int bit = (unsigned int)__builtin_ctz(mask);
+            if (icase_verify(text + i + bit, needle, length)) {
+                return (const char*)(text + i + bit);
+            }
+            mask &= mask - 1;
+        }
     }
+    return memmem_icase_scalar(text, text_length, needle, length, i);
+}
+
+__attribute__((target("avx2")))
+static const char* memmem_icase_avx2(const unsigned char* text, size_t text_length, const unsigned char* needle, size_t length) {
+    const __m256i first_lower = _mm256_set1_epi8((char)needle[0]);
+    const __m256i first_upper = _mm256_set1_epi8((char)ascii_upper(needle[0]));
+    const __m256i last_lower = _mm256_set1_epi8((char)needle[length - 1]);
+    const __m256i last_upper = _mm256_set1_epi8((char)ascii_upper(needle[length - 1]));
     
-    struct dirent* entry;
-    while ((entry = readdir(dir)) != NULL) {
-        if (list->count >= MAX_SEARCH_RESULTS) {
-            closedir(dir);
-            return false;
+    size_t i = 0;
+    for (; i + length - 1 + 32 <= text_length; i += 32) {
+        __m256i block_first = _mm256_loadu_si256((const __m256i*)(text + i));
+        __m256i block_last = _mm256_loadu_si256((const __m256i*)(text + i + length - 1));
+        
+        __m256i eq_first = _mm256_or_si256(_mm256_cmpeq_epi8(block_first, first_lower), _mm256_cmpeq_epi8(block_first, first_upper));
+        __m256i eq_last = _mm256_or_si256(_mm256_cmpeq_epi8(block_last, last_lower), _mm256_cmpeq_epi8(block_last, last_upper));
+        unsigned int mask = (unsigned int)_mm256_movemask_epi8(_mm256_and_si256(eq_first, eq_last));
+        
+        while (mask) {
+            unsigned int bit = (unsigned int)__builtin_ctz(mask);
+            if (icase_verify(text + i + bit, needle, length)) {
+                return (const char*)(text + i + bit);
+            }
+            mask &= mask - 1;
         }
+    }
+    return memmem_icase_scalar(text, text_length, needle, length, i);
+}
+#endif
+
+#if MEMMEM_ICASE_NEON
+static const char* memmem_icase_neon(const unsigned char* text, size_t text_length, const unsigned char* needle, size_t length) {
+    const uint8x16_t first_lower = vdupq_n_u8(needle[0]);
+    const uint8x16_t first_upper = vdupq_n_u8(ascii_upper(needle[0]));
+    const uint8x16_t last_lower = vdupq_n_u8(needle[length - 1]);
+    const uint8x16_t last_upper = vdupq_n_u8(ascii_upper(needle[length - 1]));
+    
+    size_t i = 0;
+    for (; i + length - 1 + 16 <= text_length; i += 16) {
+        uint8x16_t block_first = vld1q_u8(text + i);
+        uint8x16_t block_last = vld1q_u8(text + i + length - 1);
         
-        // Vérifier si annulé
-        pthread_mutex_lock(&search->mutex);
-        cancelled = (search->status == SEARCH_CANCELLED);
-        pthread_mutex_unlock(&search->mutex);
+        uint8x16_t eq_first = vorrq_u8(vceqq_u8(block_first, first_lower), vceqq_u8(block_first, first_upper));
+        uint8x16_t eq_last = vorrq_u8(vceqq_u8(block_last, last_lower), vceqq_u8(block_last, last_upper));
+        
+        // Pas de movemask sur NEON: 4 bits par octet via un décalage-réduction
+        uint8x8_t narrowed = vshrn_n_u16(vreinterpretq_u16_u8(vandq_u8(eq_first, eq_last)), 4);
+        uint64_t mask = vget_lane_u64(vreinterpret_u64_u8(narrowed), 0);
+        
+        while (mask) {
+            unsigned int bit = (unsigned int)__builtin_ctzll(mask) / 4;
+            if (icase_verify(text + i + bit, needle, length)) {
+                return (const char*)(text + i + bit);
+            }
+            mask &= ~(0xFULL << (bit * 4));
+        }
+    }
+    return memmem_icase_scalar(text, text_length, needle, length, i);
+}
+#endif
+
+typedef const char* (*MemmemIcaseKernel)(const unsigned char*, size_t, const unsigned char*, size_t);
+
+static MemmemIcaseKernel memmem_icase_kernel = NULL;
+static pthread_once_t memmem_icase_once = PTHREAD_ONCE_INIT;
+
+static const char* memmem_icase_scalar_kernel(const unsigned char* text, size_t text_length, const unsigned char* needle, size_t length) {
+    return memmem_icase_scalar(text, text_length, needle, length, 0);
+}
+
+static void memmem_icase_select(void) {
+    memmem_icase_kernel = memmem_icase_scalar_kernel;
+#if MEMMEM_ICASE_X86
+    memmem_icase_kernel = memmem_icase_sse2;
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        memmem_icase_kernel = memmem_icase_avx2;
+    }
+#elif MEMMEM_ICASE_NEON
+    memmem_icase_kernel = memmem_icase_neon;
+#endif
+}
+
+const char* memmem_icase(const char* haystack, size_t haystack_length, const char* needle, size_t needle_length) {
+    if (!haystack || !needle) return NULL;
+    if (needle_length == 0) return haystack;
+    if (needle_length > haystack_length) return NULL;
+    
+    // Motif en minuscules (les motifs longs sont rares: repli sur le tas)
+    unsigned char stack_needle[256];
+    unsigned char* lower_needle = needle_length <= sizeof(stack_needle)
+        ? stack_needle : (unsigned char*)malloc(needle_length);
+    if (!lower_needle) return NULL;
+    for (size_t i = 0; i < needle_length; i++) {
+        lower_needle[i] = ascii_lower((unsigned char)needle[i]);
+    }
+    
+    pthread_once(&memmem_icase_once, memmem_icase_select);
+    const char* found = memmem_icase_kernel((const unsigned char*)haystack, haystack_length, lower_needle, needle_length);
+    
+    if (lower_needle != stack_needle) {
+        free(lower_needle);
+    }
+    return found;
+}
+
+// === Correspondance approximative ===
+// Les caractères de la requête doivent apparaître dans l'ordre dans le nom,
+// pas forcément côte à côte (sous-séquence, à la fzf). Le score récompense
+// les caractères consécutifs et ceux qui commencent un mot (début du nom,
+// après un séparateur, majuscule après une minuscule) et pénalise les trous:
+// alignement local à la Smith-Waterman, réduit aux appariements exacts.
+// La plupart des noms sont écartés par leur masque de caractères, puis une
+// passe gloutonne borne les colonnes utiles avant la programmation dynamique.
+
+#define FUZZY_SCORE_MATCH 16
+#define FUZZY_GAP_START (-3)
+#define FUZZY_GAP_EXTENSION (-1)
+#define FUZZY_BONUS_BOUNDARY 8
+#define FUZZY_BONUS_CAMEL 7
+#define FUZZY_BONUS_CONSECUTIVE 4
+#define FUZZY_FIRST_CHAR_MULTIPLIER 2
+#define FUZZY_NO_SCORE (INT_MIN / 2)
+
+typedef struct {
+    unsigned char text[256];    // Requête en minuscules
+    int length;
+    uint64_t mask;              // Caractères que le nom doit contenir
+} FuzzyPattern;
+
+// Bit d'un caractère (déjà en minuscules): un par lettre et par chiffre, les
+// autres se partagent les bits restants
+static inline uint64_t fuzzy_char_bit(unsigned char c) {
+    if (c >= 'a' && c <= 'z') return 1ULL << (c - 'a');
+    if (c >= '0' && c <= '9') return 1ULL << (26 + c - '0');
+    return 1ULL << (36 + c % 28);
+}
+
+static bool fuzzy_pattern_init(FuzzyPattern* pattern, const char* query) {
+    pattern->length = 0;
+    pattern->mask = 0;
+    for (int i = 0; query[i] && i < 255; i++) {
+        unsigned char c = ascii_lower((unsigned char)query[i]);
+        pattern->text[pattern->length++] = c;
+        pattern->mask |= fuzzy_char_bit(c);
+    }
+    return pattern->length > 0;
+}
+
+static inline bool fuzzy_is_word(unsigned char c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c >= 0x80;
+}
+
+// Bonus d'un caractère qui commence un mot
+static int fuzzy_bonus(unsigned char previous, unsigned char c) {
+    if (!fuzzy_is_word(c)) return 0;
+    if (!fuzzy_is_word(previous)) return FUZZY_BONUS_BOUNDARY;
+    if (previous >= 'a' && previous <= 'z' && c >= 'A' && c <= 'Z') return FUZZY_BONUS_CAMEL;
+    if (!(previous >= '0' && previous <= '9') && c >= '0' && c <= '9') return FUZZY_BONUS_CAMEL;
+    return 0;
+}
+
+// Score du meilleur alignement de la requête dans name; false si ce n'est
+// pas une sous-séquence (un nom ne dépasse pas NAME_MAX octets)
+static bool fuzzy_match(const FuzzyPattern* pattern, const char* name, size_t length, int* score) {
+    const unsigned char* text = (const unsigned char*)name;
+    int m = pattern->length;
+    int n = length < 255 ? (int)length : 255;
+    if (m > n) return false;
+    
+    unsigned char lower[255];
+    uint64_t mask = 0;
+    for (int j = 0; j < n; j++) {
+        lower[j] = ascii_lower(text[j]);
+        mask |= fuzzy_char_bit(lower[j]);
+    }
+    if ((mask & pattern->mask) != pattern->mask) {
+        return false;
+    }
+    
+    // Colonnes possibles de chaque caractère: au plus tôt (passe gloutonne
+    // en avant) et au plus tard (en arrière)
+    int first[255];
+    int last[255];
+    int j = 0;
+    for (int i = 0; i < m; i++, j++) {
+        while (j < n && lower[j] != pattern->text[i]) j++;
+        if (j == n) return false;
+        first[i] = j;
+    }
+    j = n - 1;
+    for (int i = m - 1; i >= 0; i--, j--) {
+        while (lower[j] != pattern->text[i]) j--;
+        last[i] = j;
+    }
+    
+    int bonus[255];
+    for (j = first[0]; j <= last[m - 1]; j++) {
+        bonus[j] = fuzzy_bonus(j > 0 ? text[j - 1] : '/', text[j]);
+    }
+    
+    // rows[i & 1][j]: meilleur score avec le caractère i de la requête en j;
+    // chunks: bonus du début de la suite consécutive qui y mène, étendu à
+    // toute la suite (un mot trouvé d'un bloc vaut mieux que ses initiales)
+    int rows[2][255];
+    int chunks[2][255];
+    int* row = rows[0];
+    for (j = 0; j < n; j++) {
+        row[j] = FUZZY_NO_SCORE;
+    }
+    for (j = first[0]; j <= last[0]; j++) {
+        if (lower[j] == pattern->text[0]) {
+            row[j] = FUZZY_SCORE_MATCH + bonus[j] * FUZZY_FIRST_CHAR_MULTIPLIER;
+            chunks[0][j] = bonus[j];
+        }
+    }
+    
+    for (int i = 1; i < m; i++) {
+        const int* previous = rows[(i - 1) & 1];
+        const int* previous_chunk = chunks[(i - 1) & 1];
+        int* chunk = chunks[i & 1];
+        row = rows[i & 1];
+        for (j = 0; j < n; j++) {
+            row[j] = FUZZY_NO_SCORE;
+        }
+        
+        // gap: meilleur score précédent suivi d'un trou jusqu'à j exclu
+        int gap = FUZZY_NO_SCORE;
+        for (j = first[i - 1] + 1; j <= last[i]; j++) {
+            if (j >= 2 && previous[j - 2] > gap + FUZZY_GAP_EXTENSION - FUZZY_GAP_START) {
+                gap = previous[j - 2] + FUZZY_GAP_START;
+            } else {
+                gap += FUZZY_GAP_EXTENSION;
+            }
+            if (j < first[i] || lower[j] != pattern->text[i]) {
+                continue;
+            }
+            
+            int best = gap + bonus[j];
+            chunk[j] = bonus[j];
+            if (previous[j - 1] > FUZZY_NO_SCORE / 2) {
+                // Un début de mot plus marqué commence une nouvelle suite
+                int run_bonus = previous_chunk[j - 1];
+                if (bonus[j] >= FUZZY_BONUS_BOUNDARY && bonus[j] > run_bonus) {
+                    run_bonus = bonus[j];
+                }
+                int consecutive = run_bonus > FUZZY_BONUS_CONSECUTIVE ? run_bonus : FUZZY_BONUS_CONSECUTIVE;
+                if (previous[j - 1] + consecutive > best) {
+                    best = previous[j - 1] + consecutive;
+                    chunk[j] = run_bonus;
+                }
+            }
+            if (best > FUZZY_NO_SCORE / 2) {
+                row[j] = best + FUZZY_SCORE_MATCH;
+            }
+        }
+    }
+    
+    int best = FUZZY_NO_SCORE;
+    for (j = first[m - 1]; j <= last[m - 1]; j++) {
+        if (row[j] > best) best = row[j];
+    }
+    *score = best;
+    return true;
+}
+
+// === Motifs multiples ===
+// Une recherche par contenu peut porter sur plusieurs termes séparés par
+// CONTENT_PATTERN_SEPARATOR, cherchés en une seule passe (insensible à la
+// casse, ASCII). Un seul terme passe par memmem_icase; plusieurs par un
+// automate d'Aho-Corasick complet sur un alphabet réduit aux octets des
+// motifs, précédé sur AVX2 d'un filtre Teddy quand ils sont peu nombreux
+// (jusqu'à TEDDY_MAX_PATTERNS, répartis en TEDDY_BUCKETS groupes).
+// L'occurrence retenue est la plus à gauche (la plus longue à position
+// égale): recherche et visionneuse désignent les mêmes octets.
+#define TEDDY_BUCKETS 8             // Groupes de motifs: un bit par groupe dans les masques
+#define TEDDY_MAX_PATTERNS 64       // Au-delà, les groupes laissent passer trop de candidats
+#define TEDDY_MAX_BYTES 3           // Octets de tête comparés par le filtre
+
+// Expression régulière compilée (section suivante)
+typedef struct RegexEngine RegexEngine;
+static const unsigned char* regex_engine_find(RegexEngine* engine, const unsigned char* text, size_t length, bool starts_line, bool ends_line, size_t* match_length);
+static void regex_engine_destroy(RegexEngine* engine);
+
+struct ContentMatcher {
+    int pattern_count;
+    unsigned char** patterns;       // En minuscules
+    size_t* lengths;
+    size_t min_length;
+    size_t max_length;
+    // Aho-Corasick (plusieurs motifs)
+    unsigned char classes[256];     // Octet -> classe (0: absent des motifs)
+    int class_count;
+    int32_t* transitions;           // Automate complet: ligne + classe -> ligne (~ligne: fin de motif)
+    int32_t* outputs;               // Par état: plus long motif qui y finit (-1: aucun)
+    // Teddy: pour chaque octet de tête, groupes compatibles par quartet bas et haut
+    int teddy_bytes;                // 0: filtre inutilisé
+    unsigned char teddy_low[TEDDY_MAX_BYTES][16];
+    unsigned char teddy_high[TEDDY_MAX_BYTES][16];
+    int bucket_counts[TEDDY_BUCKETS];
+    unsigned char bucket_patterns[TEDDY_BUCKETS][TEDDY_MAX_PATTERNS];
+    RegexEngine* regex;             // Expression régulière (à la place des motifs)
+};
+
+static inline bool icase_equal(const unsigned char* text, const unsigned char* lower_needle, size_t length) {
+    for (size_t i = 0; i < length; i++) {
+        if (ascii_lower(text[i]) != lower_needle[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Construit l'automate: trie des motifs, puis liens d'échec en largeur
+// d'abord, qui complètent les transitions manquantes
+static bool content_matcher_build_automaton(ContentMatcher* matcher) {
+    for (int p = 0; p < matcher->pattern_count; p++) {
+        for (size_t i = 0; i < matcher->lengths[p]; i++) {
+            unsigned char c = matcher->patterns[p][i];
+            if (matcher->classes[c] == 0) {
+                matcher->classes[c] = (unsigned char)++matcher->class_count;
+                matcher->classes[ascii_upper(c)] = matcher->classes[c];
+            }
+        }
+    }
+    int classes = ++matcher->class_count;
+    
+    size_t max_states = 1;
+    for (int p = 0; p < matcher->pattern_count; p++) {
+        max_states += matcher->lengths[p];
+    }
+    matcher->transitions = (int32_t*)malloc(sizeof(int32_t) * max_states * classes);
+    matcher->outputs = (int32_t*)malloc(sizeof(int32_t) * max_states);
+    int32_t* fail = (int32_t*)malloc(sizeof(int32_t) * max_states);
+    int32_t* queue = (int32_t*)malloc(sizeof(int32_t) * max_states);
+    if (!matcher->transitions || !matcher->outputs || !fail || !queue) {
+        free(fail);
+        free(queue);
+        return false;
+    }
+    
+    // Trie (-1: pas encore de transition)
+    for (size_t i = 0; i < max_states * classes; i++) {
+        matcher->transitions[i] = -1;
+    }
+    int state_count = 1;
+    matcher->outputs[0] = -1;
+    for (int p = 0; p < matcher->pattern_count; p++) {
+        int32_t state = 0;
+        for (size_t i = 0; i < matcher->lengths[p]; i++) {
+            int32_t* next = &matcher->transitions[(size_t)state * classes + matcher->classes[matcher->patterns[p][i]]];
+            if (*next < 0) {
+                matcher->outputs[state_count] = -1;
+                *next = state_count++;
+            }
+            state = *next;
+        }
+        matcher->outputs[state] = p;
+    }
+    
+    // Largeur d'abord: un état hérite des transitions et de la sortie de son
+    // lien d'échec, déjà complet puisque moins profond
+    int head = 0, tail = 0;
+    for (int c = 0; c < classes; c++) {
+        int32_t* next = &matcher->transitions[c];
+        if (*next < 0) {
+            *next = 0;
+        } else {
+            fail[*next] = 0;
+            queue[tail++] = *next;
+        }
+    }
+    while (head < tail) {
+        int32_t state = queue[head++];
+        int32_t* row = &matcher->transitions[(size_t)state * classes];
+        const int32_t* fail_row = &matcher->transitions[(size_t)fail[state] * classes];
+        if (matcher->outputs[state] < 0) {
+            matcher->outputs[state] = matcher->outputs[fail[state]];
+        }
+        for (int c = 0; c < classes; c++) {
+            if (row[c] < 0) {
+                row[c] = fail_row[c];
+            } else {
+                fail[row[c]] = fail_row[c];
+                queue[tail++] = row[c];
+            }
+        }
+    }
+    
+    // Lignes prémultipliées (une addition par octet dans la boucle de
+    // parcours), complémentées vers un état qui termine un motif
+    for (size_t i = 0; i < (size_t)state_count * classes; i++) {
+        int32_t target = matcher->transitions[i];
+        matcher->transitions[i] = matcher->outputs[target] >= 0 ? ~(target * classes) : target * classes;
+    }
+    
+    free(fail);
+    free(queue);
+    return true;
+}
+
+// Masques Teddy: un octet de texte est compatible avec le groupe b en
+// position k si le bit b est présent pour ses deux quartets (faux positifs
+// possibles, écartés par la vérification). Les motifs triés par leur tête
+// sont groupés par tranches: les têtes voisines partagent leurs bits.
+static void content_matcher_build_teddy(ContentMatcher* matcher) {
+    if (matcher->pattern_count > TEDDY_MAX_PATTERNS || matcher->min_length < 2) {
+        return;
+    }
+    
+    matcher->teddy_bytes = matcher->min_length < TEDDY_MAX_BYTES ? (int)matcher->min_length : TEDDY_MAX_BYTES;
+    
+    // Tri par insertion des têtes (au plus TEDDY_MAX_PATTERNS motifs)
+    unsigned char order[TEDDY_MAX_PATTERNS];
+    for (int p = 0; p < matcher->pattern_count; p++) {
+        int i = p;
+        while (i > 0 && memcmp(matcher->patterns[order[i - 1]], matcher->patterns[p], (size_t)matcher->teddy_bytes) > 0) {
+            order[i] = order[i - 1];
+            i--;
+        }
+        order[i] = (unsigned char)p;
+    }
+    
+    for (int rank = 0; rank < matcher->pattern_count; rank++) {
+        int p = order[rank];
+        int bucket = rank * TEDDY_BUCKETS / matcher->pattern_count;
+        matcher->bucket_patterns[bucket][matcher->bucket_counts[bucket]++] = (unsigned char)p;
+        
+        unsigned char bit = (unsigned char)(1u << bucket);
+        for (int k = 0; k < matcher->teddy_bytes; k++) {
+            unsigned char lower = matcher->patterns[p][k];
+            unsigned char upper = ascii_upper(lower);
+            matcher->teddy_low[k][lower & 0x0F] |= bit;
+            matcher->teddy_high[k][lower >> 4] |= bit;
+            matcher->teddy_low[k][upper & 0x0F] |= bit;
+            matcher->teddy_high[k][upper >> 4] |= bit;
+        }
+    }
+}
+
+// Matcher vide pouvant recevoir capacity motifs
+static ContentMatcher* content_matcher_alloc(int capacity) {
+    ContentMatcher* matcher = (ContentMatcher*)calloc(1, sizeof(ContentMatcher));
+    if (!matcher) return NULL;
+    
+    matcher->patterns = (unsigned char**)calloc(capacity, sizeof(unsigned char*));
+    matcher->lengths = (size_t*)calloc(capacity, sizeof(size_t));
+    if (!matcher->patterns || !matcher->lengths) {
+        content_matcher_destroy(matcher);
+        return NULL;
+    }
+    return matcher;
+}
+
+// Ajoute un motif, en minuscules, s'il est non vide et distinct (à la casse
+// près) des précédents; false si la mémoire manque
+static bool content_matcher_add_pattern(ContentMatcher* matcher, const char* text, size_t length) {
+    bool duplicate = length == 0;
+    for (int p = 0; !duplicate && p < matcher->pattern_count; p++) {
+        duplicate = matcher->lengths[p] == length &&
+                    icase_equal((const unsigned char*)text, matcher->patterns[p], length);
+    }
+    if (duplicate) return true;
+    
+    unsigned char* pattern = (unsigned char*)malloc(length);
+    if (!pattern) return false;
+    for (size_t i = 0; i < length; i++) {
+        pattern[i] = ascii_lower((unsigned char)text[i]);
+    }
+    matcher->patterns[matcher->pattern_count] = pattern;
+    matcher->lengths[matcher->pattern_count++] = length;
+    if (length > matcher->max_length) matcher->max_length = length;
+    if (matcher->min_length == 0 || length < matcher->min_length) matcher->min_length = length;
+    return true;
+}
+
+// Prépare la recherche une fois les motifs ajoutés; détruit le matcher et
+// retourne NULL s'il n'en a aucun
+static ContentMatcher* content_matcher_compile(ContentMatcher* matcher) {
+    if (matcher->pattern_count == 0) {
+        content_matcher_destroy(matcher);
+        return NULL;
+    }
+    if (matcher->pattern_count > 1) {
+        if (!content_matcher_build_automaton(matcher)) {
+            content_matcher_destroy(matcher);
+            return NULL;
+        }
+        content_matcher_build_teddy(matcher);
+    }
+    return matcher;
+}
+
+ContentMatcher* content_matcher_create(const char* query) {
+    if (!query) return NULL;
+    
+    // Au plus un motif par séparateur, plus un
+    size_t query_length = strlen(query);
+    int capacity = 1;
+    for (size_t i = 0; i < query_length; i++) {
+        if (query[i] == CONTENT_PATTERN_SEPARATOR) capacity++;
+    }
+    ContentMatcher* matcher = content_matcher_alloc(capacity);
+    if (!matcher) return NULL;
+    
+    const char* start = query;
+    while (true) {
+        const char* end = strchr(start, CONTENT_PATTERN_SEPARATOR);
+        size_t length = end ? (size_t)(end - start) : strlen(start);
+        if (!content_matcher_add_pattern(matcher, start, length)) {
+            content_matcher_destroy(matcher);
+            return NULL;
+        }
+        
+        if (!end) break;
+        start = end + 1;
+    }
+    
+    return content_matcher_compile(matcher);
+}
+
+void content_matcher_destroy(ContentMatcher* matcher) {
+    if (!matcher) return;
+    for (int p = 0; matcher->patterns && p < matcher->pattern_count; p++) {
+        free(matcher->patterns[p]);
+    }
+    free(matcher->patterns);
+    free(matcher->lengths);
+    free(matcher->transitions);
+    free(matcher->outputs);
+    regex_engine_destroy(matcher->regex);
+    free(matcher);
+}
+
+int content_matcher_pattern_count(const ContentMatcher* matcher) {
+    return matcher ? matcher->pattern_count : 0;
+}
+
+// Parcours de l'automate depuis text; *pattern reçoit le motif trouvé.
+// Après une occurrence, continue jusqu'à ce qu'aucune commençant plus tôt
+// (ou au même endroit, plus longue) ne puisse encore finir.
+static const unsigned char* content_matcher_run_automaton(const ContentMatcher* matcher, const unsigned char* text, size_t length, int* pattern) {
+    const int32_t* transitions = matcher->transitions;
+    const int32_t* outputs = matcher->outputs;
+    const unsigned char* classes = matcher->classes;
+    size_t class_count = (size_t)matcher->class_count;
+    
+    int32_t row = 0;
+    size_t best_start = 0;
+    int best = -1;
+    for (size_t i = 0; i < length; i++) {
+        row = transitions[row + classes[text[i]]];
+        if (row < 0) {
+            row = ~row;
+            // Le plus long motif finissant ici est celui qui commence le plus tôt
+            int found = outputs[(size_t)row / class_count];
+            size_t found_start = i + 1 - matcher->lengths[found];
+            if (best < 0 || found_start <= best_start) {
+                best_start = found_start;
+                best = found;
+            }
+        }
+        if (best >= 0 && i + 1 >= best_start + matcher->max_length) {
+            break;
+        }
+    }
+    
+    if (best < 0) return NULL;
+    *pattern = best;
+    return text + best_start;
+}
+
+// Le plus long motif des groupes candidats présent à une position (-1: aucun)
+static int content_matcher_verify(const ContentMatcher* matcher, const unsigned char* text, size_t available, unsigned int buckets) {
+    int best = -1;
+    while (buckets) {
+        int bucket = __builtin_ctz(buckets);
+        buckets &= buckets - 1;
+        for (int i = 0; i < matcher->bucket_counts[bucket]; i++) {
+            int p = matcher->bucket_patterns[bucket][i];
+            size_t length = matcher->lengths[p];
+            if (length <= available && (best < 0 || length > matcher->lengths[best]) &&
+                icase_equal(text, matcher->patterns[p], length)) {
+                best = p;
+            }
+        }
+    }
+    return best;
+}
+
+#if MEMMEM_ICASE_X86
+// Filtre Teddy: pour 32 positions à la fois, les motifs compatibles avec les
+// teddy_bytes octets de tête (pshufb sur les quartets). Les candidats sont
+// vérifiés dans l'ordre: le premier confirmé est le plus à gauche.
+__attribute__((target("avx2")))
+static const unsigned char* content_matcher_run_teddy_avx2(const ContentMatcher* matcher, const unsigned char* text, size_t length, int* pattern) {
+    __m256i low[TEDDY_MAX_BYTES];
+    __m256i high[TEDDY_MAX_BYTES];
+    int bytes = matcher->teddy_bytes;
+    for (int k = 0; k < bytes; k++) {
+        low[k] = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)matcher->teddy_low[k]));
+        high[k] = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)matcher->teddy_high[k]));
+    }
+    const __m256i nibble = _mm256_set1_epi8(0x0F);
+    const __m256i zero = _mm256_setzero_si256();
+    
+    size_t i = 0;
+    for (; i + (size_t)bytes - 1 + 32 <= length; i += 32) {
+        __m256i candidates = _mm256_set1_epi8((char)0xFF);
+        for (int k = 0; k < bytes; k++) {
+            __m256i block = _mm256_loadu_si256((const __m256i*)(text + i + k));
+            __m256i block_low = _mm256_and_si256(block, nibble);
+            __m256i block_high = _mm256_and_si256(_mm256_srli_epi16(block, 4), nibble);
+            candidates = _mm256_and_si256(candidates, _mm256_and_si256(
+                _mm256_shuffle_epi8(low[k], block_low), _mm256_shuffle_epi8(high[k], block_high)));
+        }
+        unsigned int mask = ~(unsigned int)_mm256_movemask_epi8(_mm256_cmpeq_epi8(candidates, zero));
+        if (!mask) continue;
+        
+        unsigned char buckets[32];
+        _mm256_storeu_si256((__m256i*)buckets, candidates);
+        while (mask) {
+            unsigned int bit = (unsigned int)__builtin_ctz(mask);
+            int found = content_matcher_verify(matcher, text + i + bit, length - i - bit, buckets[bit]);
+            if (found >= 0) {
+                *pattern = found;
+                return text + i + bit;
+            }
+            mask &= mask - 1;
+        }
+    }
+    
+    // Fin du texte: l'automate ne voit que les occurrences commençant ici
+    return content_matcher_run_automaton(matcher, text + i, length - i, pattern);
+}
+#endif
+
+typedef const unsigned char* (*ContentMatcherKernel)(const ContentMatcher*, const unsigned char*, size_t, int*);
+
+static ContentMatcherKernel content_matcher_teddy_kernel = NULL;
+static pthread_once_t content_matcher_once = PTHREAD_ONCE_INIT;
+
+static void content_matcher_select(void) {
+#if MEMMEM_ICASE_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        content_matcher_teddy_kernel = content_matcher_run_teddy_avx2;
+    }
+#endif
+}
+
+// Occurrence dans text, qui commence une ligne si starts_line et finit la
+// dernière si ends_line (ancres ^ et $ d'une expression régulière, en
+// début et fin de fenêtre; sans effet sur des termes)
+static const char* content_matcher_find_window(ContentMatcher* matcher, const char* text, size_t length, bool starts_line, bool ends_line, size_t* match_length, int* pattern) {
+    if (!matcher || !text) return NULL;
+    
+    const unsigned char* data = (const unsigned char*)text;
+    const unsigned char* match = NULL;
+    size_t found_length = 0;
+    int found = 0;
+    if (matcher->regex) {
+        match = regex_engine_find(matcher->regex, data, length, starts_line, ends_line, &found_length);
+    } else if (matcher->pattern_count == 1) {
+        // Motif déjà en minuscules: noyau de memmem_icase directement
+        if (matcher->lengths[0] <= length) {
+            pthread_once(&memmem_icase_once, memmem_icase_select);
+            match = (const unsigned char*)memmem_icase_kernel(data, length, matcher->patterns[0], matcher->lengths[0]);
+        }
+    } else {
+        pthread_once(&content_matcher_once, content_matcher_select);
+        if (matcher->teddy_bytes > 0 && content_matcher_teddy_kernel) {
+            match = content_matcher_teddy_kernel(matcher, data, length, &found);
+        } else {
+            match = content_matcher_run_automaton(matcher, data, length, &found);
+        }
+    }
+    
+    if (!match) return NULL;
+    if (!matcher->regex) found_length = matcher->lengths[found];
+    if (match_length) *match_length = found_length;
+    if (pattern) *pattern = found;
+    return (const char*)match;
+}
+
+const char* content_matcher_find(ContentMatcher* matcher, const char* text, size_t length, size_t* match_length, int* pattern) {
+    return content_matcher_find_window(matcher, text, length, true, true, match_length, pattern);
+}
+
+// Lignes entamées par data (nombre de '\n')
+static long content_count_lines(const char* data, size_t length) {
+    long lines = 0;
+    const char* end = data + length;
+    while ((data = memchr(data, '\n', (size_t)(end - data))) != NULL) {
+        lines++;
+        data++;
+    }
+    return lines;
+}
+
+int content_matcher_find_all(ContentMatcher* matcher, const char* text, size_t length, ContentMatch* matches, int max) {
+    if (!matcher || !text || !matches) return 0;
+    
+    int count = 0;
+    size_t position = 0;
+    size_t line_position = 0;
+    long line = 1;
+    while (count < max && position <= length) {
+        size_t match_length;
+        int pattern;
+        bool starts_line = position == 0 || text[position - 1] == '\n';
+        const char* match = content_matcher_find_window(matcher, text + position, length - position, starts_line, true, &match_length, &pattern);
+        if (!match) break;
+        
+        size_t offset = (size_t)(match - text);
+        line += content_count_lines(text + line_position, offset - line_position);
+        line_position = offset;
+        
+        matches[count].offset = (long)offset;
+        matches[count].length = (int)match_length;
+        matches[count].line = (int)line;
+        matches[count].pattern = pattern;
+        count++;
+        
+        // Occurrences disjointes (une occurrence vide avance d'un octet)
+        position = offset + (match_length > 0 ? match_length : 1);
+    }
+    return count;
+}
+
+// === Expressions régulières ===
+// Requêtes SEARCH_QUERY_REGEX, insensibles à la casse (ASCII) comme les
+// termes. Syntaxe: littéraux, ., [...], [^...], \d \w \s \D \W \S, \t \r \f
+// \v \xHH, ^ et $ (début et fin de ligne), |, (...), (?:...), * + ? {m}
+// {m,} {m,n} et leurs formes paresseuses (même langage). Pas de références
+// arrière ni de \b, qui exigent un retour arrière. Une occurrence ne
+// franchit jamais une fin de ligne: '\n' n'appartient à aucun ensemble.
+// Le motif devient un programme de Thompson, exécuté par des automates
+// déterministes construits à la demande: un état est calculé au premier
+// passage puis gardé dans un cache borné, vidé quand il est plein. Temps
+// linéaire en la taille du texte, quel que soit le motif.
+// Trois automates: l'avant non ancré trouve la fin de la première
+// occurrence, l'arrière ancré son début le plus à gauche, l'avant ancré
+// l'étend à la plus longue. Les littéraux que toute occurrence contient
+// sont cherchés d'abord, comme des termes (memmem_icase, Teddy ou
+// Aho-Corasick): les automates ne lisent que les lignes qui en contiennent.
+#define REGEX_MAX_PROGRAM 20000         // Instructions, répétitions dépliées
+#define REGEX_MAX_REPEAT 1000           // Borne d'un compteur {m,n}
+#define REGEX_MAX_DEPTH 32              // Groupes imbriqués
+#define REGEX_MAX_QUANTIFIERS 4         // Quantificateurs successifs sur un même atome
+#define REGEX_DFA_CACHE_BUDGET (512 * 1024)  // Mémoire des états d'un automate
+#define REGEX_LITERAL_COUNT 8           // Littéraux requis au plus (alternatives)
+#define REGEX_LITERAL_LENGTH 24         // Longueur maximale d'un littéral
+#define REGEX_LITERAL_SET_BYTES 4       // Ensemble vu comme une alternative de littéraux
+#define REGEX_MIN_LITERAL_LENGTH 2      // Plus courts, les littéraux ne filtrent plus assez
+
+// États des automates
+#define REGEX_STATE_MATCH 1             // Une occurrence finit juste après l'octet lu
+#define REGEX_STATE_EOL_MATCH 2         // Une occurrence finirait ici en fin de ligne ($)
+#define REGEX_STATE_MATCH_BEFORE 4      // Entré par '\n': une occurrence finissait avant lui
+#define REGEX_STATE_DEAD 8              // Automate ancré: plus aucune occurrence possible
+#define REGEX_STATE_LINE_START 16       // Aucun octet lu depuis le début de ligne (^ franchissable)
+#define REGEX_STATE_STOP (REGEX_STATE_MATCH | REGEX_STATE_MATCH_BEFORE | REGEX_STATE_DEAD)
+#define REGEX_TRANSITION_UNKNOWN INT32_MIN  // Transition pas encore calculée
+
+typedef struct {
+    uint64_t bits[4];
+} RegexSet;
+
+typedef enum {
+    REGEX_NODE_SET,             // Un octet de l'ensemble
+    REGEX_NODE_LINE_START,      // ^
+    REGEX_NODE_LINE_END,        // $
+    REGEX_NODE_CONCAT,          // Sous-nœuds à la suite (aucun: chaîne vide)
+    REGEX_NODE_ALTERNATE,       // L'un des sous-nœuds
+    REGEX_NODE_REPEAT           // Sous-nœud répété de min à max fois (max < 0: sans borne)
+} RegexNodeType;
+
+typedef struct {
+    RegexNodeType type;
+    int child;                  // Premier sous-nœud (-1: aucun)
+    int next;                   // Nœud suivant du même parent (-1: dernier)
+    int min;
+    int max;
+    int set;                    // Indice de l'ensemble (REGEX_NODE_SET)
+} RegexNode;
+
+typedef struct {
+    const char* pattern;
+    size_t position;
+    RegexNode* nodes;
+    int node_count;
+    int node_capacity;
+    RegexSet* sets;
+    int set_count;
+    int set_capacity;
+    int depth;
+    char* error;                // Premier message d'erreur (optionnel)
+    size_t error_size;
+    bool failed;
+} RegexParser;
+
+typedef enum {
+    REGEX_OP_SET,               // Lit un octet de l'ensemble x
+    REGEX_OP_SPLIT,             // Continue en x et en y
+    REGEX_OP_JUMP,              // Continue en x
+    REGEX_OP_LINE_START,
+    REGEX_OP_LINE_END,
+    REGEX_OP_MATCH
+} RegexOp;
+
+typedef struct {
+    RegexOp op;
+    int x;
+    int y;
+} RegexInst;
+
+// Automate déterministe paresseux sur un programme. Un état est l'ensemble
+// trié des instructions en attente (SET, LINE_END, MATCH) atteintes.
+typedef struct {
+    const RegexInst* program;
+    int program_length;
+    const RegexSet* sets;
+    const unsigned char* classes;       // Octet -> classe
+    const unsigned char* class_bytes;   // Classe -> un octet représentatif
+    int class_count;
+    bool unanchored;            // Une occurrence peut commencer à chaque octet
+    // Cache des états
+    int* leaves;                // Instructions de tous les états, bout à bout
+    size_t leaf_count;
+    size_t leaf_capacity;
+    int* state_leaves;          // Première instruction de chaque état dans leaves
+    int* state_sizes;
+    unsigned char* state_flags;
+    int32_t* transitions;       // Ligne (état * class_count) + classe -> ligne du suivant,
+                                // complémentée (~) s'il est dans REGEX_STATE_STOP
+    int state_count;
+    int state_capacity;
+    int* table;                 // Hachage des états: indice + 1 (0: libre)
+    int table_capacity;         // Puissance de 2, double de state_capacity
+    int starts[2];              // État initial en milieu, en début de ligne (-1: à calculer)
+    unsigned long flushes;      // Vidages du cache
+    // Calcul d'un état
+    int* stack;
+    int* work;
+    int work_count;
+    unsigned int* marks;
+    unsigned int mark;
+} RegexDfa;
+
+struct RegexEngine {
+    RegexSet* sets;
+    RegexInst* forward;
+    RegexInst* reverse;         // Motif lu à l'envers (^ et $ échangés)
+    int program_length;
+    unsigned char classes[256];
+    unsigned char class_bytes[256];
+    int class_count;
+    RegexDfa search;            // Avant, non ancré: fin de la première occurrence
+    RegexDfa backward;          // Arrière, ancré: début le plus à gauche
+    RegexDfa extend;            // Avant, ancré: fin la plus lointaine
+    ContentMatcher* prefilter;  // Littéraux requis (NULL: aucun)
+};
+
+static inline bool regex_set_has(const RegexSet* set, unsigned char c) {
+    return (set->bits[c >> 6] >> (c & 63)) & 1;
+}
+
+// Ajoute c et, pour une lettre, l'autre casse
+static void regex_set_add(RegexSet* set, unsigned char c) {
+    unsigned char lower = ascii_lower(c);
+    unsigned char upper = lower >= 'a' && lower <= 'z' ? (unsigned char)(lower - 'a' + 'A') : lower;
+    set->bits[lower >> 6] |= 1ULL << (lower & 63);
+    set->bits[upper >> 6] |= 1ULL << (upper & 63);
+}
+
+static void regex_set_add_range(RegexSet* set, unsigned char low, unsigned char high) {
+    for (int c = low; c <= high; c++) {
+        regex_set_add(set, (unsigned char)c);
+    }
+}
+
+// Ajoute \d \w \s ou leurs complémentaires \D \W \S; false si c n'en
+// désigne aucun
+static bool regex_set_add_class(RegexSet* set, unsigned char c) {
+    RegexSet class;
+    memset(&class, 0, sizeof(class));
+    switch (c | 0x20) {
+        case 'd':
+            regex_set_add_range(&class, '0', '9');
+            break;
+        case 'w':
+            regex_set_add_range(&class, '0', '9');
+            regex_set_add_range(&class, 'a', 'z');
+            regex_set_add(&class, '_');
+            break;
+        case 's':
+            regex_set_add(&class, ' ');
+            regex_set_add_range(&class, '\t', '\r');
+            break;
+        default:
+            return false;
+    }
+    bool negate = c >= 'A' && c <= 'Z';
+    for (int i = 0; i < 4; i++) {
+        set->bits[i] |= negate ? ~class.bits[i] : class.bits[i];
+    }
+    return true;
+}
+
+static void regex_fail(RegexParser* parser, const char* message) {
+    if (!parser->failed && parser->error && parser->error_size > 0) {
+        snprintf(parser->error, parser->error_size, "%s (position %zu)", message, parser->position + 1);
+    }
+    parser->failed = true;
+}
+
+static int regex_add_node(RegexParser* parser, RegexNodeType type) {
+    if (parser->node_count == parser->node_capacity) {
+        int capacity = parser->node_capacity ? parser->node_capacity * 2 : 32;
+        RegexNode* nodes = (RegexNode*)realloc(parser->nodes, sizeof(RegexNode) * capacity);
+        if (!nodes) {
+            regex_fail(parser, "mémoire insuffisante");
+            return -1;
+        }
+        parser->nodes = nodes;
+        parser->node_capacity = capacity;
+    }
+    
+    RegexNode* node = &parser->nodes[parser->node_count];
+    node->type = type;
+    node->child = -1;
+    node->next = -1;
+    node->min = 0;
+    node->max = 0;
+    node->set = -1;
+    return parser->node_count++;
+}
+
+// Nœud lisant un octet de set ('\n' retiré: une occurrence reste sur sa ligne)
+static int regex_add_set(RegexParser* parser, const RegexSet* set) {
+    if (parser->set_count == parser->set_capacity) {
+        int capacity = parser->set_capacity ? parser->set_capacity * 2 : 16;
+        RegexSet* sets = (RegexSet*)realloc(parser->sets, sizeof(RegexSet) * capacity);
+        if (!sets) {
+            regex_fail(parser, "mémoire insuffisante");
+            return -1;
+        }
+        parser->sets = sets;
+        parser->set_capacity = capacity;
+    }
+    
+    int node = regex_add_node(parser, REGEX_NODE_SET);
+    if (node < 0) return -1;
+    parser->sets[parser->set_count] = *set;
+    parser->sets[parser->set_count].bits['\n' >> 6] &= ~(1ULL << ('\n' & 63));
+    parser->nodes[node].set = parser->set_count++;
+    return node;
+}
+
+// Octet désigné par l'échappement dont la lettre est en position courante;
+// -1 (erreur) s'il n'est pas supporté
+static int regex_parse_escaped_byte(RegexParser* parser) {
+    unsigned char c = (unsigned char)parser->pattern[parser->position];
+    if (c == '\0') {
+        regex_fail(parser, "'\\' en fin d'expression");
+        return -1;
+    }
+    
+    switch (c) {
+        case 't': parser->position++; return '\t';
+        case 'r': parser->position++; return '\r';
+        case 'f': parser->position++; return '\f';
+        case 'v': parser->position++; return '\v';
+        case 'n':
+            regex_fail(parser, "\\n: une occurrence ne franchit pas les lignes");
+            return -1;
+        case 'x': {
+            int value = 0;
+            for (int i = 1; i <= 2; i++) {
+                unsigned char h = ascii_lower((unsigned char)parser->pattern[parser->position + i]);
+                int digit = h >= '0' && h <= '9' ? h - '0' : h >= 'a' && h <= 'f' ? h - 'a' + 10 : -1;
+                if (digit < 0) {
+                    regex_fail(parser, "\\x attend deux chiffres hexadécimaux");
+                    return -1;
+                }
+                value = value * 16 + digit;
+            }
+            parser->position += 3;
+            return value;
+        }
+    }
+    
+    // \b, \1...: retour arrière ou syntaxe inconnue
+    if (isalnum(c)) {
+        regex_fail(parser, "échappement non supporté");
+        return -1;
+    }
+    parser->position++;
+    return c;
+}
+
+// Classe [...] ou [^...], après le '['
+static int regex_parse_class(RegexParser* parser) {
+    RegexSet set;
+    memset(&set, 0, sizeof(set));
+    
+    bool negate = parser->pattern[parser->position] == '^';
+    if (negate) parser->position++;
+    
+    // ']' en tête est un littéral
+    bool first = true;
+    for (;;) {
+        unsigned char c = (unsigned char)parser->pattern[parser->position];
+        if (c == '\0') {
+            regex_fail(parser, "'[' sans ']'");
+            return -1;
+        }
+        if (c == ']' && !first) {
+            parser->position++;
+            break;
+        }
+        first = false;
+        
+        int low;
+        if (c == '\\') {
+            parser->position++;
+            if (regex_set_add_class(&set, (unsigned char)parser->pattern[parser->position])) {
+                parser->position++;
+                continue;
+            }
+            low = regex_parse_escaped_byte(parser);
+            if (low < 0) return -1;
+        } else {
+            low = c;
+            parser->position++;
+        }
+        
+        // Intervalle a-z ('-' en fin de classe est un littéral)
+        int high = low;
+        if (parser->pattern[parser->position] == '-' && parser->pattern[parser->position + 1] != '\0' &&
+            parser->pattern[parser->position + 1] != ']') {
+            parser->position++;
+            if (parser->pattern[parser->position] == '\\') {
+                parser->position++;
+                high = regex_parse_escaped_byte(parser);
+                if (high < 0) return -1;
+            } else {
+                high = (unsigned char)parser->pattern[parser->position++];
+            }
+            if (high < low) {
+                regex_fail(parser, "intervalle inversé");
+                return -1;
+            }
+        }
+        regex_set_add_range(&set, (unsigned char)low, (unsigned char)high);
+    }
+    
+    if (negate) {
+        for (int i = 0; i < 4; i++) {
+            set.bits[i] = ~set.bits[i];
+        }
+    }
+    return regex_add_set(parser, &set);
+}
+
+static int regex_parse_alternation(RegexParser* parser);
+
+static int regex_parse_atom(RegexParser* parser) {
+    unsigned char c = (unsigned char)parser->pattern[parser->position];
+    RegexSet set;
+    memset(&set, 0, sizeof(set));
+    
+    switch (c) {
+        case '(': {
+            parser->position++;
+            if (parser->pattern[parser->position] == '?') {
+                if (parser->pattern[parser->position + 1] != ':') {
+                    regex_fail(parser, "groupe (?...) non supporté");
+                    return -1;
+                }
+                parser->position += 2;
+            }
+            if (++parser->depth > REGEX_MAX_DEPTH) {
+                regex_fail(parser, "trop de groupes imbriqués");
+                return -1;
+            }
+            int node = regex_parse_alternation(parser);
+            if (node < 0) return -1;
+            if (parser->pattern[parser->position] != ')') {
+                regex_fail(parser, "'(' sans ')'");
+                return -1;
+            }
+            parser->position++;
+            parser->depth--;
+            return node;
+        }
+        case '[':
+            parser->position++;
+            return regex_parse_class(parser);
+        case '.':
+            parser->position++;
+            memset(&set, 0xFF, sizeof(set));
+            return regex_add_set(parser, &set);
+        case '^':
+            parser->position++;
+            return regex_add_node(parser, REGEX_NODE_LINE_START);
+        case '$':
+            parser->position++;
+            return regex_add_node(parser, REGEX_NODE_LINE_END);
+        case '*':
+        case '+':
+        case '?':
+            regex_fail(parser, "rien à répéter");
+            return -1;
+        case '\\': {
+            parser->position++;
+            if (regex_set_add_class(&set, (unsigned char)parser->pattern[parser->position])) {
+                parser->position++;
+                return regex_add_set(parser, &set);
+            }
+            int byte = regex_parse_escaped_byte(parser);
+            if (byte < 0) return -1;
+            regex_set_add(&set, (unsigned char)byte);
+            return regex_add_set(parser, &set);
+        }
+        default:
+            parser->position++;
+            regex_set_add(&set, c);
+            return regex_add_set(parser, &set);
+    }
+}
+
+// Compteur {m}, {m,} ou {m,n} en position courante; false sans rien
+// consommer si ce n'en est pas un ('{' est alors un littéral) ou en erreur
+static bool regex_parse_counter(RegexParser* parser, int* min, int* max) {
+    const char* p = parser->pattern + parser->position + 1;
+    if (!isdigit((unsigned char)*p)) return false;
+    
+    long low = 0;
+    while (isdigit((unsigned char)*p)) {
+        if (low <= REGEX_MAX_REPEAT) low = low * 10 + (*p - '0');
+        p++;
+    }
+    long high = low;
+    if (*p == ',') {
+        p++;
+        high = -1;
+        if (isdigit((unsigned char)*p)) {
+            high = 0;
+            while (isdigit((unsigned char)*p)) {
+                if (high <= REGEX_MAX_REPEAT) high = high * 10 + (*p - '0');
+                p++;
+            }
+        }
+    }
+    if (*p != '}') return false;
+    
+    if (low > REGEX_MAX_REPEAT || high > REGEX_MAX_REPEAT) {
+        regex_fail(parser, "répétition trop grande");
+        return false;
+    }
+    if (high >= 0 && high < low) {
+        regex_fail(parser, "répétition {m,n} avec n < m");
+        return false;
+    }
+    parser->position = (size_t)(p + 1 - parser->pattern);
+    *min = (int)low;
+    *max = (int)high;
+    return true;
+}
+
+static int regex_parse_repeat(RegexParser* parser) {
+    int node = regex_parse_atom(parser);
+    
+    for (int quantifiers = 0; node >= 0; quantifiers++) {
+        int min;
+        int max;
+        char c = parser->pattern[parser->position];
+        if (c == '*' || c == '+' || c == '?') {
+            parser->position++;
+            min = c == '+' ? 1 : 0;
+            max = c == '?' ? 1 : -1;
+        } else if (c != '{' || !regex_parse_counter(parser, &min, &max)) {
+            return parser->failed ? -1 : node;
+        }
+        if (quantifiers == REGEX_MAX_QUANTIFIERS) {
+            regex_fail(parser, "trop de répétitions successives");
+            return -1;
+        }
+        
+        // Forme paresseuse: même ensemble d'occurrences
+        if (parser->pattern[parser->position] == '?') {
+            parser->position++;
+        }
+        
+        int repeat = regex_add_node(parser, REGEX_NODE_REPEAT);
+        if (repeat < 0) return -1;
+        parser->nodes[repeat].child = node;
+        parser->nodes[repeat].min = min;
+        parser->nodes[repeat].max = max;
+        node = repeat;
+    }
+    return -1;
+}
+
+static int regex_parse_concat(RegexParser* parser) {
+    int node = regex_add_node(parser, REGEX_NODE_CONCAT);
+    int last = -1;
+    char c;
+    while (node >= 0 && (c = parser->pattern[parser->position]) != '\0' && c != '|' && c != ')') {
+        int item = regex_parse_repeat(parser);
+        if (item < 0) return -1;
+        if (last < 0) {
+            parser->nodes[node].child = item;
+        } else {
+            parser->nodes[last].next = item;
+        }
+        last = item;
+    }
+    return node;
+}
+
+static int regex_parse_alternation(RegexParser* parser) {
+    int first = regex_parse_concat(parser);
+    if (first < 0 || parser->pattern[parser->position] != '|') return first;
+    
+    int node = regex_add_node(parser, REGEX_NODE_ALTERNATE);
+    if (node < 0) return -1;
+    parser->nodes[node].child = first;
+    int last = first;
+    while (parser->pattern[parser->position] == '|') {
+        parser->position++;
+        int item = regex_parse_concat(parser);
+        if (item < 0) return -1;
+        parser->nodes[last].next = item;
+        last = item;
+    }
+    return node;
+}
+
+// Instructions du nœud (plafonné à REGEX_MAX_PROGRAM + 1)
+static long regex_node_size(const RegexParser* parser, int index) {
+    const RegexNode* node = &parser->nodes[index];
+    long size = 0;
+    switch (node->type) {
+        case REGEX_NODE_SET:
+        case REGEX_NODE_LINE_START:
+        case REGEX_NODE_LINE_END:
+            return 1;
+        case REGEX_NODE_CONCAT:
+        case REGEX_NODE_ALTERNATE:
+            for (int child = node->child; child >= 0 && size <= REGEX_MAX_PROGRAM; child = parser->nodes[child].next) {
+                size += regex_node_size(parser, child);
+                // Alternative autre que la dernière: SPLIT devant, JUMP derrière
+                if (node->type == REGEX_NODE_ALTERNATE && parser->nodes[child].next >= 0) size += 2;
+            }
+            break;
+        case REGEX_NODE_REPEAT: {
+            long body = regex_node_size(parser, node->child);
+            size = node->min * body;
+            size += node->max < 0 ? body + 2 : (node->max - node->min) * (body + 1);
+            break;
+        }
+    }
+    return size > REGEX_MAX_PROGRAM ? REGEX_MAX_PROGRAM + 1 : size;
+}
+
+typedef struct {
+    const RegexParser* parser;
+    RegexInst* program;
+    int count;
+    int capacity;
+    bool reverse;
+    bool failed;
+} RegexCompiler;
+
+static int regex_emit_inst(RegexCompiler* compiler, RegexOp op, int x, int y) {
+    if (compiler->count == compiler->capacity) {
+        compiler->failed = true;
+        return compiler->capacity - 1;
+    }
+    compiler->program[compiler->count].op = op;
+    compiler->program[compiler->count].x = x;
+    compiler->program[compiler->count].y = y;
+    return compiler->count++;
+}
+
+static void regex_emit(RegexCompiler* compiler, int index) {
+    const RegexNode* nodes = compiler->parser->nodes;
+    const RegexNode* node = &nodes[index];
+    switch (node->type) {
+        case REGEX_NODE_SET:
+            regex_emit_inst(compiler, REGEX_OP_SET, node->set, 0);
+            break;
+        case REGEX_NODE_LINE_START:
+            regex_emit_inst(compiler, compiler->reverse ? REGEX_OP_LINE_END : REGEX_OP_LINE_START, 0, 0);
+            break;
+        case REGEX_NODE_LINE_END:
+            regex_emit_inst(compiler, compiler->reverse ? REGEX_OP_LINE_START : REGEX_OP_LINE_END, 0, 0);
+            break;
+        case REGEX_NODE_CONCAT: {
+            if (!compiler->reverse) {
+                for (int child = node->child; child >= 0; child = nodes[child].next) {
+                    regex_emit(compiler, child);
+                }
+                break;
+            }
+            int count = 0;
+            for (int child = node->child; child >= 0; child = nodes[child].next) {
+                count++;
+            }
+            int* children = (int*)malloc(sizeof(int) * (count > 0 ? count : 1));
+            if (!children) {
+                compiler->failed = true;
+                break;
+            }
+            count = 0;
+            for (int child = node->child; child >= 0; child = nodes[child].next) {
+                children[count++] = child;
+            }
+            while (count > 0) {
+                regex_emit(compiler, children[--count]);
+            }
+            free(children);
+            break;
+        }
+        case REGEX_NODE_ALTERNATE: {
+            // Sauts vers la fin chaînés par leur cible jusqu'à ce qu'elle soit connue
+            int pending = -1;
+            for (int child = node->child; child >= 0; child = nodes[child].next) {
+                if (nodes[child].next < 0) {
+                    regex_emit(compiler, child);
+                    break;
+                }
+                int split = regex_emit_inst(compiler, REGEX_OP_SPLIT, compiler->count + 1, 0);
+                regex_emit(compiler, child);
+                pending = regex_emit_inst(compiler, REGEX_OP_JUMP, pending, 0);
+                compiler->program[split].y = compiler->count;
+            }
+            while (pending >= 0 && !compiler->failed) {
+                int previous = compiler->program[pending].x;
+                compiler->program[pending].x = compiler->count;
+                pending = previous;
+            }
+            break;
+        }
+        case REGEX_NODE_REPEAT:
+            for (int i = 0; i < node->min; i++) {
+                regex_emit(compiler, node->child);
+            }
+            if (node->max < 0) {
+                int split = regex_emit_inst(compiler, REGEX_OP_SPLIT, compiler->count + 1, 0);
+                regex_emit(compiler, node->child);
+                regex_emit_inst(compiler, REGEX_OP_JUMP, split, 0);
+                compiler->program[split].y = compiler->count;
+            } else {
+                for (int i = node->min; i < node->max; i++) {
+                    int split = regex_emit_inst(compiler, REGEX_OP_SPLIT, compiler->count + 1, 0);
+                    regex_emit(compiler, node->child);
+                    compiler->program[split].y = compiler->count;
+                }
+            }
+            break;
+    }
+}
+
+// Programme du motif (à l'envers si reverse), de length instructions
+static bool regex_compile(const RegexParser* parser, int root, bool reverse, RegexInst* program, int length) {
+    RegexCompiler compiler = { parser, program, 0, length, reverse, false };
+    regex_emit(&compiler, root);
+    regex_emit_inst(&compiler, REGEX_OP_MATCH, 0, 0);
+    return !compiler.failed && compiler.count == length;
+}
+
+// Classes d'octets que le programme ne distingue jamais ('\n' à part);
+// retourne leur nombre
+static int regex_build_classes(const RegexSet* sets, int set_count, unsigned char* classes, unsigned char* class_bytes) {
+    memset(classes, 0, 256);
+    classes['\n'] = 1;
+    int count = 2;
+    
+    // Raffinement par chaque ensemble: (classe, dedans ou non) -> nouvelle classe
+    for (int s = 0; s < set_count; s++) {
+        int inside[256];
+        int outside[256];
+        unsigned char renamed[256];
+        memset(inside, -1, sizeof(int) * count);
+        memset(outside, -1, sizeof(int) * count);
+        int next = 0;
+        for (int c = 0; c < 256; c++) {
+            int* slot = regex_set_has(&sets[s], (unsigned char)c) ? &inside[classes[c]] : &outside[classes[c]];
+            if (*slot < 0) *slot = next++;
+            renamed[c] = (unsigned char)*slot;
+        }
+        memcpy(classes, renamed, 256);
+        count = next;
+    }
+    
+    for (int c = 255; c >= 0; c--) {
+        class_bytes[classes[c]] = (unsigned char)c;
+    }
+    return count;
+}
+
+static bool regex_dfa_init(RegexDfa* dfa, const RegexEngine* engine, const RegexInst* program, bool unanchored) {
+    int length = engine->program_length;
+    dfa->program = program;
+    dfa->program_length = length;
+    dfa->sets = engine->sets;
+    dfa->classes = engine->classes;
+    dfa->class_bytes = engine->class_bytes;
+    dfa->class_count = engine->class_count;
+    dfa->unanchored = unanchored;
+    dfa->starts[0] = -1;
+    dfa->starts[1] = -1;
+    
+    // Toujours de quoi loger un état, même le plus grand
+    dfa->state_capacity = 16;
+    dfa->table_capacity = 32;
+    dfa->leaf_capacity = (size_t)length * 2;
+    dfa->leaves = (int*)malloc(sizeof(int) * dfa->leaf_capacity);
+    dfa->state_leaves = (int*)malloc(sizeof(int) * dfa->state_capacity);
+    dfa->state_sizes = (int*)malloc(sizeof(int) * dfa->state_capacity);
+    dfa->state_flags = (unsigned char*)malloc(dfa->state_capacity);
+    dfa->transitions = (int32_t*)malloc(sizeof(int32_t) * dfa->state_capacity * dfa->class_count);
+    dfa->table = (int*)calloc(dfa->table_capacity, sizeof(int));
+    dfa->stack = (int*)malloc(sizeof(int) * (3 * (size_t)length + 4));
+    dfa->work = (int*)malloc(sizeof(int) * length);
+    dfa->marks = (unsigned int*)calloc(length, sizeof(unsigned int));
+    return dfa->leaves && dfa->state_leaves && dfa->state_sizes && dfa->state_flags &&
+           dfa->transitions && dfa->table && dfa->stack && dfa->work && dfa->marks;
+}
+
+static void regex_dfa_free(RegexDfa* dfa) {
+    free(dfa->leaves);
+    free(dfa->state_leaves);
+    free(dfa->state_sizes);
+    free(dfa->state_flags);
+    free(dfa->transitions);
+    free(dfa->table);
+    free(dfa->stack);
+    free(dfa->work);
+    free(dfa->marks);
+}
+
+static void regex_dfa_next_mark(RegexDfa* dfa) {
+    if (++dfa->mark == 0) {
+        memset(dfa->marks, 0, sizeof(unsigned int) * dfa->program_length);
+        dfa->mark = 1;
+    }
+}
+
+// Ajoute à work les instructions en attente atteintes depuis pc sans lire
+// d'octet; ^ n'est franchi qu'en début de ligne, $ reste en attente
+static void regex_dfa_closure(RegexDfa* dfa, int pc, bool line_start) {
+    int top = 0;
+    dfa->stack[top++] = pc;
+    while (top > 0) {
+        pc = dfa->stack[--top];
+        if (dfa->marks[pc] == dfa->mark) continue;
+        dfa->marks[pc] = dfa->mark;
+        
+        const RegexInst* inst = &dfa->program[pc];
+        switch (inst->op) {
+            case REGEX_OP_SET:
+            case REGEX_OP_LINE_END:
+            case REGEX_OP_MATCH:
+                dfa->work[dfa->work_count++] = pc;
+                break;
+            case REGEX_OP_LINE_START:
+                if (line_start) dfa->stack[top++] = pc + 1;
+                break;
+            case REGEX_OP_JUMP:
+                dfa->stack[top++] = inst->x;
+                break;
+            case REGEX_OP_SPLIT:
+                dfa->stack[top++] = inst->y;
+                dfa->stack[top++] = inst->x;
+                break;
+        }
+    }
+}
+
+// Une occurrence finit-elle en franchissant les $ en attente dans work (et
+// les ^ si la ligne est vide)?
+static bool regex_dfa_match_at_eol(RegexDfa* dfa, bool line_start) {
+    regex_dfa_next_mark(dfa);
+    int top = 0;
+    for (int i = 0; i < dfa->work_count; i++) {
+        if (dfa->program[dfa->work[i]].op == REGEX_OP_LINE_END) {
+            dfa->stack[top++] = dfa->work[i] + 1;
+        }
+    }
+    while (top > 0) {
+        int pc = dfa->stack[--top];
+        if (dfa->marks[pc] == dfa->mark) continue;
+        dfa->marks[pc] = dfa->mark;
+        
+        const RegexInst* inst = &dfa->program[pc];
+        switch (inst->op) {
+            case REGEX_OP_MATCH:
+                return true;
+            case REGEX_OP_LINE_END:
+                dfa->stack[top++] = pc + 1;
+                break;
+            case REGEX_OP_LINE_START:
+                if (line_start) dfa->stack[top++] = pc + 1;
+                break;
+            case REGEX_OP_JUMP:
+                dfa->stack[top++] = inst->x;
+                break;
+            case REGEX_OP_SPLIT:
+                dfa->stack[top++] = inst->y;
+                dfa->stack[top++] = inst->x;
+                break;
+            default:
+                break;
+        }
+    }
+    return false;
+}
+
+static uint32_t regex_dfa_hash(const int* leaves, int count, unsigned char flags) {
+    uint32_t hash = 2166136261u ^ flags;
+    for (int i = 0; i < count; i++) {
+        hash = (hash ^ (uint32_t)leaves[i]) * 16777619u;
+    }
+    return hash;
+}
+
+static void regex_dfa_table_insert(RegexDfa* dfa, int state) {
+    uint32_t mask = (uint32_t)dfa->table_capacity - 1;
+    uint32_t slot = regex_dfa_hash(dfa->leaves + dfa->state_leaves[state], dfa->state_sizes[state], dfa->state_flags[state]) & mask;
+    while (dfa->table[slot]) {
+        slot = (slot + 1) & mask;
+    }
+    dfa->table[slot] = state + 1;
+}
+
+// Oublie tous les états (budget atteint); les tableaux restent alloués
+static void regex_dfa_flush(RegexDfa* dfa) {
+    dfa->state_count = 0;
+    dfa->leaf_count = 0;
+    memset(dfa->table, 0, sizeof(int) * dfa->table_capacity);
+    dfa->starts[0] = -1;
+    dfa->starts[1] = -1;
+    dfa->flushes++;
+}
+
+static size_t regex_dfa_memory(const RegexDfa* dfa, int state_capacity, size_t leaf_capacity) {
+    return leaf_capacity * sizeof(int) +
+           (size_t)state_capacity * (2 * sizeof(int) + 1 + dfa->class_count * sizeof(int32_t) + 2 * sizeof(int));
+}
+
+// Place pour un état de leaf_count instructions: agrandit le cache dans
+// son budget, sinon le vide
+static void regex_dfa_reserve(RegexDfa* dfa, size_t leaf_count) {
+    bool need_state = dfa->state_count == dfa->state_capacity;
+    bool need_leaves = dfa->leaf_count + leaf_count > dfa->leaf_capacity;
+    if (!need_state && !need_leaves) return;
+    
+    int state_capacity = need_state ? dfa->state_capacity * 2 : dfa->state_capacity;
+    size_t leaf_capacity = need_leaves ? dfa->leaf_capacity * 2 : dfa->leaf_capacity;
+    if (regex_dfa_memory(dfa, state_capacity, leaf_capacity) > REGEX_DFA_CACHE_BUDGET) {
+        regex_dfa_flush(dfa);
+        return;
+    }
+    
+    if (need_leaves) {
+        int* leaves = (int*)realloc(dfa->leaves, sizeof(int) * leaf_capacity);
+        if (!leaves) {
+            regex_dfa_flush(dfa);
+            return;
+        }
+        dfa->leaves = leaves;
+        dfa->leaf_capacity = leaf_capacity;
+    }
+    if (need_state) {
+        int* state_leaves = (int*)realloc(dfa->state_leaves, sizeof(int) * state_capacity);
+        if (state_leaves) dfa->state_leaves = state_leaves;
+        int* state_sizes = (int*)realloc(dfa->state_sizes, sizeof(int) * state_capacity);
+        if (state_sizes) dfa->state_sizes = state_sizes;
+        unsigned char* state_flags = (unsigned char*)realloc(dfa->state_flags, state_capacity);
+        if (state_flags) dfa->state_flags = state_flags;
+        int32_t* transitions = (int32_t*)realloc(dfa->transitions, sizeof(int32_t) * state_capacity * dfa->class_count);
+        if (transitions) dfa->transitions = transitions;
+        int* table = (int*)calloc((size_t)state_capacity * 2, sizeof(int));
+        if (!state_leaves || !state_sizes || !state_flags || !transitions || !table) {
+            free(table);
+            regex_dfa_flush(dfa);
+            return;
+        }
+        
+        free(dfa->table);
+        dfa->table = table;
+        dfa->table_capacity = state_capacity * 2;
+        dfa->state_capacity = state_capacity;
+        for (int state = 0; state < dfa->state_count; state++) {
+            regex_dfa_table_insert(dfa, state);
+        }
+    }
+}
+
+static int regex_compare_int(const void* a, const void* b) {
+    int x = *(const int*)a;
+    int y = *(const int*)b;
+    return (x > y) - (x < y);
+}
+
+// État des instructions en attente dans work (créé s'il est nouveau)
+static int regex_dfa_intern(RegexDfa* dfa, unsigned char flags) {
+    int* work = dfa->work;
+    int count = dfa->work_count;
+    qsort(work, count, sizeof(int), regex_compare_int);
+    
+    bool line_end = false;
+    for (int i = 0; i < count; i++) {
+        RegexOp op = dfa->program[work[i]].op;
+        if (op == REGEX_OP_MATCH) flags |= REGEX_STATE_MATCH | REGEX_STATE_EOL_MATCH;
+        if (op == REGEX_OP_LINE_END) line_end = true;
+    }
+    if (line_end && !(flags & REGEX_STATE_EOL_MATCH) && regex_dfa_match_at_eol(dfa, flags & REGEX_STATE_LINE_START)) {
+        flags |= REGEX_STATE_EOL_MATCH;
+    }
+    if (count == 0 && !dfa->unanchored) {
+        flags |= REGEX_STATE_DEAD;
+    }
+    
+    uint32_t mask = (uint32_t)dfa->table_capacity - 1;
+    for (uint32_t slot = regex_dfa_hash(work, count, flags) & mask; dfa->table[slot]; slot = (slot + 1) & mask) {
+        int state = dfa->table[slot] - 1;
+        if (dfa->state_flags[state] == flags && dfa->state_sizes[state] == count &&
+            memcmp(dfa->leaves + dfa->state_leaves[state], work, sizeof(int) * count) == 0) {
+            return state;
+        }
+    }
+    
+    regex_dfa_reserve(dfa, (size_t)count);
+    int state = dfa->state_count++;
+    dfa->state_leaves[state] = (int)dfa->leaf_count;
+    dfa->state_sizes[state] = count;
+    dfa->state_flags[state] = flags;
+    memcpy(dfa->leaves + dfa->leaf_count, work, sizeof(int) * count);
+    dfa->leaf_count += (size_t)count;
+    int32_t* row = dfa->transitions + (size_t)state * dfa->class_count;
+    for (int cls = 0; cls < dfa->class_count; cls++) {
+        row[cls] = REGEX_TRANSITION_UNKNOWN;
+    }
+    regex_dfa_table_insert(dfa, state);
+    return state;
+}
+
+// Calcule la transition de state par la classe cls (puis la garde)
+static int regex_dfa_step(RegexDfa* dfa, int state, int cls) {
+    unsigned char byte = dfa->class_bytes[cls];
+    unsigned char flags = 0;
+    regex_dfa_next_mark(dfa);
+    dfa->work_count = 0;
+    
+    if (byte == '\n') {
+        // Fin de ligne: les $ en attente sont franchis, tout recommence
+        flags = REGEX_STATE_LINE_START;
+        if (dfa->state_flags[state] & REGEX_STATE_EOL_MATCH) {
+            flags |= REGEX_STATE_MATCH_BEFORE;
+        }
+        if (dfa->unanchored) {
+            regex_dfa_closure(dfa, 0, true);
+        }
+    } else {
+        const int* leaves = dfa->leaves + dfa->state_leaves[state];
+        for (int i = 0; i < dfa->state_sizes[state]; i++) {
+            const RegexInst* inst = &dfa->program[leaves[i]];
+            if (inst->op == REGEX_OP_SET && regex_set_has(&dfa->sets[inst->x], byte)) {
+                regex_dfa_closure(dfa, leaves[i] + 1, false);
+            }
+        }
+        if (dfa->unanchored) {
+            regex_dfa_closure(dfa, 0, false);
+        }
+    }
+    
+    // Un vidage du cache pendant le calcul a emporté state
+    unsigned long flushes = dfa->flushes;
+    int next = regex_dfa_intern(dfa, flags);
+    if (dfa->flushes == flushes) {
+        int32_t row = next * dfa->class_count;
+        dfa->transitions[(size_t)state * dfa->class_count + cls] = dfa->state_flags[next] & REGEX_STATE_STOP ? ~row : row;
+    }
+    return next;
+}
+
+static inline int regex_dfa_next(RegexDfa* dfa, int state, unsigned char byte) {
+    int cls = dfa->classes[byte];
+    int32_t next = dfa->transitions[(size_t)state * dfa->class_count + cls];
+    if (next == REGEX_TRANSITION_UNKNOWN) return regex_dfa_step(dfa, state, cls);
+    return (next < 0 ? ~next : next) / dfa->class_count;
+}
+
+static int regex_dfa_start(RegexDfa* dfa, bool line_start) {
+    int state = dfa->starts[line_start];
+    if (state >= 0) return state;
+    
+    regex_dfa_next_mark(dfa);
+    dfa->work_count = 0;
+    regex_dfa_closure(dfa, 0, line_start);
+    state = regex_dfa_intern(dfa, line_start ? REGEX_STATE_LINE_START : 0);
+    dfa->starts[line_start] = state;
+    return state;
+}
+
+// Fin de la première occurrence qui finit dans text[begin, end) (begin
+// commence une ligne si starts_line, end en finit une si ends_line); -1 si aucune
+static long regex_earliest_end(RegexDfa* dfa, const unsigned char* text, size_t begin, size_t end, bool starts_line, bool ends_line) {
+    int state = regex_dfa_start(dfa, starts_line);
+    if (dfa->state_flags[state] & REGEX_STATE_MATCH) return (long)begin;
+    
+    // Boucle rapide sur les lignes de la table; en sortent seulement les
+    // états qui arrêtent la lecture et les transitions à calculer
+    const unsigned char* classes = dfa->classes;
+    const int32_t* transitions = dfa->transitions;
+    int class_count = dfa->class_count;
+    int32_t row = state * class_count;
+    for (size_t i = begin; i < end; i++) {
+        int32_t next = transitions[row + classes[text[i]]];
+        if (next >= 0) {
+            row = next;
+            continue;
+        }
+        
+        if (next == REGEX_TRANSITION_UNKNOWN) {
+            state = regex_dfa_step(dfa, row / class_count, classes[text[i]]);
+            transitions = dfa->transitions;
+        } else {
+            state = ~next / class_count;
+        }
+        unsigned char flags = dfa->state_flags[state];
+        if (flags & (REGEX_STATE_MATCH | REGEX_STATE_MATCH_BEFORE)) {
+            return (long)(flags & REGEX_STATE_MATCH_BEFORE ? i : i + 1);
+        }
+        row = state * class_count;
+    }
+    if (ends_line && (dfa->state_flags[row / class_count] & REGEX_STATE_EOL_MATCH)) return (long)end;
+    return -1;
+}
+
+// Début le plus à gauche d'une occurrence finissant en end (lecture arrière)
+static size_t regex_leftmost_start(RegexDfa* dfa, const unsigned char* text, size_t length, size_t end, bool starts_line, bool ends_line) {
+    bool line_end = end == length ? ends_line : text[end] == '\n';
+    int state = regex_dfa_start(dfa, line_end);
+    size_t best = end;
+    
+    for (size_t i = end; i > 0; i--) {
+        if (text[i - 1] == '\n') {
+            if (dfa->state_flags[state] & REGEX_STATE_EOL_MATCH) best = i;
+            return best;
+        }
+        state = regex_dfa_next(dfa, state, text[i - 1]);
+        unsigned char flags = dfa->state_flags[state];
+        if (flags & REGEX_STATE_DEAD) return best;
+        if (flags & REGEX_STATE_MATCH) best = i - 1;
+    }
+    if (starts_line && (dfa->state_flags[state] & REGEX_STATE_EOL_MATCH)) best = 0;
+    return best;
+}
+
+// Fin la plus lointaine d'une occurrence commençant en start (au moins end)
+static size_t regex_longest_end(RegexDfa* dfa, const unsigned char* text, size_t length, size_t start, size_t end, bool starts_line, bool ends_line) {
+    bool line_start = start == 0 ? starts_line : text[start - 1] == '\n';
+    int state = regex_dfa_start(dfa, line_start);
+    size_t best = end;
+    
+    for (size_t i = start; i < length; i++) {
+        if (text[i] == '\n') {
+            if ((dfa->state_flags[state] & REGEX_STATE_EOL_MATCH) && i > best) best = i;
+            return best;
+        }
+        state = regex_dfa_next(dfa, state, text[i]);
+        unsigned char flags = dfa->state_flags[state];
+        if (flags & REGEX_STATE_DEAD) return best;
+        if ((flags & REGEX_STATE_MATCH) && i + 1 > best) best = i + 1;
+    }
+    if (ends_line && (dfa->state_flags[state] & REGEX_STATE_EOL_MATCH) && length > best) best = length;
+    return best;
+}
+
+// Occurrence retenue: la première à finir, prise à son début le plus à
+// gauche puis étendue à sa fin la plus lointaine
+static const unsigned char* regex_engine_find(RegexEngine* engine, const unsigned char* text, size_t length, bool starts_line, bool ends_line, size_t* match_length) {
+    long end = -1;
+    if (engine->prefilter) {
+        // Seules les lignes contenant un littéral requis peuvent correspondre
+        size_t position = 0;
+        while (end < 0 && position < length) {
+            const char* literal = content_matcher_find(engine->prefilter, (const char*)text + position, length - position, NULL, NULL);
+            if (!literal) return NULL;
+            
+            size_t line_begin = (size_t)((const unsigned char*)literal - text);
+            while (line_begin > position && text[line_begin - 1] != '\n') {
+                line_begin--;
+            }
+            const unsigned char* newline = (const unsigned char*)memchr(literal, '\n', length - (size_t)((const unsigned char*)literal - text));
+            size_t line_end = newline ? (size_t)(newline - text) : length;
+            end = regex_earliest_end(&engine->search, text, line_begin, line_end,
+                                     line_begin > 0 || starts_line, newline != NULL || ends_line);
+            position = line_end + 1;
+        }
+    } else {
+        end = regex_earliest_end(&engine->search, text, 0, length, starts_line, ends_line);
+    }
+    if (end < 0) return NULL;
+    
+    size_t start = regex_leftmost_start(&engine->backward, text, length, (size_t)end, starts_line, ends_line);
+    size_t stop = regex_longest_end(&engine->extend, text, length, start, (size_t)end, starts_line, ends_line);
+    *match_length = stop - start;
+    return text + start;
+}
+
+// Ensemble de chaînes (en minuscules)
+typedef struct {
+    int count;                  // -1: inconnu (indéterminé, trop de chaînes ou trop longues)
+    unsigned char lengths[REGEX_LITERAL_COUNT];
+    unsigned char text[REGEX_LITERAL_COUNT][REGEX_LITERAL_LENGTH];
+} RegexLiterals;
+
+static void regex_literals_unknown(RegexLiterals* literals) {
+    literals->count = -1;
+}
+
+// La seule chaîne vide
+static void regex_literals_empty(RegexLiterals* literals) {
+    literals->count = 1;
+    literals->lengths[0] = 0;
+}
+
+static void regex_literals_add(RegexLiterals* literals, const unsigned char* text, size_t length) {
+    if (literals->count < 0) return;
+    if (length > REGEX_LITERAL_LENGTH) {
+        literals->count = -1;
+        return;
+    }
+    for (int i = 0; i < literals->count; i++) {
+        if (literals->lengths[i] == length && memcmp(literals->text[i], text, length) == 0) return;
+    }
+    if (literals->count == REGEX_LITERAL_COUNT) {
+        literals->count = -1;
+        return;
+    }
+    memcpy(literals->text[literals->count], text, length);
+    literals->lengths[literals->count++] = (unsigned char)length;
+}
+
+// Chaque chaîne de a suivie de chaque chaîne de b
+static void regex_literals_cross(const RegexLiterals* a, const RegexLiterals* b, RegexLiterals* out) {
+    out->count = a->count < 0 || b->count < 0 ? -1 : 0;
+    for (int i = 0; out->count >= 0 && i < a->count; i++) {
+        for (int j = 0; out->count >= 0 && j < b->count; j++) {
+            size_t length = (size_t)a->lengths[i] + b->lengths[j];
+            if (length > REGEX_LITERAL_LENGTH) {
+                out->count = -1;
+                break;
+            }
+            unsigned char text[REGEX_LITERAL_LENGTH];
+            memcpy(text, a->text[i], a->lengths[i]);
+            memcpy(text + a->lengths[i], b->text[j], b->lengths[j]);
+            regex_literals_add(out, text, length);
+        }
+    }
+}
+
+static void regex_literals_union(const RegexLiterals* a, const RegexLiterals* b, RegexLiterals* out) {
+    *out = *a;
+    if (b->count < 0) out->count = -1;
+    for (int j = 0; out->count >= 0 && j < b->count; j++) {
+        regex_literals_add(out, b->text[j], b->lengths[j]);
+    }
+}
+
+// Longueur de la plus courte chaîne (0: inutilisable comme filtre)
+static size_t regex_literals_shortest(const RegexLiterals* literals) {
+    if (literals->count <= 0) return 0;
+    size_t shortest = REGEX_LITERAL_LENGTH;
+    for (int i = 0; i < literals->count; i++) {
+        if (literals->lengths[i] < shortest) shortest = literals->lengths[i];
+    }
+    return shortest;
+}
+
+// Meilleur filtre: la plus courte chaîne la plus longue, puis le moins de chaînes
+static const RegexLiterals* regex_literals_better(const RegexLiterals* a, const RegexLiterals* b) {
+    size_t shortest_a = regex_literals_shortest(a);
+    size_t shortest_b = regex_literals_shortest(b);
+    if (shortest_a != shortest_b) return shortest_a > shortest_b ? a : b;
+    return shortest_b > 0 && b->count < a->count ? b : a;
+}
+
+// exact: chaînes exactement reconnues par le nœud; required: toute
+// occurrence du nœud contient l'une d'elles
+static void regex_literals_analyze(const RegexParser* parser, int index, RegexLiterals* exact, RegexLiterals* required) {
+    const RegexNode* node = &parser->nodes[index];
+    RegexLiterals child_exact;
+    RegexLiterals child_required;
+    RegexLiterals merged;
+    regex_literals_unknown(required);
+    
+    switch (node->type) {
+        case REGEX_NODE_SET: {
+            // Quelques octets (à la casse près): autant de chaînes d'un octet
+            const RegexSet* set = &parser->sets[node->set];
+            exact->count = 0;
+            for (int c = 0; c < 256 && exact->count >= 0; c++) {
+                if (!regex_set_has(set, (unsigned char)c) || (c >= 'A' && c <= 'Z')) continue;
+                unsigned char byte = (unsigned char)c;
+                if (exact->count == REGEX_LITERAL_SET_BYTES) {
+                    exact->count = -1;
+                } else {
+                    regex_literals_add(exact, &byte, 1);
+                }
+            }
+            if (exact->count == 0) exact->count = -1;
+            break;
+        }
+        case REGEX_NODE_LINE_START:
+        case REGEX_NODE_LINE_END:
+            regex_literals_empty(exact);
+            break;
+        case REGEX_NODE_CONCAT: {
+            // run: chaînes de la dernière suite de sous-nœuds exacts, toujours
+            // contenues dans une occurrence
+            RegexLiterals run;
+            regex_literals_empty(&run);
+            bool whole = true;
+            for (int child = node->child; child >= 0; child = parser->nodes[child].next) {
+                regex_literals_analyze(parser, child, &child_exact, &child_required);
+                regex_literals_cross(&run, &child_exact, &merged);
+                if (merged.count >= 0) {
+                    run = merged;
+                } else {
+                    whole = false;
+                    if (child_exact.count >= 0) {
+                        run = child_exact;
+                    } else {
+                        regex_literals_empty(&run);
+                    }
+                }
+                *required = *regex_literals_better(required, &child_required);
+                *required = *regex_literals_better(required, &run);
+            }
+            if (whole) {
+                *exact = run;
+            } else {
+                regex_literals_unknown(exact);
+            }
+            break;
+        }
+        case REGEX_NODE_ALTERNATE: {
+            bool first = true;
+            for (int child = node->child; child >= 0; child = parser->nodes[child].next) {
+                regex_literals_analyze(parser, child, &child_exact, &child_required);
+                const RegexLiterals* best = regex_literals_better(&child_required, &child_exact);
+                if (first) {
+                    *exact = child_exact;
+                    *required = *best;
+                    first = false;
+                    continue;
+                }
+                regex_literals_union(exact, &child_exact, &merged);
+                *exact = merged;
+                regex_literals_union(required, best, &merged);
+                *required = merged;
+            }
+            break;
+        }
+        case REGEX_NODE_REPEAT:
+            regex_literals_analyze(parser, node->child, &child_exact, &child_required);
+            regex_literals_unknown(exact);
+            if (node->min == 0) {
+                if (node->max == 1 && child_exact.count >= 0) {
+                    *exact = child_exact;
+                    regex_literals_add(exact, (const unsigned char*)"", 0);
+                }
+                break;
+            }
+            *required = *regex_literals_better(&child_required, &child_exact);
+            if (node->min == node->max && node->min <= REGEX_LITERAL_SET_BYTES) {
+                regex_literals_empty(exact);
+                for (int i = 0; i < node->min && exact->count >= 0; i++) {
+                    regex_literals_cross(exact, &child_exact, &merged);
+                    *exact = merged;
+                }
+            }
+            break;
+    }
+    *required = *regex_literals_better(required, exact);
+}
+
+// Vide les caches des automates: une lecture interrompue en plein pas
+// (fenêtre projetée tronquée) ne laisse pas d'état à moitié construit
+static void regex_engine_flush(RegexEngine* engine) {
+    regex_dfa_flush(&engine->search);
+    regex_dfa_flush(&engine->backward);
+    regex_dfa_flush(&engine->extend);
+}
+
+static void regex_engine_destroy(RegexEngine* engine) {
+    if (!engine) return;
+    regex_dfa_free(&engine->search);
+    regex_dfa_free(&engine->backward);
+    regex_dfa_free(&engine->extend);
+    content_matcher_destroy(engine->prefilter);
+    free(engine->sets);
+    free(engine->forward);
+    free(engine->reverse);
+    free(engine);
+}
+
+// Programmes, automates et filtre d'un motif analysé de length instructions
+static RegexEngine* regex_engine_build(const RegexParser* parser, int root, int length) {
+    RegexEngine* engine = (RegexEngine*)calloc(1, sizeof(RegexEngine));
+    if (!engine) return NULL;
+    
+    engine->program_length = length;
+    engine->sets = (RegexSet*)malloc(sizeof(RegexSet) * (parser->set_count > 0 ? parser->set_count : 1));
+    engine->forward = (RegexInst*)malloc(sizeof(RegexInst) * length);
+    engine->reverse = (RegexInst*)malloc(sizeof(RegexInst) * length);
+    if (!engine->sets || !engine->forward || !engine->reverse ||
+        !regex_compile(parser, root, false, engine->forward, length) ||
+        !regex_compile(parser, root, true, engine->reverse, length)) {
+        regex_engine_destroy(engine);
+        return NULL;
+    }
+    if (parser->set_count > 0) {
+        memcpy(engine->sets, parser->sets, sizeof(RegexSet) * parser->set_count);
+    }
+    engine->class_count = regex_build_classes(engine->sets, parser->set_count, engine->classes, engine->class_bytes);
+    
+    if (!regex_dfa_init(&engine->search, engine, engine->forward, true) ||
+        !regex_dfa_init(&engine->backward, engine, engine->reverse, false) ||
+        !regex_dfa_init(&engine->extend, engine, engine->forward, false)) {
+        regex_engine_destroy(engine);
+        return NULL;
+    }
+    
+    // Filtre: sans lui (littéraux trop courts), l'automate lit tout le texte
+    RegexLiterals exact;
+    RegexLiterals required;
+    regex_literals_analyze(parser, root, &exact, &required);
+    if (regex_literals_shortest(&required) >= REGEX_MIN_LITERAL_LENGTH) {
+        ContentMatcher* prefilter = content_matcher_alloc(required.count);
+        for (int i = 0; prefilter && i < required.count; i++) {
+            if (!content_matcher_add_pattern(prefilter, (const char*)required.text[i], required.lengths[i])) {
+                content_matcher_destroy(prefilter);
+                prefilter = NULL;
+            }
+        }
+        engine->prefilter = prefilter ? content_matcher_compile(prefilter) : NULL;
+    }
+    return engine;
+}
+
+ContentMatcher* content_matcher_create_regex(const char* pattern, char* error, size_t error_size) {
+    if (error && error_size > 0) error[0] = '\0';
+    if (!pattern || !pattern[0]) return NULL;
+    
+    RegexParser parser;
+    memset(&parser, 0, sizeof(parser));
+    parser.pattern = pattern;
+    parser.error = error;
+    parser.error_size = error_size;
+    
+    int root = regex_parse_alternation(&parser);
+    if (!parser.failed && parser.pattern[parser.position] == ')') {
+        regex_fail(&parser, "')' sans '('");
+    }
+    long length = parser.failed ? 0 : regex_node_size(&parser, root) + 1;
+    if (!parser.failed && length > REGEX_MAX_PROGRAM) {
+        regex_fail(&parser, "expression trop grande");
+    }
+    
+    RegexEngine* engine = parser.failed ? NULL : regex_engine_build(&parser, root, (int)length);
+    ContentMatcher* matcher = engine ? (ContentMatcher*)calloc(1, sizeof(ContentMatcher)) : NULL;
+    if (!parser.failed && !matcher) {
+        regex_fail(&parser, "mémoire insuffisante");
+        regex_engine_destroy(engine);
+    }
+    free(parser.nodes);
+    free(parser.sets);
+    if (!matcher) return NULL;
+    
+    // Pas de bornes sur la longueur d'une occurrence: les fenêtres se
+    // recouvrent de CONTENT_REGEX_MAX_SPAN octets
+    matcher->regex = engine;
+    matcher->pattern_count = 1;
+    matcher->max_length = CONTENT_REGEX_MAX_SPAN;
+    return matcher;
+}
+
+// === Recherche par contenu ===
+// Compteurs locaux d'un lecteur (versés par lots au SearchRun) et
+// annulation, vue entre deux blocs ou fenêtres: l'arrêt ne dépend pas de
+// la taille du fichier en cours.
+typedef struct {
+    SearchRun* run;             // Destination des compteurs (NULL: aucune)
+    const atomic_bool* cancel;  // NULL: jamais annulée
+    size_t max_size;            // Fichiers plus gros non lus (0: aucune limite)
+    long long bytes_read;
+    int files_binary;
+    int files_oversized;
+} ContentScan;
+
+static bool content_scan_cancelled(const ContentScan* scan) {
+    return scan->cancel && atomic_load_explicit(scan->cancel, memory_order_relaxed);
+}
+
+// Verse les compteurs locaux d'un lecteur dans ceux de la recherche
+static void content_scan_flush(ContentScan* scan) {
+    if (!scan->run) return;
+    atomic_fetch_add_explicit(&scan->run->bytes_read, scan->bytes_read, memory_order_relaxed);
+    atomic_fetch_add_explicit(&scan->run->files_binary, scan->files_binary, memory_order_relaxed);
+    atomic_fetch_add_explicit(&scan->run->files_oversized, scan->files_oversized, memory_order_relaxed);
+    scan->bytes_read = 0;
+    scan->files_binary = 0;
+    scan->files_oversized = 0;
+}
+
+// Texte ou binaire, d'après les premiers octets du fichier
+static bool content_looks_binary(const unsigned char* data, size_t length) {
+    size_t check_size = length < 512 ? length : 512;
+    for (size_t i = 0; i < check_size; i++) {
+        unsigned char c = data[i];
+        if (c < 32 && c != '\n' && c != '\r' && c != '\t') {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Complète une occurrence trouvée en found dans data, qui commence à
+// l'octet data_offset du fichier; lines: fins de ligne avant data_offset,
+// comptées par la lecture au fil des fenêtres
+static void content_match_locate(ContentMatch* match, const char* data, size_t data_offset, long lines, const char* found, size_t length, int pattern) {
+    match->offset = (long)(data_offset + (size_t)(found - data));
+    match->length = (int)length;
+    match->pattern = pattern;
+    match->line = (int)(lines + content_count_lines(data, (size_t)(found - data)) + 1);
+}
+
+// L'octet offset d'un fichier commence-t-il une ligne? Seule une expression
+// régulière (^) en dépend: l'octet précédent n'est relu que pour elle.
+static bool content_line_starts_at(const ContentMatcher* matcher, int fd, size_t offset) {
+    if (offset == 0 || !matcher->regex) return true;
+    char previous;
+    return pread(fd, &previous, 1, (off_t)(offset - 1)) == 1 && previous == '\n';
+}
+
+// Repli sans mmap: lecture par blocs dans un tampon fixe, à partir de
+// l'octet start (lines: fins de ligne avant lui); les max_length - 1 derniers
+// octets d'un bloc sont conservés devant le suivant pour ne pas manquer une
+// occurrence à cheval.
+static bool search_content_streaming(int fd, size_t file_size, size_t start, long lines, ContentMatcher* matcher, ContentScan* scan, ContentMatch* match) {
+    size_t overlap = matcher->max_length - 1;
+    size_t capacity = CONTENT_SEARCH_READ_BUFFER;
+    if (capacity < 2 * matcher->max_length) {
+        capacity = 2 * matcher->max_length;
+    }
+    char* buffer = (char*)malloc(capacity);
+    if (!buffer) return false;
+    
+    bool found = false;
+    bool first_block = start == 0;
+    size_t buffer_offset = start;   // Position de buffer[0] dans le fichier
+    size_t kept = 0;
+    while (!content_scan_cancelled(scan)) {
+        ssize_t bytes_read = read(fd, buffer + kept, capacity - kept);
+        if (bytes_read < 0 && errno == EINTR) continue;
+        if (bytes_read <= 0) break;
+        scan->bytes_read += bytes_read;
+        
+        size_t length = kept + (size_t)bytes_read;
+        if (first_block) {
+            if (content_looks_binary((const unsigned char*)buffer, length)) {
+                scan->files_binary++;
+                break;
+            }
+            first_block = false;
+        }
+        size_t match_length;
+        int pattern;
+        const char* position = content_matcher_find_window(matcher, buffer, length,
+                                                           content_line_starts_at(matcher, fd, buffer_offset),
+                                                           buffer_offset + length >= file_size, &match_length, &pattern);
+        if (position) {
+            content_match_locate(match, buffer, buffer_offset, lines, position, match_length, pattern);
+            found = true;
+            break;
+        }
+        
+        kept = overlap < length ? overlap : length;
+        lines += content_count_lines(buffer, length - kept);
+        memmove(buffer, buffer + length - kept, kept);
+        buffer_offset += length - kept;
+    }
+    
+    free(buffer);
+    return found;
+}
+
+// Un fichier tronqué pendant la lecture de sa fenêtre projetée lève SIGBUS
+// sur les pages disparues. Le gestionnaire, installé une fois, ramène le
+// thread dans search_content_fd s'il lit une fenêtre (content_window_guard),
+// sinon rétablit le comportement précédent pour la faute suivante.
+static _Thread_local sigjmp_buf* volatile content_window_guard = NULL;
+static struct sigaction content_previous_sigbus;
+static pthread_once_t content_sigbus_once = PTHREAD_ONCE_INIT;
+
+static void content_sigbus_handler(int signal_number, siginfo_t* info, void* context) {
+    (void)signal_number;
+    (void)info;
+    (void)context;
+    sigjmp_buf* guard = content_window_guard;
+    if (guard) {
+        siglongjmp(*guard, 1);
+    }
+    // Hors fenêtre: l'instruction fautive est rejouée avec l'ancien traitement
+    struct sigaction previous = content_previous_sigbus;
+    if (!(previous.sa_flags & SA_SIGINFO) && previous.sa_handler == SIG_IGN) {
+        previous.sa_handler = SIG_DFL;
+    }
+    sigaction(SIGBUS, &previous, NULL);
+}
+
+static void content_sigbus_install(void) {
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_sigaction = content_sigbus_handler;
+    action.sa_flags = SA_SIGINFO;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGBUS, &action, &content_previous_sigbus);
+}
+
+// Lecture d'une fenêtre projetée
+typedef enum {
+    CONTENT_WINDOW_NONE,        // Aucune occurrence
+    CONTENT_WINDOW_FOUND,       // *match complété
+    CONTENT_WINDOW_BINARY,      // Début du fichier binaire
+    CONTENT_WINDOW_TRUNCATED    // Fichier tronqué pendant la lecture (SIGBUS)
+} ContentWindowResult;
+
+// Cherche dans la fenêtre de length octets projetée depuis l'octet offset.
+// Sans occurrence, *lines reçoit les fins de ligne de la fenêtre si une
+// autre la suit.
+static ContentWindowResult search_content_window(int fd, const char* window, size_t offset, size_t length, size_t file_size, long* lines, ContentMatcher* matcher, ContentMatch* match) {
+    size_t match_length;
+    int pattern;
+    const char* position;
+    if (offset == 0 && content_looks_binary((const unsigned char*)window, length)) {
+        return CONTENT_WINDOW_BINARY;
+    }
+    position = content_matcher_find_window(matcher, window, length, content_line_starts_at(matcher, fd, offset),
+                                           offset + length == file_size, &match_length, &pattern);
+    if (position) {
+        content_match_locate(match, window, offset, *lines, position, match_length, pattern);
+        return CONTENT_WINDOW_FOUND;
+    }
+    if (offset + CONTENT_SEARCH_WINDOW < file_size) {
+        *lines += content_count_lines(window, CONTENT_SEARCH_WINDOW);
+    }
+    return CONTENT_WINDOW_NONE;
+}
+
+// search_content_window sous la garde de SIGBUS (window volatile:
+// -Wclobbered)
+static ContentWindowResult search_content_window_guarded(int fd, const char* volatile window, size_t offset, size_t length, size_t file_size, long* lines, ContentMatcher* matcher, ContentMatch* match) {
+    sigjmp_buf guard;
+    if (sigsetjmp(guard, 1) != 0) {
+        content_window_guard = NULL;
+        if (matcher->regex) {
+            regex_engine_flush(matcher->regex);
+        }
+        return CONTENT_WINDOW_TRUNCATED;
+    }
+    content_window_guard = &guard;
+    ContentWindowResult result = search_content_window(fd, window, offset, length, file_size, lines, matcher, match);
+    content_window_guard = NULL;
+    return result;
+}
+
+// Recherche dans un fichier ouvert à partir de start (multiple de la taille
+// de page; le test binaire ne porte que sur le début du fichier), précédé de
+// lines fins de ligne. Fenêtres de CONTENT_SEARCH_WINDOW octets projetées
+// tour à tour: la mémoire ne dépend pas de la taille du fichier. Chaque
+// fenêtre déborde de max_length - 1 octets sur la suivante (occurrences à
+// cheval); ses lignes ne sont comptées que si une fenêtre la suit.
+static bool search_content_fd(int fd, size_t file_size, size_t start, long lines, ContentMatcher* matcher, ContentScan* scan, ContentMatch* match) {
+#ifdef POSIX_FADV_SEQUENTIAL
+    posix_fadvise(fd, (off_t)start, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+    pthread_once(&content_sigbus_once, content_sigbus_install);
+    
+    bool found = false;
+    for (size_t offset = start; offset < file_size && !content_scan_cancelled(scan); offset += CONTENT_SEARCH_WINDOW) {
+        size_t length = file_size - offset;
+        if (length > CONTENT_SEARCH_WINDOW + matcher->max_length - 1) {
+            length = CONTENT_SEARCH_WINDOW + matcher->max_length - 1;
+        }
+        if (length < matcher->min_length) break;
+        
+        void* window = mmap(NULL, length, PROT_READ, MAP_PRIVATE, fd, (off_t)offset);
+        if (window == MAP_FAILED) {
+            // Système de fichiers sans mmap: lecture en flux depuis cette fenêtre
+            found = lseek(fd, (off_t)offset, SEEK_SET) == (off_t)offset &&
+                    search_content_streaming(fd, file_size, offset, lines, matcher, scan, match);
+            break;
+        }
+#ifdef MADV_SEQUENTIAL
+        madvise(window, length, MADV_SEQUENTIAL);
+#endif
+        
+        ContentWindowResult result = search_content_window_guarded(fd, (const char*)window, offset, length, file_size, &lines, matcher, match);
+        munmap(window, length);
+        found = result == CONTENT_WINDOW_FOUND;
+        
+        // Octets parcourus: jusqu'à l'occurrence, sinon la fenêtre sans son débord.
+        // Tronqué depuis fstat: le reste du fichier n'existe plus.
+        if (result == CONTENT_WINDOW_BINARY) {
+            scan->files_binary++;
+        } else if (found) {
+            scan->bytes_read += (match->offset - (long)offset) + match->length;
+        } else if (result == CONTENT_WINDOW_NONE) {
+            scan->bytes_read += length < CONTENT_SEARCH_WINDOW ? length : CONTENT_SEARCH_WINDOW;
+        }
+        
+        // Gros fichier: le débit reste visible pendant sa lecture
+        if (scan->bytes_read >= CONTENT_SEARCH_WINDOW) {
+            content_scan_flush(scan);
+        }
+        if (result != CONTENT_WINDOW_NONE) break;
+    }
+    
+    return found;
+}
+
+// Cherche dans un fichier régulier; *st reçoit ses métadonnées et *match la
+// première occurrence si trouvé
+static bool content_scan_file(ContentScan* scan, const char* file_path, ContentMatcher* matcher, struct stat* st, ContentMatch* match) {
+    // O_NONBLOCK: ne pas rester bloqué sur un FIFO avant d'avoir vérifié le type
+    int fd = open(file_path, O_RDONLY | O_CLOEXEC | O_NOCTTY | O_NONBLOCK);
+    if (fd < 0) return false;
+    
+    bool found = false;
+    if (fstat(fd, st) == 0 && S_ISREG(st->st_mode) && st->st_size > 0) {
+        if (scan->max_size > 0 && (size_t)st->st_size > scan->max_size) {
+            scan->files_oversized++;
+        } else {
+            found = search_content_fd(fd, (size_t)st->st_size, 0, 0, matcher, scan, match);
+        }
+    }
+    
+    close(fd);
+    return found;
+}
+
+bool content_matcher_search_file(ContentMatcher* matcher, const char* file_path, ContentMatch* match) {
+    if (!matcher || !file_path) return false;
+    
+    ContentScan scan;
+    memset(&scan, 0, sizeof(scan));
+    struct stat st;
+    ContentMatch local;
+    return content_scan_file(&scan, file_path, matcher, &st, match ? match : &local);
+}
+
+bool search_in_file_content(const char* file_path, const char* search_term) {
+    if (!file_path || !search_term) return false;
+    
+    ContentMatcher* matcher = content_matcher_create(search_term);
+    if (!matcher) return false;
+    
+    bool found = content_matcher_search_file(matcher, file_path, NULL);
+    content_matcher_destroy(matcher);
+    return found;
+}
+
+// === Recherche asynchrone (threading) ===
+// Chaque async_search_start crée une génération (SearchRun) confiée à
+// l'ordonnanceur, un thread persistant. L'AsyncSearch et l'ordonnanceur en
+// détiennent chacun une référence: une génération abandonnée est seulement
+// marquée annulée, l'ordonnanceur la libère en la terminant. Le thread de
+// l'interface ne fait jamais de pthread_join, quelle que soit la lenteur du
+// système de fichiers.
+
+static SearchRun* search_run_create(void) {
+    SearchRun* run = (SearchRun*)calloc(1, sizeof(SearchRun));
+    if (!run) return NULL;
+    
+    if (pthread_mutex_init(&run->mutex, NULL) != 0) {
+        free(run);
+        return NULL;
+    }
+    
+    atomic_init(&run->refcount, 1);
+    run->status = SEARCH_IDLE;
+    run->thread_count = 1;
+    run->memory_budget = FILE_LIST_DEFAULT_BUDGET;
+    atomic_init(&run->cancel_requested, false);
+    atomic_init(&run->files_scanned, 0);
+    atomic_init(&run->dirs_scanned, 0);
+    atomic_init(&run->files_matched, 0);
+    atomic_init(&run->bytes_read, 0);
+    atomic_init(&run->files_binary, 0);
+    atomic_init(&run->files_oversized, 0);
+    atomic_init(&run->files_pruned, 0);
+    atomic_init(&run->fuzzy_threshold, INT_MIN);
+    clock_gettime(CLOCK_MONOTONIC, &run->start_time);
+    return run;
+}
+
+// Secondes écoulées depuis start_time (lu sous run->mutex)
+static double search_run_elapsed(const SearchRun* run) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double)(now.tv_sec - run->start_time.tv_sec) + (double)(now.tv_nsec - run->start_time.tv_nsec) / 1e9;
+}
+
+static SearchRun* search_run_retain(SearchRun* run) {
+    if (run) {
+        atomic_fetch_add_explicit(&run->refcount, 1, memory_order_relaxed);
+    }
+    return run;
+}
+
+static void search_run_release(SearchRun* run) {
+    // acq_rel: les écritures des autres détenteurs précèdent la libération
+    if (run && atomic_fetch_sub_explicit(&run->refcount, 1, memory_order_acq_rel) == 1) {
+        file_list_destroy(run->results);
+        file_list_destroy(run->base);
+        file_index_close(run->index);
+        exclude_rules_destroy(run->exclusions);
+        pthread_mutex_destroy(&run->mutex);
+        free(run);
+    }
+}
+
+// Matcher du terme d'une génération, selon son type (NULL: terme vide ou
+// invalide). Un par thread: celui d'une expression régulière se complète
+// pendant la recherche.
+static ContentMatcher* search_run_matcher(const SearchRun* run) {
+    if (run->query_type == SEARCH_QUERY_REGEX) {
+        return content_matcher_create_regex(run->search_term, NULL, 0);
+    }
+    return content_matcher_create(run->search_term);
+}
+
+// Demande l'arrêt: les workers le voient entre deux entrées
+static void search_run_cancel(SearchRun* run) {
+    pthread_mutex_lock(&run->mutex);
+    if (run->status == SEARCH_RUNNING) {
+        run->status = SEARCH_CANCELLED;
+    }
+    atomic_store_explicit(&run->cancel_requested, true, memory_order_relaxed);
+    pthread_mutex_unlock(&run->mutex);
+}
+
+// === Tampons de résultats des workers ===
+// Chaque worker ajoute ses correspondances dans son propre tampon, sans
+// verrou: l'entrée et son chemin sont écrits avant la publication du
+// compteur (release). async_search_peek_results lit les entrées publiées
+// (acquire); run->mutex ne protège que l'ouverture et la fermeture des
+// tampons, jamais un ajout.
+
+// Part minimale d'un tampon: un segment et un bloc de chemins
+#define SEARCH_BUFFER_MIN_BUDGET (sizeof(FileEntry) * FILE_LIST_CHUNK_ENTRIES + FILE_LIST_STRING_BLOCK)
+
+// Ouvre jusqu'à count tampons se partageant memory_budget et les rend
+// visibles des lecteurs; retourne le nombre de tampons ouverts
+static int search_buffers_open(SearchRun* run, int count, size_t memory_budget) {
+    size_t share = memory_budget / (size_t)count;
+    if (share < SEARCH_BUFFER_MIN_BUDGET) share = SEARCH_BUFFER_MIN_BUDGET;
+    
+    // Les tampons au-delà de buffer_count ne sont lus par personne
+    int opened = 0;
+    while (opened < count) {
+        FileList* list = file_list_create();
+        if (!list) break;
+        file_list_set_budget(list, share);
+        if (!file_list_reserve_tables(list)) {
+            file_list_destroy(list);
+            break;
+        }
+        run->buffers[opened].list = list;
+        atomic_store_explicit(&run->buffers[opened].published, 0, memory_order_relaxed);
+        opened++;
+    }
+    
+    pthread_mutex_lock(&run->mutex);
+    run->buffer_count = opened;
+    pthread_mutex_unlock(&run->mutex);
+    return opened;
+}
+
+// Ajout par le propriétaire du tampon, puis publication de l'entrée (match:
+// première occurrence d'une recherche par contenu, NULL sinon; score: celui
+// d'une recherche approximative, 0 sinon)
+static bool search_buffer_add(SearchResultBuffer* buffer, const char* path, size_t path_length, size_t name_offset, const struct stat* st, int depth, const ContentMatch* match, int score) {
+    if (!file_list_add(buffer->list, path, path_length, name_offset, st, depth)) {
+        return false;
+    }
+    FileEntry* entry = file_list_get(buffer->list, buffer->list->count - 1);
+    if (match) {
+        entry->match_offset = match->offset;
+        entry->match_line = match->line;
+    }
+    entry->score = score;
+    atomic_store_explicit(&buffer->published, buffer->list->count, memory_order_release);
+    return true;
+}
+
+// Retire les tampons de la vue des lecteurs puis fusionne leurs entrées dans
+// results (false si le budget de results est atteint)
+static bool search_buffers_close(SearchRun* run, FileList* results) {
+    FileList* lists[SEARCH_MAX_THREADS];
+    
+    pthread_mutex_lock(&run->mutex);
+    int count = run->buffer_count;
+    for (int i = 0; i < count; i++) {
+        lists[i] = run->buffers[i].list;
+        run->buffers[i].list = NULL;
+    }
+    run->buffer_count = 0;
+    pthread_mutex_unlock(&run->mutex);
+    
+    // Chaque tampon est libéré dès sa fusion (pic mémoire limité à un tampon)
+    bool complete = true;
+    for (int i = 0; i < count; i++) {
+        for (int j = 0; complete && j < lists[i]->count; j++) {
+            complete = file_list_add_entry(results, lists[i], file_list_get(lists[i], j));
+        }
+        file_list_destroy(lists[i]);
+    }
+    return complete;
+}
+
+// Entrée d'un tampon candidate au classement final
+typedef struct {
+    const FileList* list;
+    const FileEntry* entry;
+} RankedEntry;
+
+static int compare_ranked(const RankedEntry* a, const RankedEntry* b) {
+    return compare_ranked_entries(a->entry, file_entry_name(a->list, a->entry), b->entry, file_entry_name(b->list, b->entry));
+}
+
+static int compare_ranked_qsort(const void* a, const void* b) {
+    return compare_ranked((const RankedEntry*)a, (const RankedEntry*)b);
+}
+
+// Tas des meilleures entrées: la moins bonne à la racine
+static void ranked_sift_down(RankedEntry* heap, int count, int index) {
+    for (;;) {
+        int worst = index;
+        int left = 2 * index + 1;
+        int right = left + 1;
+        if (left < count && compare_ranked(&heap[left], &heap[worst]) > 0) worst = left;
+        if (right < count && compare_ranked(&heap[right], &heap[worst]) > 0) worst = right;
+        if (worst == index) return;
+        RankedEntry swap = heap[index];
+        heap[index] = heap[worst];
+        heap[worst] = swap;
+        index = worst;
+    }
+}
+
+// Comme search_buffers_close, mais ne fusionne que les limit meilleures
+// entrées, dans l'ordre du classement: seules celles-ci sont triées
+static bool search_buffers_close_ranked(SearchRun* run, FileList* results, int limit) {
+    FileList* lists[SEARCH_MAX_THREADS];
+    
+    pthread_mutex_lock(&run->mutex);
+    int count = run->buffer_count;
+    for (int i = 0; i < count; i++) {
+        lists[i] = run->buffers[i].list;
+        run->buffers[i].list = NULL;
+    }
+    run->buffer_count = 0;
+    pthread_mutex_unlock(&run->mutex);
+    
+    RankedEntry* heap = (RankedEntry*)malloc(sizeof(RankedEntry) * limit);
+    bool complete = heap != NULL;
+    if (heap) {
+        int kept = 0;
+        for (int i = 0; i < count; i++) {
+            for (int j = 0; j < lists[i]->count; j++) {
+                RankedEntry candidate = { lists[i], file_list_get(lists[i], j) };
+                if (kept < limit) {
+                    // Remonter le nouveau venu tant qu'il est moins bon que son parent
+                    int index = kept++;
+                    heap[index] = candidate;
+                    while (index > 0 && compare_ranked(&heap[index], &heap[(index - 1) / 2]) > 0) {
+                        RankedEntry swap = heap[index];
+                        heap[index] = heap[(index - 1) / 2];
+                        heap[(index - 1) / 2] = swap;
+                        index = (index - 1) / 2;
+                    }
+                } else if (compare_ranked(&candidate, &heap[0]) < 0) {
+                    heap[0] = candidate;
+                    ranked_sift_down(heap, kept, 0);
+                }
+            }
+        }
+        
+        qsort(heap, kept, sizeof(RankedEntry), compare_ranked_qsort);
+        for (int i = 0; complete && i < kept; i++) {
+            complete = file_list_add_entry(results, heap[i].list, heap[i].entry);
+        }
+        free(heap);
+    }
+    
+    for (int i = 0; i < count; i++) {
+        file_list_destroy(lists[i]);
+    }
+    return complete;
+}
+
+// === Parcours parallèle (pool de workers avec vol de tâches) ===
+// Chaque dossier à explorer est une tâche. Chaque worker possède sa propre
+// deque: il empile/dépile ses sous-dossiers en LIFO (localité, parcours en
+// profondeur) et les workers inactifs volent les tâches les plus anciennes
+// des autres deques (généralement les plus gros sous-arbres).
+// Dossier ouvert partagé par les tâches de ses sous-dossiers: chacune
+// l'ouvre avec openat() depuis ce fd, sans que le noyau résolve à nouveau
+// tout le chemin
+typedef struct {
+    atomic_int refcount;
+    int fd;                 // Copie du fd du dossier parcouru
+} SearchParent;
+
+typedef struct {
+    char* path;
+    size_t name_offset;     // Début du nom du dossier dans path
+    SearchParent* parent;   // NULL: ouverture par le chemin complet (référence de la tâche)
+    int depth;
+    ExcludeFrame* frame;    // Règles d'exclusion héritées (référence de la tâche)
+} SearchTask;
+
+#define SEARCH_MAX_PARENT_FDS 256   // fd de dossiers gardés ouverts pour leurs sous-tâches
+
+typedef struct {
+    pthread_mutex_t lock;
+    SearchTask* tasks;
+    int head;       // Prochaine tâche à voler (la plus ancienne)
+    int tail;       // Prochain emplacement libre (la plus récente)
+    int capacity;   // Toujours une puissance de 2
+} SearchDeque;
+
+typedef struct SearchPool SearchPool;
+
+typedef struct {
+    SearchPool* pool;
+    int index;
+    SearchDeque deque;
+    ContentMatcher* matcher;    // Expression régulière (NULL: sous-chaîne lower_search)
+    int* top_scores;            // Recherche approximative: tas des meilleurs scores du worker
+    int top_count;
+    SearchResultBuffer* buffer; // Correspondances de ce worker
+    unsigned int rng;
+    pthread_t thread;
+} SearchWorker;
+
+struct SearchPool {
+    SearchRun* run;
+    char lower_search[256];
+    FuzzyPattern fuzzy;
+    bool ranked;            // Recherche approximative: seuls les meilleurs sont gardés
+    bool show_hidden;
+    SearchWorker* workers;
+    int worker_count;
+    // Terminaison et mise en veille des workers inactifs
+    pthread_mutex_t idle_lock;
+    pthread_cond_t idle_cond;
+    int pending;            // Tâches créées et pas encore terminées
+    int idle_workers;
+    unsigned long epoch;    // Incrémenté à chaque nouvelle tâche
+    bool stop;              // Annulation ou limite atteinte
+    atomic_bool limit_reached;  // Un tampon a atteint sa part du budget
+    atomic_int parent_fds;  // SearchParent ouverts (au plus SEARCH_MAX_PARENT_FDS)
+};
+
+#define SEARCH_DEQUE_INITIAL_CAPACITY 64
+
+static bool search_deque_init(SearchDeque* deque) {
+    deque->tasks = (SearchTask*)malloc(sizeof(SearchTask) * SEARCH_DEQUE_INITIAL_CAPACITY);
+    if (!deque->tasks) return false;
+    deque->head = 0;
+    deque->tail = 0;
+    deque->capacity = SEARCH_DEQUE_INITIAL_CAPACITY;
+    if (pthread_mutex_init(&deque->lock, NULL) != 0) {
+        free(deque->tasks);
+        return false;
+    }
+    return true;
+}
+
+// Copie le fd d'un dossier pour ses sous-tâches (NULL: trop de fd ouverts)
+static SearchParent* search_parent_create(SearchPool* pool, int fd) {
+    if (atomic_fetch_add_explicit(&pool->parent_fds, 1, memory_order_relaxed) >= SEARCH_MAX_PARENT_FDS) {
+        atomic_fetch_sub_explicit(&pool->parent_fds, 1, memory_order_relaxed);
+        return NULL;
+    }
+    
+    SearchParent* parent = (SearchParent*)malloc(sizeof(SearchParent));
+    int copy = parent ? fcntl(fd, F_DUPFD_CLOEXEC, 0) : -1;
+    if (copy < 0) {
+        free(parent);
+        atomic_fetch_sub_explicit(&pool->parent_fds, 1, memory_order_relaxed);
+        return NULL;
+    }
+    atomic_init(&parent->refcount, 1);
+    parent->fd = copy;
+    return parent;
+}
+
+static SearchParent* search_parent_retain(SearchParent* parent) {
+    if (parent) {
+        atomic_fetch_add_explicit(&parent->refcount, 1, memory_order_relaxed);
+    }
+    return parent;
+}
+
+static void search_parent_release(SearchPool* pool, SearchParent* parent) {
+    if (parent && atomic_fetch_sub_explicit(&parent->refcount, 1, memory_order_acq_rel) == 1) {
+        close(parent->fd);
+        free(parent);
+        atomic_fetch_sub_explicit(&pool->parent_fds, 1, memory_order_relaxed);
+    }
+}
+
+static void search_task_release(SearchPool* pool, SearchTask* task) {
+    search_parent_release(pool, task->parent);
+    exclude_frame_release(task->frame);
+    free(task->path);
+}
+
+static void search_deque_destroy(SearchPool* pool, SearchDeque* deque) {
+    // Libérer les tâches jamais traitées (annulation)
+    for (int i = deque->head; i != deque->tail; i++) {
+        search_task_release(pool, &deque->tasks[i & (deque->capacity - 1)]);
+    }
+    free(deque->tasks);
+    pthread_mutex_destroy(&deque->lock);
+}
+
+static bool search_deque_push(SearchDeque* deque, const SearchTask* task) {
+    pthread_mutex_lock(&deque->lock);
+    
+    if (deque->tail - deque->head == deque->capacity) {
+        int new_capacity = deque->capacity * 2;
+        SearchTask* new_tasks = (SearchTask*)malloc(sizeof(SearchTask) * new_capacity);
+        if (!new_tasks) {
+            pthread_mutex_unlock(&deque->lock);
+            return false;
+        }
+        int count = deque->tail - deque->head;
+        for (int i = 0; i < count; i++) {
+            new_tasks[i] = deque->tasks[(deque->head + i) & (deque->capacity - 1)];
+        }
+        free(deque->tasks);
+        deque->tasks = new_tasks;
+        deque->capacity = new_capacity;
+        deque->head = 0;
+        deque->tail = count;
+    }
+    
+    deque->tasks[deque->tail & (deque->capacity - 1)] = *task;
+    deque->tail++;
+    
+    pthread_mutex_unlock(&deque->lock);
+    return true;
+}
+
+// Côté propriétaire: la tâche la plus récente
+static bool search_deque_pop(SearchDeque* deque, SearchTask* task) {
+    pthread_mutex_lock(&deque->lock);
+    bool found = deque->tail != deque->head;
+    if (found) {
+        deque->tail--;
+        *task = deque->tasks[deque->tail & (deque->capacity - 1)];
+    }
+    pthread_mutex_unlock(&deque->lock);
+    return found;
+}
+
+// Côté voleur: la tâche la plus ancienne
+static bool search_deque_steal(SearchDeque* deque, SearchTask* task) {
+    pthread_mutex_lock(&deque->lock);
+    bool found = deque->tail != deque->head;
+    if (found) {
+        *task = deque->tasks[deque->head & (deque->capacity - 1)];
+        deque->head++;
+    }
+    pthread_mutex_unlock(&deque->lock);
+    return found;
+}
+
+static void search_pool_stop(SearchPool* pool) {
+    pthread_mutex_lock(&pool->idle_lock);
+    pool->stop = true;
+    pthread_cond_broadcast(&pool->idle_cond);
+    pthread_mutex_unlock(&pool->idle_lock);
+}
+
+// Publie le dossier path (nom à partir de name_offset, ouvert depuis parent
+// s'il est donné) comme tâche
+static void search_pool_push(SearchPool* pool, SearchWorker* self, const char* path, size_t name_offset, SearchParent* parent, int depth, ExcludeFrame* frame) {
+    SearchTask task;
+    task.path = strdup(path);
+    task.name_offset = name_offset;
+    task.depth = depth;
+    if (!task.path) return;
+    
+    task.parent = search_parent_retain(parent);
+    task.frame = exclude_frame_retain(frame);
+    if (!search_deque_push(&self->deque, &task)) {
+        search_task_release(pool, &task);
+        return;
+    }
+    
+    pthread_mutex_lock(&pool->idle_lock);
+    pool->pending++;
+    pool->epoch++;
+    if (pool->idle_workers > 0) {
+        pthread_cond_signal(&pool->idle_cond);
+    }
+    pthread_mutex_unlock(&pool->idle_lock);
+}
+
+static void search_pool_task_done(SearchPool* pool) {
+    pthread_mutex_lock(&pool->idle_lock);
+    pool->pending--;
+    if (pool->pending == 0) {
+        // Plus aucune tâche nulle part: réveiller tout le monde pour terminer
+        pthread_cond_broadcast(&pool->idle_cond);
+    }
+    pthread_mutex_unlock(&pool->idle_lock);
+}
+
+static bool search_pool_steal(SearchPool* pool, SearchWorker* self, SearchTask* task) {
+    int count = pool->worker_count;
+    if (count <= 1) return false;
+    
+    // Partir d'une victime aléatoire pour répartir la contention
+    int start = (int)(rand_r(&self->rng) % (unsigned int)count);
+    for (int i = 0; i < count; i++) {
+        int victim = (start + i) % count;
+        if (victim == self->index) continue;
+        if (search_deque_steal(&pool->workers[victim].deque, task)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Obtient la prochaine tâche; retourne false quand le parcours est terminé
+static bool search_pool_next_task(SearchPool* pool, SearchWorker* self, SearchTask* task) {
+    for (;;) {
+        pthread_mutex_lock(&pool->idle_lock);
+        bool stop = pool->stop;
+        unsigned long epoch = pool->epoch;
+        pthread_mutex_unlock(&pool->idle_lock);
+        
+        if (stop) return false;
+        
+        if (search_deque_pop(&self->deque, task) || search_pool_steal(pool, self, task)) {
+            return true;
+        }
+        
+        // Rien à faire: attendre une nouvelle tâche ou la fin du parcours
+        pthread_mutex_lock(&pool->idle_lock);
+        if (pool->stop || pool->pending == 0) {
+            pthread_mutex_unlock(&pool->idle_lock);
+            return false;
+        }
+        if (pool->epoch == epoch) {
+            pool->idle_workers++;
+            pthread_cond_wait(&pool->idle_cond, &pool->idle_lock);
+            pool->idle_workers--;
+        }
+        pthread_mutex_unlock(&pool->idle_lock);
+    }
+}
+
+// Recherche approximative: garde score parmi les SEARCH_FUZZY_MAX_RESULTS
+// meilleurs du worker. Le seuil partagé est le plus élevé des seuils locaux
+// (le moins bon score de chaque tas plein): un score qui ne le dépasse pas
+// n'entrera jamais dans le classement final et n'est pas publié. À score
+// égal, les premiers trouvés restent.
+static bool search_worker_rank(SearchWorker* self, int score) {
+    atomic_int* threshold = &self->pool->run->fuzzy_threshold;
+    if (score <= atomic_load_explicit(threshold, memory_order_relaxed)) {
+        return false;
+    }
+    
+    int* heap = self->top_scores;
+    int index;
+    if (self->top_count < SEARCH_FUZZY_MAX_RESULTS) {
+        index = self->top_count++;
+        heap[index] = score;
+        while (index > 0 && heap[index] < heap[(index - 1) / 2]) {
+            int swap = heap[index];
+            heap[index] = heap[(index - 1) / 2];
+            heap[(index - 1) / 2] = swap;
+            index = (index - 1) / 2;
+        }
+        if (self->top_count < SEARCH_FUZZY_MAX_RESULTS) {
+            return true;
+        }
+    } else {
+        // Le seuil local ne dépasse jamais le seuil partagé: score > heap[0]
+        heap[0] = score;
+        for (index = 0; ; ) {
+            int smallest = index;
+            int left = 2 * index + 1;
+            int right = left + 1;
+            if (left < SEARCH_FUZZY_MAX_RESULTS && heap[left] < heap[smallest]) smallest = left;
+            if (right < SEARCH_FUZZY_MAX_RESULTS && heap[right] < heap[smallest]) smallest = right;
+            if (smallest == index) break;
+            int swap = heap[index];
+            heap[index] = heap[smallest];
+            heap[smallest] = swap;
+            index = smallest;
+        }
+    }
+    
+    int current = atomic_load_explicit(threshold, memory_order_relaxed);
+    while (heap[0] > current &&
+           !atomic_compare_exchange_weak_explicit(threshold, &current, heap[0], memory_order_relaxed, memory_order_relaxed)) {
+    }
+    return true;
+}
+
+// Explore un dossier: teste chaque entrée et publie les sous-dossiers comme tâches
+static void search_walk_directory(SearchPool* pool, SearchWorker* self, const SearchTask* task) {
+    SearchRun* run = pool->run;
+    
+    DIR* dir = task->parent ? open_directory_at(task->parent->fd, task->path + task->name_offset)
+                            : open_directory_at(AT_FDCWD, task->path);
+    if (!dir) {
+        return;
+    }
+    
+    atomic_fetch_add_explicit(&run->dirs_scanned, 1, memory_order_relaxed);
+    
+    int fd = dirfd(dir);
+    char path_buffer[MAX_PATH_LENGTH];
+    size_t dir_len = path_set_directory(path_buffer, task->path);
+    ExcludeFrame* frame = exclude_frame_enter(task->frame, fd, dir_len);
+    
+    // Fichiers comptés localement, versés par lots de SEARCH_UPDATE_INTERVAL
+    int files_scanned = 0;
+    
+    // Copie du fd, créée au premier sous-dossier publié
+    SearchParent* self_parent = NULL;
+    bool parent_tried = false;
+    
+    struct dirent* entry;
+    while (dir_len > 0 && (entry = readdir(dir)) != NULL) {
+        // Vérifier si annulé ou si un autre worker a atteint la limite
+        if (atomic_load_explicit(&run->cancel_requested, memory_order_relaxed) ||
+            atomic_load_explicit(&pool->limit_reached, memory_order_relaxed)) {
+            search_pool_stop(pool);
+            break;
+        }
+        
+        if (is_dot_entry(entry->d_name)) {
+            continue;
+        }
+        
+        if (!pool->show_hidden && entry->d_name[0] == '.') {
+            continue;
+        }
+        
+        size_t path_len = path_append_name(path_buffer, dir_len, entry->d_name);
+        if (path_len == 0) {
+            continue;
+        }
+        
+        // Stat uniquement pour les correspondances ou si d_type est inconnu
+        struct stat st;
+        bool is_dir = false;
+        bool have_stat = false;
+        if (!entry_type_hint(entry, &is_dir)) {
+            if (fstatat(fd, entry->d_name, &st, 0) == -1) {
+                continue;
+            }
+            is_dir = S_ISDIR(st.st_mode);
+            have_stat = true;
+        }
+        
+        // Vérifier les règles d'exclusion
+        if (exclude_frame_match(frame, path_buffer, path_len, dir_len, is_dir)) {
+            continue;
+        }
+        
+        if (!is_dir && ++files_scanned == SEARCH_UPDATE_INTERVAL) {
+            atomic_fetch_add_explicit(&run->files_scanned, files_scanned, memory_order_relaxed);
+            files_scanned = 0;
+        }
+        
+        // Vérifier si le nom correspond
+        bool matches;
+        int score = 0;
+        if (pool->ranked) {
+            matches = fuzzy_match(&pool->fuzzy, entry->d_name, strlen(entry->d_name), &score);
+            if (matches) {
+                atomic_fetch_add_explicit(&run->files_matched, 1, memory_order_relaxed);
+                matches = search_worker_rank(self, score);
+            }
+        } else if (self->matcher) {
+            matches = content_matcher_find(self->matcher, entry->d_name, strlen(entry->d_name), NULL, NULL) != NULL;
+        } else {
+            char lower_name[256];
+            for (int i = 0; entry->d_name[i] && i < 255; i++) {
+                lower_name[i] = tolower(entry->d_name[i]);
+                lower_name[i + 1] = '\0';
+            }
+            matches = strstr(lower_name, pool->lower_search) != NULL;
+        }
+        
+        if (matches) {
+            if (!have_stat && fstatat(fd, entry->d_name, &st, 0) == -1) {
+                continue;
+            }
+            if (search_buffer_add(self->buffer, path_buffer, path_len, dir_len, &st, task->depth, NULL, score)) {
+                if (!pool->ranked) {
+                    atomic_fetch_add_explicit(&run->files_matched, 1, memory_order_relaxed);
+                }
+            } else {
+                atomic_store_explicit(&pool->limit_reached, true, memory_order_relaxed);
+            }
+        }
+        
+        // Publier le sous-dossier pour qu'un worker (ou un voleur) le parcoure
+        if (is_dir && task->depth + 1 <= MAX_SEARCH_DEPTH) {
+            if (!parent_tried) {
+                self_parent = search_parent_create(pool, fd);
+                parent_tried = true;
+            }
+            search_pool_push(pool, self, path_buffer, dir_len, self_parent, task->depth + 1, frame);
+        }
+    }
+    
+    atomic_fetch_add_explicit(&run->files_scanned, files_scanned, memory_order_relaxed);
+    search_parent_release(pool, self_parent);
+    exclude_frame_release(frame);
+    closedir(dir);
+}
+
+static void* search_worker_function(void* arg) {
+    SearchWorker* self = (SearchWorker*)arg;
+    SearchPool* pool = self->pool;
+    
+    SearchTask task;
+    while (search_pool_next_task(pool, self, &task)) {
+        search_walk_directory(pool, self, &task);
+        search_task_release(pool, &task);
+        search_pool_task_done(pool);
+    }
+    
+    return NULL;
+}
+
+// Recherche par nom avec un pool de workers, résultats ajoutés à results
+// (retourne false si limite atteinte). Pendant le parcours, les résultats
+// sont dans les tampons des workers (visibles de async_search_peek_results).
+// Le worker 0 est le thread courant: avec un seul worker, aucun thread n'est créé.
+static bool search_parallel_by_name(SearchRun* run, FileList* results, const char* path, int depth, const char* search_term, bool show_hidden, int thread_count) {
+    SearchPool pool;
+    memset(&pool, 0, sizeof(pool));
+    pool.run = run;
+    pool.show_hidden = show_hidden;
+    atomic_init(&pool.limit_reached, false);
+    atomic_init(&pool.parent_fds, 0);
+    
+    // Convertir le terme de recherche en minuscules
+    for (int i = 0; search_term[i] && i < 255; i++) {
+        pool.lower_search[i] = tolower(search_term[i]);
+        pool.lower_search[i + 1] = '\0';
+    }
+    if (run->query_type == SEARCH_QUERY_FUZZY && !run->search_by_content) {
+        pool.ranked = fuzzy_pattern_init(&pool.fuzzy, search_term);
+    }
+    
+    if (thread_count < 1) thread_count = 1;
+    if (thread_count > SEARCH_MAX_THREADS) thread_count = SEARCH_MAX_THREADS;
+    
+    // Un tampon de résultats par worker
+    thread_count = search_buffers_open(run, thread_count, results->memory_budget);
+    if (thread_count == 0) return true;
+    
+    pool.workers = (SearchWorker*)calloc(thread_count, sizeof(SearchWorker));
+    if (!pool.workers) {
+        search_buffers_close(run, results);
+        return true;
+    }
+    
+    if (pthread_mutex_init(&pool.idle_lock, NULL) != 0) {
+        free(pool.workers);
+        search_buffers_close(run, results);
+        return true;
+    }
+    pthread_cond_init(&pool.idle_cond, NULL);
+    
+    // Expression régulière: un matcher par worker (sans lui, rien ne
+    // correspond). Recherche approximative: un tas de scores par worker.
+    for (int i = 0; i < thread_count; i++) {
+        if (run->query_type == SEARCH_QUERY_REGEX && !(pool.workers[i].matcher = search_run_matcher(run))) {
+            break;
+        }
+        if (pool.ranked && !(pool.workers[i].top_scores = (int*)malloc(sizeof(int) * SEARCH_FUZZY_MAX_RESULTS))) {
+            content_matcher_destroy(pool.workers[i].matcher);
+            break;
+        }
+        if (!search_deque_init(&pool.workers[i].deque)) {
+            content_matcher_destroy(pool.workers[i].matcher);
+            free(pool.workers[i].top_scores);
+            break;
+        }
+        pool.workers[i].pool = &pool;
+        pool.workers[i].index = i;
+        pool.workers[i].buffer = &run->buffers[i];
+        pool.workers[i].rng = (unsigned int)(i * 2654435761u) ^ (unsigned int)time(NULL);
+        pool.worker_count++;
+    }
+    
+    if (pool.worker_count > 0) {
+        // Tâche racine sur le worker 0 (le thread courant)
+        char root[MAX_PATH_LENGTH];
+        size_t root_len = path_set_directory(root, path);
+        ExcludeFrame* root_frame = root_len ? exclude_frame_root(run->exclusions, root, root_len) : NULL;
+        search_pool_push(&pool, &pool.workers[0], path, 0, NULL, depth, root_frame);
+        exclude_frame_release(root_frame);
+        
+        // Lancer les autres workers; en cas d'échec, ils restent simplement inactifs
+        int started = 1;
+        for (int i = 1; i < pool.worker_count; i++) {
+            if (pthread_create(&pool.workers[i].thread, NULL, search_worker_function, &pool.workers[i]) != 0) {
+                break;
+            }
+            started++;
+        }
+        
+        search_worker_function(&pool.workers[0]);
+        
+        for (int i = 1; i < started; i++) {
+            pthread_join(pool.workers[i].thread, NULL);
+        }
+    }
+    
+    for (int i = 0; i < pool.worker_count; i++) {
+        search_deque_destroy(&pool, &pool.workers[i].deque);
+        content_matcher_destroy(pool.workers[i].matcher);
+        free(pool.workers[i].top_scores);
+    }
+    pthread_cond_destroy(&pool.idle_cond);
+    pthread_mutex_destroy(&pool.idle_lock);
+    free(pool.workers);
+    
+    bool complete = pool.ranked ? search_buffers_close_ranked(run, results, SEARCH_FUZZY_MAX_RESULTS)
+                                : search_buffers_close(run, results);
+    return complete && !atomic_load_explicit(&pool.limit_reached, memory_order_relaxed);
+}
+
+// === Recherche par contenu en pipeline ===
+// Le thread de recherche parcourt les dossiers et dépose chaque fichier
+// candidat dans une file bornée; un pool de workers lit et teste les
+// fichiers en parallèle. Parcours et lectures se recouvrent, et plusieurs
+// lectures sont en vol à la fois. La file bornée freine le parcours quand
+// les workers ont du retard (mémoire constante).
+typedef struct {
+    char path[MAX_PATH_LENGTH];
+    size_t name_offset;
+    int depth;
+} ContentJob;
+
+typedef struct ContentWorker ContentWorker;
+
+typedef struct {
+    SearchRun* run;
+    bool show_hidden;
+    ContentWorker* inline_worker;   // Sans lecteur: le parcours lit lui-même
+    const FileIndex* index;         // Trigrammes consultés avant lecture (NULL: tout est lu)
+    uint64_t* candidates;           // Enregistrements qui peuvent contenir un terme (un bit chacun)
+    // File bornée (anneau de CONTENT_QUEUE_CAPACITY jobs)
+    pthread_mutex_t lock;
+    pthread_cond_t not_empty;
+    pthread_cond_t not_full;
+    ContentJob* jobs;
+    int head;
+    int count;
+    int waiting_workers;        // Réveils seulement s'il y a quelqu'un à réveiller
+    bool producer_waiting;
+    bool closed;                // Plus aucun job ne sera déposé
+    bool stop;                  // Annulation ou limite: abandonner les jobs restants
+    atomic_bool limit_reached;  // Un tampon a atteint sa part du budget
+} ContentPipeline;
+
+struct ContentWorker {
+    ContentPipeline* pipeline;
+    ContentMatcher* matcher;    // Termes de la requête (propres au worker)
+    SearchResultBuffer* buffer; // Fichiers retenus par ce worker
+    ContentScan scan;           // Octets lus et fichiers ignorés depuis le dernier lot
+    pthread_t thread;
+};
+
+static void content_pipeline_stop(ContentPipeline* pipeline) {
+    pthread_mutex_lock(&pipeline->lock);
+    pipeline->stop = true;
+    pipeline->closed = true;
+    pthread_cond_broadcast(&pipeline->not_empty);
+    pthread_cond_broadcast(&pipeline->not_full);
+    pthread_mutex_unlock(&pipeline->lock);
+}
+
+// Dépose un job (bloque tant que la file est pleine); false si arrêt demandé
+static bool content_pipeline_push(ContentPipeline* pipeline, const char* path, size_t path_len, size_t name_offset, int depth) {
+    pthread_mutex_lock(&pipeline->lock);
+    while (pipeline->count == CONTENT_QUEUE_CAPACITY && !pipeline->stop) {
+        pipeline->producer_waiting = true;
+        pthread_cond_wait(&pipeline->not_full, &pipeline->lock);
+        pipeline->producer_waiting = false;
+    }
+    if (pipeline->stop) {
+        pthread_mutex_unlock(&pipeline->lock);
+        return false;
+    }
+    
+    ContentJob* job = &pipeline->jobs[(pipeline->head + pipeline->count) % CONTENT_QUEUE_CAPACITY];
+    memcpy(job->path, path, path_len + 1);
+    job->name_offset = name_offset;
+    job->depth = depth;
+    pipeline->count++;
+    
+    if (pipeline->waiting_workers > 0) {
+        pthread_cond_signal(&pipeline->not_empty);
+    }
+    pthread_mutex_unlock(&pipeline->lock);
+    return true;
+}
+
+// Retire jusqu'à max jobs (au moins un); 0 quand la file est fermée et vide
+// (ou arrêt demandé)
+static int content_pipeline_pop(ContentPipeline* pipeline, ContentJob* jobs, int max) {
+    pthread_mutex_lock(&pipeline->lock);
+    while (pipeline->count == 0 && !pipeline->closed) {
+        pipeline->waiting_workers++;
+        pthread_cond_wait(&pipeline->not_empty, &pipeline->lock);
+        pipeline->waiting_workers--;
+    }
+    if (pipeline->stop || pipeline->count == 0) {
+        pthread_mutex_unlock(&pipeline->lock);
+        return 0;
+    }
+    
+    int taken = pipeline->count < max ? pipeline->count : max;
+    for (int i = 0; i < taken; i++) {
+        const ContentJob* slot = &pipeline->jobs[pipeline->head];
+        memcpy(jobs[i].path, slot->path, strlen(slot->path) + 1);
+        jobs[i].name_offset = slot->name_offset;
+        jobs[i].depth = slot->depth;
+        pipeline->head = (pipeline->head + 1) % CONTENT_QUEUE_CAPACITY;
+    }
+    pipeline->count -= taken;
+    
+    if (pipeline->producer_waiting) {
+        pthread_cond_signal(&pipeline->not_full);
+    }
+    pthread_mutex_unlock(&pipeline->lock);
+    return taken;
+}
+
+// Comptabilise count fichiers lus et ajoute ceux retenus au tampon du worker,
+// avec leur première occurrence
+static void content_pipeline_publish(ContentWorker* worker, const ContentJob* jobs, const bool* found, const struct stat* stats, const ContentMatch* matches, int count) {
+    ContentPipeline* pipeline = worker->pipeline;
+    SearchRun* run = pipeline->run;
+    
+    atomic_fetch_add_explicit(&run->files_scanned, count, memory_order_relaxed);
+    content_scan_flush(&worker->scan);
+    for (int i = 0; i < count; i++) {
+        if (!found[i]) continue;
+        if (!search_buffer_add(worker->buffer, jobs[i].path, strlen(jobs[i].path), jobs[i].name_offset, &stats[i], jobs[i].depth, &matches[i], 0)) {
+            atomic_store_explicit(&pipeline->limit_reached, true, memory_order_relaxed);
+            content_pipeline_stop(pipeline);
+            return;
+        }
+        atomic_fetch_add_explicit(&run->files_matched, 1, memory_order_relaxed);
+    }
+}
+
+#ifdef FILEX_HAVE_IO_URING
+// === Lectures groupées io_uring ===
+// Un worker traite ses jobs par lots de CONTENT_URING_BATCH: tous les openat
+// et statx du lot en une soumission, puis toutes les lectures du début des
+// fichiers, puis toutes les fermetures. Trois appels système par lot au lieu
+// de plusieurs par fichier, et autant de requêtes en vol que de fichiers.
+// Seuls les fichiers plus gros que le premier bloc repassent par le chemin
+// mmap bloquant, pour leur suite.
+typedef struct {
+    struct statx stx;
+    int fd;
+    size_t read_length;         // Octets demandés au premier bloc (0: pas de lecture)
+    char* buffer;
+} ContentUringSlot;
+
+// Soumet les requêtes préparées et range le résultat de chacune dans
+// results[user_data]. false si l'anneau est inutilisable.
+static bool content_uring_run(struct io_uring* ring, int count, int* results) {
+    if (count == 0) return true;
+    
+    int submitted = io_uring_submit_and_wait(ring, count);
+    if (submitted < 0) {
+        return false;
+    }
+    
+    for (int i = 0; i < submitted; i++) {
+        struct io_uring_cqe* cqe = NULL;
+        int ret;
+        do {
+            ret = io_uring_wait_cqe(ring, &cqe);
+        } while (ret == -EINTR);
+        if (ret < 0) return false;
+        results[cqe->user_data] = cqe->res;
+        io_uring_cqe_seen(ring, cqe);
+    }
+    return submitted == count;
+}
+
+static void statx_to_stat(const struct statx* stx, struct stat* st) {
+    memset(st, 0, sizeof(*st));
+    st->st_mode = stx->stx_mode;
+    st->st_size = (off_t)stx->stx_size;
+    st->st_uid = stx->stx_uid;
+    st->st_gid = stx->stx_gid;
+    st->st_mtime = (time_t)stx->stx_mtime.tv_sec;
+}
+
+static bool content_uring_process(ContentWorker* worker, struct io_uring* ring, const ContentJob* jobs, ContentUringSlot* slots, int count) {
+    ContentMatcher* matcher = worker->matcher;
+    ContentScan* scan = &worker->scan;
+    int results[2 * CONTENT_URING_BATCH];
+    
+    // 1. Ouverture et métadonnées de tout le lot
+    for (int i = 0; i < count; i++) {
+        results[2 * i] = -1;    // Sans réponse: pas de fd à fermer
+        struct io_uring_sqe* sqe = io_uring_get_sqe(ring);
+        io_uring_prep_openat(sqe, AT_FDCWD, jobs[i].path, O_RDONLY | O_CLOEXEC | O_NOCTTY | O_NONBLOCK, 0);
+        io_uring_sqe_set_data64(sqe, 2 * i);
+        
+        sqe = io_uring_get_sqe(ring);
+        io_uring_prep_statx(sqe, AT_FDCWD, jobs[i].path, 0,
+                            STATX_TYPE | STATX_MODE | STATX_SIZE | STATX_UID | STATX_GID | STATX_MTIME,
+                            &slots[i].stx);
+        io_uring_sqe_set_data64(sqe, 2 * i + 1);
+    }
+    if (!content_uring_run(ring, 2 * count, results)) {
+        // Anneau inutilisable: le lot, déjà retiré de la file, est lu en
+        // bloquant pour ne perdre aucun fichier
+        bool found[CONTENT_URING_BATCH];
+        struct stat stats[CONTENT_URING_BATCH];
+        ContentMatch matches[CONTENT_URING_BATCH];
+        for (int i = 0; i < count; i++) {
+            if (results[2 * i] >= 0) close(results[2 * i]);
+            found[i] = content_scan_file(scan, jobs[i].path, matcher, &stats[i], &matches[i]);
+        }
+        content_pipeline_publish(worker, jobs, found, stats, matches, count);
+        return false;
+    }
+    
+    // 2. Premier bloc de chaque fichier régulier non vide
+    int reads = 0;
+    for (int i = 0; i < count; i++) {
+        slots[i].fd = results[2 * i];
+        slots[i].read_length = 0;
+        if (slots[i].fd < 0 || results[2 * i + 1] != 0 ||
+            !S_ISREG(slots[i].stx.stx_mode) || slots[i].stx.stx_size == 0) {
+            continue;
+        }
+        if (scan->max_size > 0 && slots[i].stx.stx_size > scan->max_size) {
+            scan->files_oversized++;
+            continue;
+        }
+        
+        size_t length = CONTENT_URING_READ_SIZE + matcher->max_length - 1;
+        if (slots[i].stx.stx_size < length) {
+            length = (size_t)slots[i].stx.stx_size;
+        }
+        slots[i].read_length = length;
+        
+        struct io_uring_sqe* sqe = io_uring_get_sqe(ring);
+        io_uring_prep_read(sqe, slots[i].fd, slots[i].buffer, (unsigned int)length, 0);
+        io_uring_sqe_set_data64(sqe, i);
+        reads++;
+    }
+    bool ring_ok = content_uring_run(ring, reads, results);
+    
+    // 3. Recherche dans les blocs lus
+    bool found[CONTENT_URING_BATCH];
+    struct stat stats[CONTENT_URING_BATCH];
+    ContentMatch matches[CONTENT_URING_BATCH];
+    for (int i = 0; i < count; i++) {
+        found[i] = false;
+        if (slots[i].read_length == 0) continue;
+        
+        size_t file_size = (size_t)slots[i].stx.stx_size;
+        if (!ring_ok || results[i] < 0 || (size_t)results[i] != slots[i].read_length) {
+            // Lecture courte ou en échec: chemin bloquant pour tout le fichier
+            found[i] = search_content_fd(slots[i].fd, file_size, 0, 0, matcher, scan, &matches[i]);
+        } else if (content_looks_binary((const unsigned char*)slots[i].buffer, slots[i].read_length)) {
+            scan->files_binary++;
+        } else {
+            scan->bytes_read += slots[i].read_length < CONTENT_URING_READ_SIZE ? slots[i].read_length : CONTENT_URING_READ_SIZE;
+            size_t match_length;
+            int pattern;
+            const char* position = content_matcher_find_window(matcher, slots[i].buffer, slots[i].read_length, true,
+                                                               slots[i].read_length == file_size, &match_length, &pattern);
+            found[i] = position != NULL;
+            if (found[i]) {
+                content_match_locate(&matches[i], slots[i].buffer, 0, 0, position, match_length, pattern);
+            } else if (file_size > slots[i].read_length) {
+                long lines = content_count_lines(slots[i].buffer, CONTENT_URING_READ_SIZE);
+                found[i] = search_content_fd(slots[i].fd, file_size, CONTENT_URING_READ_SIZE, lines, matcher, scan, &matches[i]);
+            }
+        }
+        
+        if (found[i]) {
+            statx_to_stat(&slots[i].stx, &stats[i]);
+        }
+    }
+    
+    // 4. Fermeture groupée
+    int closes = 0;
+    for (int i = 0; ring_ok && i < count; i++) {
+        if (slots[i].fd < 0) continue;
+        struct io_uring_sqe* sqe = io_uring_get_sqe(ring);
+        io_uring_prep_close(sqe, slots[i].fd);
+        io_uring_sqe_set_data64(sqe, i);
+        closes++;
+    }
+    if (!ring_ok || !content_uring_run(ring, closes, results)) {
+        for (int i = 0; i < count; i++) {
+            if (slots[i].fd >= 0) close(slots[i].fd);
+        }
+        ring_ok = false;
+    }
+    
+    content_pipeline_publish(worker, jobs, found, stats, matches, count);
+    return ring_ok;
+}
+
+// Boucle d'un worker sur io_uring; false si l'anneau ne peut pas être créé
+// ou devient inutilisable (le worker continue alors en lectures bloquantes)
+static bool content_worker_uring(ContentWorker* worker) {
+    ContentPipeline* pipeline = worker->pipeline;
+    struct io_uring ring;
+    if (io_uring_queue_init(2 * CONTENT_URING_BATCH, &ring, 0) < 0) {
+        return false;
+    }
+    
+    size_t buffer_size = CONTENT_URING_READ_SIZE + worker->matcher->max_length;
+    ContentJob* jobs = (ContentJob*)malloc(sizeof(ContentJob) * CONTENT_URING_BATCH);
+    ContentUringSlot* slots = (ContentUringSlot*)calloc(CONTENT_URING_BATCH, sizeof(ContentUringSlot));
+    char* buffers = (char*)malloc(buffer_size * CONTENT_URING_BATCH);
+    
+    bool ok = jobs && slots && buffers;
+    for (int i = 0; ok && i < CONTENT_URING_BATCH; i++) {
+        slots[i].buffer = buffers + (size_t)i * buffer_size;
+    }
+    
+    int count;
+    while (ok && (count = content_pipeline_pop(pipeline, jobs, CONTENT_URING_BATCH)) > 0) {
+        ok = content_uring_process(worker, &ring, jobs, slots, count);
+    }
+    
+    // D'abord l'anneau: une requête encore en vol après un échec écrirait
+    // dans les tampons et les statx des emplacements
+    io_uring_queue_exit(&ring);
+    free(buffers);
+    free(slots);
+    free(jobs);
+    return ok;
+}
+#endif
+
+static void* content_worker_function(void* arg) {
+    ContentWorker* worker = (ContentWorker*)arg;
+    ContentPipeline* pipeline = worker->pipeline;
+    
+#ifdef FILEX_HAVE_IO_URING
+    if (content_worker_uring(worker)) {
+        return NULL;
+    }
+#endif
+    
+    // Lectures bloquantes, un fichier à la fois
+    ContentJob job;
+    while (content_pipeline_pop(pipeline, &job, 1) > 0) {
+        struct stat st;
+        ContentMatch match;
+        bool found = content_scan_file(&worker->scan, job.path, worker->matcher, &st, &match);
+        content_pipeline_publish(worker, &job, &found, &st, &match, 1);
+    }
+    
+    return NULL;
+}
+
+// Confie un fichier aux lecteurs ou, sans lecteur, le lit dans le thread du
+// parcours; false si le parcours doit s'arrêter
+static bool content_pipeline_submit(ContentPipeline* pipeline, const char* path, size_t path_len, size_t name_offset, int depth) {
+    ContentWorker* worker = pipeline->inline_worker;
+    if (!worker) {
+        return content_pipeline_push(pipeline, path, path_len, name_offset, depth);
+    }
+    
+    ContentJob job;
+    memcpy(job.path, path, path_len + 1);
+    job.name_offset = name_offset;
+    job.depth = depth;
+    struct stat st;
+    ContentMatch match;
+    bool found = content_scan_file(&worker->scan, job.path, worker->matcher, &st, &match);
+    content_pipeline_publish(worker, &job, &found, &st, &match, 1);
+    return !atomic_load_explicit(&pipeline->limit_reached, memory_order_relaxed);
+}
+
+// Trigrammes de l'index persistant (section de l'index)
+static uint64_t* index_select_candidates(const FileIndex* index, const ContentMatcher* matcher);
+
+// Faux si le fichier path (st: son stat) est inchangé depuis la construction
+// de l'index et qu'il n'est pas parmi candidates: il ne contient aucun des
+// termes. Vrai pour un fichier nouveau, modifié ou non indexé.
+static bool file_index_may_contain(const FileIndex* index, const uint64_t* candidates, const char* path, const struct stat* st);
+
+// Parcours producteur; false si annulé ou si la limite est atteinte
+static bool content_walk_directory(ContentPipeline* pipeline, DIR* dir, char* path_buffer, size_t dir_len, int depth, ExcludeFrame* frame) {
+    SearchRun* run = pipeline->run;
+    int fd = dirfd(dir);
+    
+    atomic_fetch_add_explicit(&run->dirs_scanned, 1, memory_order_relaxed);
+    
+    struct dirent* entry;
+    while ((entry = readdir(dir)) != NULL) {
+        // Vérifier si annulé ou si un worker a atteint la limite. Annulé:
+        // les fichiers encore en file sont abandonnés, pas lus.
+        if (atomic_load_explicit(&run->cancel_requested, memory_order_relaxed)) {
+            content_pipeline_stop(pipeline);
+            return false;
+        }
+        if (atomic_load_explicit(&pipeline->limit_reached, memory_order_relaxed)) {
+            return false;
+        }
+        
+        if (is_dot_entry(entry->d_name)) {
+            continue;
+        }
+        
+        if (!pipeline->show_hidden && entry->d_name[0] == '.') {
+            continue;
+        }
+        
+        size_t path_len = path_append_name(path_buffer, dir_len, entry->d_name);
+        if (path_len == 0) {
+            continue;
+        }
+        
+        bool is_dir = false;
+        if (!entry_type_hint(entry, &is_dir)) {
+            struct stat st;
+            if (fstatat(fd, entry->d_name, &st, 0) == -1) {
+                continue;
+            }
+            is_dir = S_ISDIR(st.st_mode);
+        }
+        
+        // Vérifier les règles d'exclusion
+        if (exclude_frame_match(frame, path_buffer, path_len, dir_len, is_dir)) {
+            continue;
+        }
+        
+        if (!is_dir) {
+            // Fichier inchangé que les trigrammes écartent: pas lu
+            struct stat st;
+            if (pipeline->candidates && fstatat(fd, entry->d_name, &st, 0) == 0 && S_ISREG(st.st_mode) &&
+                !file_index_may_contain(pipeline->index, pipeline->candidates, path_buffer, &st)) {
+                atomic_fetch_add_explicit(&run->files_pruned, 1, memory_order_relaxed);
+                continue;
+            }
+            if (!content_pipeline_submit(pipeline, path_buffer, path_len, dir_len, depth)) {
+                return false;
+            }
+            continue;
+        }
+        
+        if (depth + 1 > MAX_SEARCH_DEPTH) {
+            continue;
+        }
+        size_t sub_len = path_push_directory(path_buffer, path_len);
+        DIR* sub = sub_len ? open_directory_at(fd, entry->d_name) : NULL;
+        if (sub) {
+            ExcludeFrame* sub_frame = exclude_frame_enter(frame, dirfd(sub), sub_len);
+            bool keep_going = content_walk_directory(pipeline, sub, path_buffer, sub_len, depth + 1, sub_frame);
+            exclude_frame_release(sub_frame);
+            closedir(sub);
+            if (!keep_going) {
+                return false;
+            }
+        }
+    }
+    
+    return true;
+}
+
+// Recherche par contenu: parcours dans le thread courant, lectures dans
+// thread_count workers, ou dans le thread courant si thread_count vaut 0 ou
+// si aucun worker ne démarre (retourne false si limite atteinte)
+static bool search_parallel_by_content(SearchRun* run, FileList* results, const char* path, int depth, bool show_hidden, int thread_count) {
+    ContentPipeline pipeline;
+    memset(&pipeline, 0, sizeof(pipeline));
+    pipeline.run = run;
+    pipeline.show_hidden = show_hidden;
+    atomic_init(&pipeline.limit_reached, false);
+    
+    if (thread_count < 0) thread_count = 0;
+    if (thread_count > SEARCH_MAX_THREADS) thread_count = SEARCH_MAX_THREADS;
+    
+    ContentWorker workers[SEARCH_MAX_THREADS];
+    int started = 0;
+    
+    // Un tampon de résultats par worker (au moins un pour la lecture en ligne)
+    int buffer_count = search_buffers_open(run, thread_count > 0 ? thread_count : 1, results->memory_budget);
+    
+    // Tous les termes de la requête en une passe par fichier, avec un
+    // matcher par worker. Requête vide ou invalide: aucun fichier lu.
+    bool ready = buffer_count > 0;
+    for (int i = 0; i < buffer_count; i++) {
+        memset(&workers[i], 0, sizeof(workers[i]));
+        workers[i].pipeline = &pipeline;
+        workers[i].matcher = search_run_matcher(run);
+        workers[i].buffer = &run->buffers[i];
+        workers[i].scan.run = run;
+        workers[i].scan.cancel = &run->cancel_requested;
+        workers[i].scan.max_size = run->content_max_size;
+        ready = ready && workers[i].matcher;
+    }
+    
+    pipeline.jobs = (ContentJob*)malloc(sizeof(ContentJob) * CONTENT_QUEUE_CAPACITY);
+    if (ready && pipeline.jobs && pthread_mutex_init(&pipeline.lock, NULL) == 0) {
+        pthread_cond_init(&pipeline.not_empty, NULL);
+        pthread_cond_init(&pipeline.not_full, NULL);
+        
+        for (int i = 0; i < thread_count && i < buffer_count; i++) {
+            if (pthread_create(&workers[started].thread, NULL, content_worker_function, &workers[started]) != 0) {
+                break;
+            }
+            started++;
+        }
+        
+        // Aucun lecteur: le premier tampon sert au parcours
+        if (started == 0) {
+            pipeline.inline_worker = &workers[0];
+        }
+        
+        // Trigrammes de l'index (complet): le parcours ne lit que les
+        // fichiers candidats et ceux modifiés depuis sa construction
+        if (run->index && run->index->content && !run->index->truncated && file_index_covers(run->index, path)) {
+            pipeline.candidates = index_select_candidates(run->index, workers[0].matcher);
+            pipeline.index = pipeline.candidates ? run->index : NULL;
+        }
+        
+        DIR* dir = open_directory_at(AT_FDCWD, path);
+        char path_buffer[MAX_PATH_LENGTH];
+        size_t dir_len = dir ? path_set_directory(path_buffer, path) : 0;
+        if (dir_len > 0) {
+            ExcludeFrame* root = exclude_frame_root(run->exclusions, path_buffer, dir_len);
+            ExcludeFrame* frame = exclude_frame_enter(root, dirfd(dir), dir_len);
+            content_walk_directory(&pipeline, dir, path_buffer, dir_len, depth, frame);
+            exclude_frame_release(frame);
+            exclude_frame_release(root);
+        }
+        if (dir) {
+            closedir(dir);
+        }
+        
+        // Fin du parcours: les workers vident la file puis s'arrêtent
+        pthread_mutex_lock(&pipeline.lock);
+        pipeline.closed = true;
+        pthread_cond_broadcast(&pipeline.not_empty);
+        pthread_mutex_unlock(&pipeline.lock);
+        
+        for (int i = 0; i < started; i++) {
+            pthread_join(workers[i].thread, NULL);
+        }
+        
+        pthread_cond_destroy(&pipeline.not_full);
+        pthread_cond_destroy(&pipeline.not_empty);
+        pthread_mutex_destroy(&pipeline.lock);
+    }
+    free(pipeline.jobs);
+    free(pipeline.candidates);
+    for (int i = 0; i < buffer_count; i++) {
+        content_matcher_destroy(workers[i].matcher);
+    }
+    
+    bool complete = search_buffers_close(run, results);
+    return complete && !atomic_load_explicit(&pipeline.limit_reached, memory_order_relaxed);
+}
+
+// === Recherche dans le thread courant ===
+// Les mêmes parcours instrumentés que la recherche asynchrone, avec une
+// génération locale et sans autre thread.
+
+// Génération d'une recherche synchrone
+static SearchRun* search_run_local(const char* path, const char* search_term, bool search_by_content, bool show_hidden) {
+    SearchRun* run = search_run_create();
+    if (!run) return NULL;
+    
+    strncpy(run->path, path, MAX_PATH_LENGTH - 1);
+    run->path[MAX_PATH_LENGTH - 1] = '\0';
+    strncpy(run->search_term, search_term, 255);
+    run->search_term[255] = '\0';
+    run->search_by_content = search_by_content;
+    run->show_hidden = show_hidden;
+    run->content_max_size = CONTENT_SEARCH_MAX_FILE_SIZE;
+    return run;
+}
+
+bool search_files_recursive(const char* path, const char* search_term, FileList* list, int depth, bool show_hidden) {
+    // Limites de sécurité
+    if (depth > MAX_SEARCH_DEPTH) {
+        return true;  // Continuer mais ne pas descendre plus profond
+    }
+    
+    if (list->truncated) {
+        return false;  // Budget mémoire atteint
+    }
+    
+    SearchRun* run = search_run_local(path, search_term, false, show_hidden);
+    if (!run) return true;
+    
+    bool complete = search_parallel_by_name(run, list, run->path, depth, run->search_term, show_hidden, 1);
+    search_run_release(run);
+    return complete;
+}
+
+bool search_files_by_content(const char* path, const char* search_term, FileList* list, int depth, bool show_hidden) {
+    // Limites de sécurité
+    if (depth > MAX_SEARCH_DEPTH) {
+        return true;
+    }
+    
+    if (list->truncated) {
+        return false;
+    }
+    
+    SearchRun* run = search_run_local(path, search_term, true, show_hidden);
+    if (!run) return true;
+    
+    bool complete = search_parallel_by_content(run, list, run->path, depth, show_hidden, 0);
+    search_run_release(run);
+    return complete;
+}
+
+// === Raffinement ===
+// Le nouveau terme contient l'ancien: ses résultats sont un sous-ensemble des
+// précédents (complets). Seuls ceux-ci sont testés, sans parcours: en
+// mémoire pour un nom, en relisant uniquement ces fichiers pour un contenu.
+static bool search_refine(SearchRun* run, FileList* live) {
+    if (search_buffers_open(run, 1, live->memory_budget) == 0) {
+        return true;
+    }
+    
+    const FileList* base = run->base;
+    SearchResultBuffer* buffer = &run->buffers[0];
+    size_t term_length = strlen(run->search_term);
+    bool room = true;
+    int files_scanned = 0;
+    ContentScan scan;
+    memset(&scan, 0, sizeof(scan));
+    scan.run = run;
+    scan.cancel = &run->cancel_requested;
+    scan.max_size = run->content_max_size;
+    bool use_matcher = run->search_by_content || run->query_type == SEARCH_QUERY_REGEX;
+    ContentMatcher* matcher = use_matcher ? search_run_matcher(run) : NULL;
+    int count = use_matcher && !matcher ? 0 : base->count;
+    
+    for (int i = 0; room && i < count; i++) {
+        if (atomic_load_explicit(&run->cancel_requested, memory_order_relaxed)) {
+            break;
+        }
+        
+        const FileEntry* entry = file_list_get(base, i);
+        bool matches;
+        ContentMatch match;
+        if (run->search_by_content) {
+            struct stat st;
+            matches = content_scan_file(&scan, file_entry_path(base, entry), matcher, &st, &match);
+        } else {
+            const char* name = file_entry_name(base, entry);
+            matches = matcher ? content_matcher_find(matcher, name, strlen(name), NULL, NULL) != NULL
+                              : memmem_icase(name, strlen(name), run->search_term, term_length) != NULL;
+        }
+        
+        if (++files_scanned == SEARCH_UPDATE_INTERVAL) {
+            atomic_fetch_add_explicit(&run->files_scanned, files_scanned, memory_order_relaxed);
+            content_scan_flush(&scan);
+            files_scanned = 0;
+        }
+        
+        if (matches) {
+            // Un seul producteur: publication comme pour un worker du parcours
+            room = file_list_add_entry(buffer->list, base, entry);
+            if (room) {
+                if (run->search_by_content) {
+                    FileEntry* added = file_list_get(buffer->list, buffer->list->count - 1);
+                    added->match_offset = match.offset;
+                    added->match_line = match.line;
+                }
+                atomic_store_explicit(&buffer->published, buffer->list->count, memory_order_release);
+                atomic_fetch_add_explicit(&run->files_matched, 1, memory_order_relaxed);
+            }
+        }
+    }
+    atomic_fetch_add_explicit(&run->files_scanned, files_scanned, memory_order_relaxed);
+    content_scan_flush(&scan);
+    content_matcher_destroy(matcher);
+    
+    bool complete = search_buffers_close(run, live);
+    return complete && room;
+}
+
+// Parcours réel de la génération; false si la limite est atteinte
+static bool search_run_walk(SearchRun* run, FileList* live) {
+    if (run->base) {
+        return search_refine(run, live);
+    }
+    
+    if (run->search_by_content) {
+        return search_parallel_by_content(run, live, run->path, 0, run->show_hidden, run->thread_count);
+    }
+    
+    // Réponse immédiate depuis l'index (sous-chaîne seulement): publiée
+    // comme résultats intermédiaires pendant le parcours réel, qui la
+    // remplace à la fin
+    if (run->index && run->query_type == SEARCH_QUERY_TEXT && file_index_covers(run->index, run->path)) {
+        FileList* indexed = file_list_create();
+        if (indexed) {
+            file_list_set_budget(indexed, run->memory_budget);
+            file_index_search(run->index, run->path, run->search_term, run->show_hidden, run->exclusions, indexed);
+            file_list_sort(indexed);
+            
+            pthread_mutex_lock(&run->mutex);
+            run->results = indexed;
+            pthread_mutex_unlock(&run->mutex);
+        }
+    }
+    
+    return search_parallel_by_name(run, live, run->path, 0, run->search_term, run->show_hidden, run->thread_count);
+}
+
+// Exécute une génération puis relâche la référence de l'exécutant
+static void search_run_execute(SearchRun* run) {
+    pthread_mutex_lock(&run->mutex);
+    clock_gettime(CLOCK_MONOTONIC, &run->start_time);
+    pthread_mutex_unlock(&run->mutex);
+    
+    // Paramètres figés avant la demande: lus sans verrou.
+    // Une génération abandonnée avant de commencer ne parcourt rien.
+    bool cancelled = atomic_load_explicit(&run->cancel_requested, memory_order_relaxed);
+    FileList* live = NULL;
+    bool limit_reached = false;
+    if (!cancelled && run->base_exact) {
+        // Même recherche qu'une précédente encore fraîche: ses résultats
+        live = file_list_retain(run->base);
+        atomic_store_explicit(&run->files_matched, live->count, memory_order_relaxed);
+    } else if (!cancelled) {
+        live = file_list_create();
+        if (live) {
+            file_list_set_budget(live, run->memory_budget);
+            limit_reached = !search_run_walk(run, live);
+            
+            // Trier avant de publier: le résultat du parcours réel remplace
+            // celui de l'index (les lecteurs gardent leur copie jusque-là).
+            // Une recherche approximative arrive déjà classée.
+            if (run->query_type != SEARCH_QUERY_FUZZY) {
+                file_list_sort(live);
+            }
+        } else {
+            // Mémoire insuffisante: aucun résultat, signalé comme tronqué
+            limit_reached = true;
+        }
+    }
+    
+    pthread_mutex_lock(&run->mutex);
+    file_list_destroy(run->results);
+    run->results = live;
+    
+    if (run->status == SEARCH_RUNNING) {
+        run->limit_reached = limit_reached;
+        run->elapsed_time = search_run_elapsed(run);
+        run->status = SEARCH_COMPLETED;
+    }
+    pthread_mutex_unlock(&run->mutex);
+    
+    // Dernière référence si la génération a été abandonnée entre-temps
+    search_run_release(run);
+}
+
+// Thread détaché d'une génération: il en détient la référence et ne touche
+// jamais l'AsyncSearch, qui peut être détruit avant qu'il ne termine
+static void* search_run_thread_function(void* arg) {
+    search_run_execute((SearchRun*)arg);
+    return NULL;
+}
+
+// Exécute la génération hors de l'ordonnanceur: un parcours abandonné mais
+// bloqué (NFS, disque lent) ne retarde pas la demande suivante
+static void search_run_launch(SearchRun* run) {
+    pthread_attr_t attr;
+    bool launched = false;
+    if (pthread_attr_init(&attr) == 0) {
+        pthread_t thread;
+        if (pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED) == 0 &&
+            pthread_create(&thread, &attr, search_run_thread_function, run) == 0) {
+            launched = true;
+        }
+        pthread_attr_destroy(&attr);
+    }
+    
+    // Plus de threads disponibles: exécuter ici plutôt que perdre la demande
+    if (!launched) {
+        search_run_execute(run);
+    }
+}
+
+// Ordonnanceur: attend qu'une demande soit restée sans successeur pendant le
+// délai, puis confie sa génération à un thread détaché. Le délai évite un
+// thread par frappe; les parcours eux-mêmes créent encore leurs workers
+// (search_parallel_by_name, search_parallel_by_content).
+static void* search_scheduler_function(void* arg) {
+    AsyncSearch* search = (AsyncSearch*)arg;
+    
+    pthread_mutex_lock(&search->mutex);
+    while (!search->shutdown) {
+        if (!search->pending) {
+            pthread_cond_wait(&search->wakeup, &search->mutex);
+            continue;
+        }
+        
+        // Une nouvelle demande repousse l'échéance et réveille l'ordonnanceur
+        struct timespec now;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        const struct timespec* deadline = &search->pending_deadline;
+        if (now.tv_sec < deadline->tv_sec ||
+            (now.tv_sec == deadline->tv_sec && now.tv_nsec < deadline->tv_nsec)) {
+            pthread_cond_timedwait(&search->wakeup, &search->mutex, deadline);
+            continue;
+        }
+        
+        SearchRun* run = search->pending;
+        search->pending = NULL;
+        pthread_mutex_unlock(&search->mutex);
+        
+        search_run_launch(run);
+        
+        pthread_mutex_lock(&search->mutex);
+    }
+    pthread_mutex_unlock(&search->mutex);
+    
+    return NULL;
+}
+
+// Un worker par cœur disponible par défaut
+static int default_search_thread_count(void) {
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    if (cpus < 1) return 1;
+    if (cpus > SEARCH_MAX_THREADS) return SEARCH_MAX_THREADS;
+    return (int)cpus;
+}
+
+AsyncSearch* async_search_create(void) {
+    AsyncSearch* search = (AsyncSearch*)malloc(sizeof(AsyncSearch));
+    if (!search) return NULL;
+    
+    if (pthread_mutex_init(&search->mutex, NULL) != 0) {
+        free(search);
+        return NULL;
+    }
+    
+    search->run = NULL;
+    search->generation = 0;
+    search->pending = NULL;
+    search->debounce_ms = SEARCH_DEBOUNCE_MS;
+    search->shutdown = false;
+    search->query_type = SEARCH_QUERY_TEXT;
+    search->thread_count = default_search_thread_count();
+    search->memory_budget = FILE_LIST_DEFAULT_BUDGET;
+    search->content_max_size = CONTENT_SEARCH_MAX_FILE_SIZE;
+    search->index = NULL;
+    search->exclusions = NULL;
+    memset(search->queries, 0, sizeof(search->queries));
+    search->query_clock = 0;
+    
+    // Échéance du délai en temps monotone: un réglage de l'horloge
+    // murale ne doit ni figer ni précipiter l'ordonnanceur
+    pthread_condattr_t wakeup_attr;
+    if (pthread_condattr_init(&wakeup_attr) != 0) {
+        pthread_mutex_destroy(&search->mutex);
+        free(search);
+        return NULL;
+    }
+    int wakeup_error = pthread_condattr_setclock(&wakeup_attr, CLOCK_MONOTONIC);
+    if (wakeup_error == 0) {
+        wakeup_error = pthread_cond_init(&search->wakeup, &wakeup_attr);
+    }
+    pthread_condattr_destroy(&wakeup_attr);
+    if (wakeup_error != 0) {
+        pthread_mutex_destroy(&search->mutex);
+        free(search);
+        return NULL;
+    }
+    if (pthread_create(&search->scheduler, NULL, search_scheduler_function, search) != 0) {
+        pthread_cond_destroy(&search->wakeup);
+        pthread_mutex_destroy(&search->mutex);
+        free(search);
+        return NULL;
+    }
+    
+    return search;
+}
+
+// === Recherches récentes (raffinement) ===
+// Manipulées par le thread de l'interface, sous search->mutex
+
+static void search_query_clear(SearchQuery* query) {
+    file_list_destroy(query->results);
+    query->results = NULL;
+}
+
+// Requête par contenu plus étroite que base_term: chacun de ses termes
+// contient l'un des termes de base_term (un fichier qui contient l'un des
+// premiers contient donc l'un des seconds)
+static bool content_query_refines(const char* search_term, const char* base_term) {
+    bool any = false;
+    for (const char* term = search_term; ; ) {
+        const char* term_end = strchr(term, CONTENT_PATTERN_SEPARATOR);
+        size_t term_length = term_end ? (size_t)(term_end - term) : strlen(term);
+        
+        if (term_length > 0) {
+            bool covered = false;
+            for (const char* base = base_term; !covered; ) {
+                const char* base_end = strchr(base, CONTENT_PATTERN_SEPARATOR);
+                size_t base_length = base_end ? (size_t)(base_end - base) : strlen(base);
+                covered = base_length > 0 && memmem_icase(term, term_length, base, base_length);
+                if (!base_end) break;
+                base = base_end + 1;
+            }
+            if (!covered) return false;
+            any = true;
+        }
+        
+        if (!term_end) break;
+        term = term_end + 1;
+    }
+    return any;
+}
+
+// Recherche passée dont la nouvelle est un raffinement: même dossier, mêmes
+// options et terme contenu dans le nouveau (à la casse près; terme par terme
+// pour une recherche par contenu). La plus précise l'emporte (terme le plus
+// long); les périmées sont oubliées. Une expression régulière n'en raffine
+// aucune autre, et une recherche approximative ne garde que ses meilleurs
+// résultats: seule la même requête est reprise.
+static SearchQuery* search_query_find(AsyncSearch* search, const char* path, const char* search_term, SearchQueryType query_type, bool search_by_content, bool show_hidden) {
+    time_t now = time(NULL);
+    size_t term_length = strlen(search_term);
+    SearchQuery* best = NULL;
+    size_t best_length = 0;
+    
+    for (int i = 0; i < SEARCH_QUERY_CACHE_SIZE; i++) {
+        SearchQuery* query = &search->queries[i];
+        if (!query->results) continue;
+        
+        if (difftime(now, query->completed_time) > SEARCH_QUERY_MAX_AGE) {
+            search_query_clear(query);
+            continue;
+        }
+        if (query->query_type != query_type || query->search_by_content != search_by_content ||
+            query->show_hidden != show_hidden || strcmp(query->path, path) != 0) {
+            continue;
+        }
+        
+        size_t length = strlen(query->search_term);
+        if (length > term_length || (best && length <= best_length)) continue;
+        if (query_type != SEARCH_QUERY_TEXT ? strcmp(search_term, query->search_term) != 0 :
+            search_by_content ? !content_query_refines(search_term, query->search_term)
+                              : !memmem_icase(search_term, term_length, query->search_term, length)) {
+            continue;
+        }
+        
+        best = query;
+        best_length = length;
+    }
+    return best;
+}
+
+// Garde les résultats complets d'une recherche terminée pour les suivantes
+static void search_query_store(AsyncSearch* search, const SearchRun* run, FileList* results) {
+    if (results->memory_used > SEARCH_QUERY_CACHE_BUDGET) return;
+    
+    // Même recherche (ex. réponse déjà tirée du cache), sinon emplacement
+    // libre, sinon la moins récemment utilisée
+    SearchQuery* slot = NULL;
+    for (int i = 0; i < SEARCH_QUERY_CACHE_SIZE; i++) {
+        SearchQuery* query = &search->queries[i];
+        if (query->results && query->query_type == run->query_type && query->search_by_content == run->search_by_content &&
+            query->show_hidden == run->show_hidden && strcmp(query->path, run->path) == 0 &&
+            strcmp(query->search_term, run->search_term) == 0) {
+            slot = query;
+            break;
+        }
+        if (!slot || (slot->results && (!query->results || query->last_used < slot->last_used))) {
+            slot = query;
+        }
+    }
+    
+    if (slot->results == results) {
+        slot->last_used = ++search->query_clock;
+        return;
+    }
+    search_query_clear(slot);
+    
+    // Budget: évincer les moins récemment utilisées
+    for (;;) {
+        size_t used = results->memory_used;
+        SearchQuery* oldest = NULL;
+        for (int i = 0; i < SEARCH_QUERY_CACHE_SIZE; i++) {
+            SearchQuery* query = &search->queries[i];
+            if (!query->results) continue;
+            used += query->results->memory_used;
+            if (!oldest || query->last_used < oldest->last_used) {
+                oldest = query;
+            }
+        }
+        if (used <= SEARCH_QUERY_CACHE_BUDGET || !oldest) break;
+        search_query_clear(oldest);
+    }
+    
+    strcpy(slot->path, run->path);
+    strcpy(slot->search_term, run->search_term);
+    slot->query_type = run->query_type;
+    slot->search_by_content = run->search_by_content;
+    slot->show_hidden = run->show_hidden;
+    slot->results = file_list_retain(results);
+    slot->completed_time = time(NULL);
+    slot->last_used = ++search->query_clock;
+}
+
+void async_search_forget_results(AsyncSearch* search) {
+    if (!search) return;
+    
+    pthread_mutex_lock(&search->mutex);
+    for (int i = 0; i < SEARCH_QUERY_CACHE_SIZE; i++) {
+        search_query_clear(&search->queries[i]);
+    }
+    pthread_mutex_unlock(&search->mutex);
+}
+
+// Génération courante avec une référence (NULL si aucune)
+static SearchRun* async_search_current(AsyncSearch* search) {
+    pthread_mutex_lock(&search->mutex);
+    SearchRun* run = search_run_retain(search->run);
+    pthread_mutex_unlock(&search->mutex);
+    return run;
+}
+
+// Retire la génération courante (et sa demande si elle attend encore
+// l'ordonnanceur); l'appelant hérite de sa référence
+static SearchRun* async_search_detach(AsyncSearch* search) {
+    pthread_mutex_lock(&search->mutex);
+    SearchRun* run = search->run;
+    SearchRun* pending = search->pending;
+    search->run = NULL;
+    search->pending = NULL;
+    pthread_mutex_unlock(&search->mutex);
+    
+    // La demande en attente est toujours la génération courante: jamais
+    // la dernière référence
+    search_run_release(pending);
+    return run;
+}
+
+void async_search_set_thread_count(AsyncSearch* search, int thread_count) {
+    if (!search) return;
+    
+    if (thread_count <= 0) {
+        thread_count = default_search_thread_count();
+    }
+    if (thread_count > SEARCH_MAX_THREADS) {
+        thread_count = SEARCH_MAX_THREADS;
+    }
+    
+    // Pris en compte au prochain async_search_start
+    pthread_mutex_lock(&search->mutex);
+    search->thread_count = thread_count;
+    pthread_mutex_unlock(&search->mutex);
+}
+
+void async_search_set_query_type(AsyncSearch* search, SearchQueryType query_type) {
+    if (!search) return;
+    
+    pthread_mutex_lock(&search->mutex);
+    search->query_type = query_type;
+    pthread_mutex_unlock(&search->mutex);
+}
+
+void async_search_set_memory_budget(AsyncSearch* search, size_t memory_budget) {
+    if (!search) return;
+    
+    pthread_mutex_lock(&search->mutex);
+    search->memory_budget = memory_budget > 0 ? memory_budget : FILE_LIST_DEFAULT_BUDGET;
+    pthread_mutex_unlock(&search->mutex);
+}
+
+void async_search_set_content_max_size(AsyncSearch* search, size_t max_size) {
+    if (!search) return;
+    
+    pthread_mutex_lock(&search->mutex);
+    bool changed = search->content_max_size != max_size;
+    search->content_max_size = max_size;
+    pthread_mutex_unlock(&search->mutex);
+    
+    // Les résultats gardés suivaient l'ancienne limite
+    if (changed) {
+        async_search_forget_results(search);
+    }
+}
+
+void async_search_set_debounce(AsyncSearch* search, int milliseconds) {
+    if (!search) return;
+    
+    pthread_mutex_lock(&search->mutex);
+    search->debounce_ms = milliseconds >= 0 ? milliseconds : SEARCH_DEBOUNCE_MS;
+    pthread_mutex_unlock(&search->mutex);
+}
+
+void async_search_start(AsyncSearch* search, const char* path, const char* search_term, bool search_by_content, bool show_hidden) {
+    if (!search || !path || !search_term) return;
+    
+    // Abandonner la génération précédente sans l'attendre: une demande pas
+    // encore exécutée disparaît, une génération en cours voit l'annulation
+    // entre deux entrées
+    SearchRun* previous = async_search_detach(search);
+    if (previous) {
+        search_run_cancel(previous);
+        search_run_release(previous);
+    }
+    
+    SearchRun* run = search_run_create();
+    if (!run) return;
+    
+    // Copier les paramètres
+    strncpy(run->path, path, MAX_PATH_LENGTH - 1);
+    run->path[MAX_PATH_LENGTH - 1] = '\0';
+    
+    strncpy(run->search_term, search_term, 255);
+    run->search_term[255] = '\0';
+    
+    run->search_by_content = search_by_content;
+    run->show_hidden = show_hidden;
+    clock_gettime(CLOCK_MONOTONIC, &run->start_time);
+    run->status = SEARCH_RUNNING;   // Dès la demande, même pendant le délai
+    
+    pthread_mutex_lock(&search->mutex);
+    run->generation = ++search->generation;
+    run->query_type = search->query_type;
+    if (search_by_content && run->query_type == SEARCH_QUERY_FUZZY) {
+        // Pas de classement approximatif du contenu: le terme est du texte
+        run->query_type = SEARCH_QUERY_TEXT;
+    }
+    run->thread_count = search->thread_count;
+    run->memory_budget = search->memory_budget;
+    run->content_max_size = search->content_max_size;
+    run->exclusions = exclude_rules_retain(search->exclusions);
+    
+    // Raffinement d'une recherche récente: filtrer ses résultats au lieu
+    // de parcourir à nouveau le disque
+    SearchQuery* query = search_query_find(search, run->path, run->search_term, run->query_type, search_by_content, show_hidden);
+    if (query) {
+        run->base = file_list_retain(query->results);
+        run->base_exact = strlen(query->search_term) == strlen(run->search_term);
+        query->last_used = ++search->query_clock;
+    } else if (search_by_content ? search->index && search->index->content : run->query_type == SEARCH_QUERY_TEXT) {
+        run->index = file_index_retain(search->index);
+    }
+    
+    search->run = run;
+    
+    // Confier la génération à l'ordonnanceur (qui en détient une référence).
+    // Un filtrage en mémoire est immédiat; un parcours attend que la saisie
+    // se calme.
+    int delay = run->base && (run->base_exact || !search_by_content) ? 0 : search->debounce_ms;
+    struct timespec* deadline = &search->pending_deadline;
+    clock_gettime(CLOCK_MONOTONIC, deadline);
+    deadline->tv_sec += delay / 1000;
+    deadline->tv_nsec += (long)(delay % 1000) * 1000000L;
+    if (deadline->tv_nsec >= 1000000000L) {
+        deadline->tv_sec++;
+        deadline->tv_nsec -= 1000000000L;
+    }
+    search->pending = search_run_retain(run);
+    pthread_cond_signal(&search->wakeup);
+    
+    pthread_mutex_unlock(&search->mutex);
+}
+
+SearchStatus async_search_status(AsyncSearch* search) {
+    if (!search) return SEARCH_IDLE;
+    
+    SearchRun* run = async_search_current(search);
+    if (!run) return SEARCH_IDLE;
+    
+    pthread_mutex_lock(&run->mutex);
+    SearchStatus status = run->status;
+    pthread_mutex_unlock(&run->mutex);
+    
+    search_run_release(run);
+    return status;
+}
+
+FileList* async_search_get_results(AsyncSearch* search, bool* limit_reached) {
+    if (!search) return NULL;
+    
+    SearchRun* run = async_search_current(search);
+    if (!run) return NULL;
+    
+    pthread_mutex_lock(&run->mutex);
+    
+    // La génération reste courante (statistiques finales) jusqu'à la suivante
+    FileList* results = NULL;
+    bool complete = false;
+    if (run->status == SEARCH_COMPLETED) {
+        results = run->results;
+        complete = results && !run->limit_reached;
+        if (limit_reached) {
+            *limit_reached = run->limit_reached;
+        }
+        run->results = NULL;
+        run->status = SEARCH_IDLE;
+    }
+    
+    pthread_mutex_unlock(&run->mutex);
+    
+    // Résultats complets: base des raffinements suivants (partagée sans copie)
+    if (complete) {
+        pthread_mutex_lock(&search->mutex);
+        search_query_store(search, run, results);
+        pthread_mutex_unlock(&search->mutex);
+    }
+    search_run_release(run);
+    
+    return results;
+}
+
+void async_search_get_progress(AsyncSearch* search, int* files_scanned, int* dirs_scanned, int* files_matched, double* elapsed_time) {
+    if (!search) return;
+    
+    SearchRun* run = async_search_current(search);
+    
+    // Compteurs lus sans verrou (versés par lots par les workers)
+    if (files_scanned) *files_scanned = run ? atomic_load_explicit(&run->files_scanned, memory_order_relaxed) : 0;
+    if (dirs_scanned) *dirs_scanned = run ? atomic_load_explicit(&run->dirs_scanned, memory_order_relaxed) : 0;
+    if (files_matched) *files_matched = run ? atomic_load_explicit(&run->files_matched, memory_order_relaxed) : 0;
+    
+    if (elapsed_time) {
+        *elapsed_time = 0.0;
+        if (run) {
+            pthread_mutex_lock(&run->mutex);
+            if (run->status == SEARCH_RUNNING) {
+                *elapsed_time = search_run_elapsed(run);
+            } else {
+                *elapsed_time = run->elapsed_time;
+            }
+            pthread_mutex_unlock(&run->mutex);
+        }
+    }
+    
+    search_run_release(run);
+}
+
+void async_search_get_stats(AsyncSearch* search, SearchStats* stats) {
+    if (!stats) return;
+    memset(stats, 0, sizeof(*stats));
+    if (!search) return;
+    
+    SearchRun* run = async_search_current(search);
+    if (!run) return;
+    
+    stats->files_scanned = atomic_load_explicit(&run->files_scanned, memory_order_relaxed);
+    stats->dirs_scanned = atomic_load_explicit(&run->dirs_scanned, memory_order_relaxed);
+    stats->files_matched = atomic_load_explicit(&run->files_matched, memory_order_relaxed);
+    stats->bytes_read = atomic_load_explicit(&run->bytes_read, memory_order_relaxed);
+    stats->files_binary = atomic_load_explicit(&run->files_binary, memory_order_relaxed);
+    stats->files_oversized = atomic_load_explicit(&run->files_oversized, memory_order_relaxed);
+    stats->files_pruned = atomic_load_explicit(&run->files_pruned, memory_order_relaxed);
+    
+    pthread_mutex_lock(&run->mutex);
+    stats->elapsed_time = run->status == SEARCH_RUNNING ? search_run_elapsed(run) : run->elapsed_time;
+    pthread_mutex_unlock(&run->mutex);
+    
+    if (stats->elapsed_time > 0.0) {
+        stats->files_per_second = stats->files_scanned / stats->elapsed_time;
+        stats->megabytes_per_second = (double)stats->bytes_read / (1024.0 * 1024.0) / stats->elapsed_time;
+    }
+    
+    search_run_release(run);
+}
+
+// Ajoute à results les entrées publiées au-delà du curseur (sous run->mutex,
+// qui garde seulement les tampons ouverts: les workers continuent d'ajouter)
+static int search_read_locked(SearchRun* run, SearchCursor* cursor, FileList* results) {
+    int added = 0;
+    bool room = true;
+    
+    // Résultats complets ou de l'index: une seule liste
+    if (run->results) {
+        const FileList* source = run->results;
+        while (room && cursor->results_read < source->count) {
+            room = file_list_add_entry(results, source, file_list_get(source, cursor->results_read));
+            if (room) {
+                cursor->results_read++;
+                added++;
+            }
+        }
+        return added;
+    }
+    
+    // Parcours en cours: entrées déjà publiées par chaque worker
+    for (int i = 0; room && i < run->buffer_count; i++) {
+        const SearchResultBuffer* buffer = &run->buffers[i];
+        int published = atomic_load_explicit(&buffer->published, memory_order_acquire);
+        while (room && cursor->buffers_read[i] < published) {
+            room = file_list_add_entry(results, buffer->list, file_list_get(buffer->list, cursor->buffers_read[i]));
+            if (room) {
+                cursor->buffers_read[i]++;
+                added++;
+            }
+        }
+    }
+    return added;
+}
+
+FileList* async_search_peek_results(AsyncSearch* search) {
+    if (!search) return NULL;
+    
+    SearchRun* run = async_search_current(search);
+    if (!run) return NULL;
+    
+    FileList* copy = file_list_create();
+    int added = 0;
+    if (copy) {
+        SearchCursor cursor;
+        async_search_cursor_init(&cursor);
+        
+        pthread_mutex_lock(&run->mutex);
+        file_list_set_budget(copy, run->memory_budget);
+        added = search_read_locked(run, &cursor, copy);
+        pthread_mutex_unlock(&run->mutex);
+    }
+    search_run_release(run);
+    
+    if (added == 0) {
+        file_list_destroy(copy);
+        return NULL;
+    }
+    return copy;
+}
+
+void async_search_cursor_init(SearchCursor* cursor) {
+    if (cursor) {
+        memset(cursor, 0, sizeof(SearchCursor));
+    }
+}
+
+int async_search_read_results(AsyncSearch* search, SearchCursor* cursor, FileList* results) {
+    if (!search || !cursor || !results) return 0;
+    
+    SearchRun* run = async_search_current(search);
+    if (!run) return 0;
+    
+    pthread_mutex_lock(&run->mutex);
+    
+    // Curseur d'une recherche précédente: repartir de zéro
+    if (cursor->generation != run->generation) {
+        if (cursor->generation != 0) {
+            file_list_clear(results);
+        }
+        async_search_cursor_init(cursor);
+        cursor->generation = run->generation;
+    }
+    
+    // La liste finale remplace celle de l'index: elle n'est pas une suite
+    int added = 0;
+    if (run->status == SEARCH_RUNNING) {
+        added = search_read_locked(run, cursor, results);
+    }
+    
+    pthread_mutex_unlock(&run->mutex);
+    search_run_release(run);
+    return added;
+}
+
+void async_search_cancel(AsyncSearch* search) {
+    if (!search) return;
+    
+    SearchRun* run = async_search_detach(search);
+    if (run) {
+        search_run_cancel(run);
+        search_run_release(run);
+    }
+}
+
+void async_search_destroy(AsyncSearch* search) {
+    if (!search) return;
+    
+    // La génération en cours est annulée; son thread détaché, s'il tourne
+    // encore, ne garde que ses propres références
+    async_search_cancel(search);
+    
+    pthread_mutex_lock(&search->mutex);
+    search->shutdown = true;
+    pthread_cond_signal(&search->wakeup);
+    pthread_mutex_unlock(&search->mutex);
+    pthread_join(search->scheduler, NULL);
+    
+    async_search_forget_results(search);
+    file_index_close(search->index);
+    exclude_rules_destroy(search->exclusions);
+    
+    pthread_cond_destroy(&search->wakeup);
+    pthread_mutex_destroy(&search->mutex);
+    free(search);
+}
+
+void async_search_set_index(AsyncSearch* search, FileIndex* index) {
+    if (!search) return;
+    
+    // Une recherche en cours garde sa propre référence sur l'ancien index
+    pthread_mutex_lock(&search->mutex);
+    FileIndex* previous = search->index;
+    search->index = file_index_retain(index);
+    pthread_mutex_unlock(&search->mutex);
+    
+    file_index_close(previous);
+}
+
+void async_search_set_exclusions(AsyncSearch* search, ExcludeRules* rules) {
+    if (!search) return;
+    
+    // Lues sans verrou par les workers: figées dès qu'elles sont partagées
+    if (rules) {
+        rules->shared = true;
+    }
+    
+    pthread_mutex_lock(&search->mutex);
+    ExcludeRules* previous = search->exclusions;
+    search->exclusions = exclude_rules_retain(rules);
+    pthread_mutex_unlock(&search->mutex);
+    
+    exclude_rules_destroy(previous);
+    
+    // Les résultats gardés suivaient les anciennes règles
+    async_search_forget_results(search);
+}
+
+// === Index persistant des noms ===
+// Fichier versionné, projeté en mémoire en lecture seule:
+//   [FileIndexHeader][FileIndexRecord x entry_count][zone des chaînes]
+//   [FileIndexTrigram x trigram_count][listes de fichiers]
+// La zone des chaînes commence par la racine indexée, puis contient pour
+// chaque enregistrement son chemin et son nom en minuscules. Les
+// enregistrements sont triés par chemin: les entrées sous un dossier forment
+// une plage contiguë, trouvée par dichotomie. Les trigrammes du contenu
+// (optionnels, alignés sur 8 octets) sont décrits avec leur section.
+#define FILE_INDEX_MAGIC "FILEXIDX"
+#define FILE_INDEX_FLAG_TRUNCATED 1u
+#define FILE_INDEX_FLAG_CONTENT 2u
+#define FILE_INDEX_RECORD_INDEXED 1u    // Trigrammes du fichier dans les listes
+#define FILE_INDEX_RECORD_BINARY 2u     // Ignoré par la recherche par contenu
+
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t record_size;       // sizeof(FileIndexRecord), vérifié à l'ouverture
+    uint64_t entry_count;
+    uint64_t records_offset;
+    uint64_t strings_offset;
+    uint64_t strings_size;
+    int64_t build_time;
+    uint32_t root_length;
+    uint32_t flags;
+    uint64_t trigram_count;     // 0: contenu non indexé
+    uint64_t trigrams_offset;   // Fin des chaînes arrondie à 8 octets
+    uint64_t postings_offset;   // Fin de la table des trigrammes
+    uint64_t postings_size;
+} FileIndexHeader;
+
+typedef struct {
+    uint64_t path_offset;       // Offsets dans la zone des chaînes
+    uint64_t lower_name_offset;
+    uint32_t path_length;
+    uint16_t name_offset;       // Début du nom dans le chemin
+    uint16_t flags;             // FILE_INDEX_RECORD_*
+    uint32_t mode;
+    uint32_t owner_uid;
+    uint32_t owner_gid;
+    uint32_t reserved2;
+    int64_t size;
+    int64_t mod_time;
+} FileIndexRecord;
+
+// Table des trigrammes, triée par trigramme
+typedef struct {
+    uint32_t trigram;           // Trois octets en minuscules: (a << 16) | (b << 8) | c
+    uint32_t count;             // Fichiers de sa liste
+    uint64_t offset;            // Début de sa liste dans la zone des listes
+} FileIndexTrigram;
+
+// Trigrammes du contenu prêts à écrire (section des trigrammes)
+typedef struct {
+    uint16_t* flags;            // Par enregistrement: FILE_INDEX_RECORD_*
+    FileIndexTrigram* table;
+    uint64_t trigram_count;
+    unsigned char* postings;
+    uint64_t postings_size;
+} IndexContent;
+
+static bool file_index_build_content(SearchRun* run, const FileList* list, const int* order, const FileIndex* old, int thread_count, IndexContent* content);
+static void index_content_free(IndexContent* content);
+
+struct FileIndexBuilder {
+    pthread_t thread;
+    SearchRun* run;             // Porte le parcours et son annulation
+    char root[MAX_PATH_LENGTH];
+    char index_path[MAX_PATH_LENGTH];
+    int thread_count;
+    bool index_content;
+    atomic_bool finished;
+    bool success;
+};
+
+bool file_index_default_path(char* buffer, size_t size) {
+    const char* cache_home = getenv("XDG_CACHE_HOME");
+    int written;
+    if (cache_home && cache_home[0] == '/') {
+        written = snprintf(buffer, size, "%s/filex/index.bin", cache_home);
+    } else {
+        const char* home = getenv("HOME");
+        if (!home || home[0] == '\0') return false;
+        written = snprintf(buffer, size, "%s/.cache/filex/index.bin", home);
+    }
+    return written > 0 && (size_t)written < size;
+}
+
+FileIndex* file_index_open(const char* index_path) {
+    if (!index_path) return NULL;
+    
+    int fd = open(index_path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return NULL;
+    
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (uint64_t)st.st_size < sizeof(FileIndexHeader)) {
+        close(fd);
+        return NULL;
+    }
+    
+    size_t size = (size_t)st.st_size;
+    void* data = mmap(NULL, size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) return NULL;
+    
+    // Valider l'en-tête et les bornes des zones avant toute lecture
+    const FileIndexHeader* header = (const FileIndexHeader*)data;
+    const char* strings = (const char*)data + header->strings_offset;
+    bool valid = memcmp(header->magic, FILE_INDEX_MAGIC, sizeof(header->magic)) == 0 &&
+                 header->version == FILE_INDEX_VERSION &&
+                 header->record_size == sizeof(FileIndexRecord) &&
+                 header->records_offset == sizeof(FileIndexHeader) &&
+                 header->entry_count <= (size - sizeof(FileIndexHeader)) / sizeof(FileIndexRecord) &&
+                 header->strings_offset == header->records_offset + header->entry_count * sizeof(FileIndexRecord) &&
+                 header->strings_size > 0 &&
+                 header->strings_size <= size - header->strings_offset &&
+                 header->trigrams_offset == ((header->strings_offset + header->strings_size + 7) & ~(uint64_t)7) &&
+                 header->trigrams_offset <= size &&
+                 header->trigram_count <= (size - header->trigrams_offset) / sizeof(FileIndexTrigram) &&
+                 header->postings_offset == header->trigrams_offset + header->trigram_count * sizeof(FileIndexTrigram) &&
+                 header->postings_size == size - header->postings_offset &&
+                 header->root_length > 0 && header->root_length < header->strings_size &&
+                 strings[header->root_length] == '\0' && strings[header->strings_size - 1] == '\0';
+    
+    FileIndex* index = valid ? (FileIndex*)malloc(sizeof(FileIndex)) : NULL;
+    if (!index) {
+        munmap(data, size);
+        return NULL;
+    }
+    
+    index->data = (const unsigned char*)data;
+    index->size = size;
+    index->root = strings;
+    index->root_length = header->root_length;
+    index->entry_count = header->entry_count;
+    index->build_time = (time_t)header->build_time;
+    index->truncated = (header->flags & FILE_INDEX_FLAG_TRUNCATED) != 0;
+    index->content = (header->flags & FILE_INDEX_FLAG_CONTENT) != 0;
+    index->trigram_count = header->trigram_count;
+    atomic_init(&index->refcount, 1);
+    return index;
+}
+
+FileIndex* file_index_retain(FileIndex* index) {
+    if (index) {
+        atomic_fetch_add_explicit(&index->refcount, 1, memory_order_relaxed);
+    }
+    return index;
+}
+
+void file_index_close(FileIndex* index) {
+    if (index && atomic_fetch_sub_explicit(&index->refcount, 1, memory_order_acq_rel) == 1) {
+        munmap((void*)index->data, index->size);
+        free(index);
+    }
+}
+
+// Longueur de path sans '/' final (la racine "/" garde le sien)
+static size_t index_path_length(const char* path) {
+    size_t len = strlen(path);
+    while (len > 1 && path[len - 1] == '/') {
+        len--;
+    }
+    return len;
+}
+
+bool file_index_covers(const FileIndex* index, const char* path) {
+    if (!index || !path) return false;
+    
+    size_t len = index_path_length(path);
+    if (len < index->root_length || memcmp(path, index->root, index->root_length) != 0) {
+        return false;
+    }
+    // Même dossier, ou sous-dossier (pas seulement un préfixe du nom)
+    return len == index->root_length || path[index->root_length] == '/' ||
+           index->root[index->root_length - 1] == '/';
+}
+
+// Enregistrement utilisable: chemin et nom en minuscules dans la zone des
+// chaînes, chemin terminé par son NUL, nom à l'intérieur du chemin
+static bool index_record_valid(const FileIndexHeader* header, const char* strings, const FileIndexRecord* record) {
+    return record->path_offset < header->strings_size &&
+           record->path_length < header->strings_size - record->path_offset &&
+           record->path_length < MAX_PATH_LENGTH &&
+           record->name_offset <= record->path_length &&
+           strings[record->path_offset + record->path_length] == '\0' &&
+           record->lower_name_offset < header->strings_size;
+}
+
+// Dossier de la pile de file_index_search: préfixe commun avec l'entrée courante
+typedef struct {
+    size_t length;              // Préfixe du dossier, '/' final compris
+    ExcludeFrame* frame;        // Règles applicables dans le dossier (référence)
+    bool skipped;               // Exclu, caché ou trop profond: son contenu aussi
+} IndexSearchLevel;
+
+bool file_index_search(const FileIndex* index, const char* path, const char* search_term, bool show_hidden, ExcludeRules* exclusions, FileList* results) {
+    if (!file_index_covers(index, path) || !search_term || !results) return true;
+    
+    const FileIndexHeader* header = (const FileIndexHeader*)index->data;
+    const FileIndexRecord* records = (const FileIndexRecord*)(index->data + header->records_offset);
+    const char* strings = (const char*)index->data + header->strings_offset;
+    
+    // Préfixe des entrées sous path: "path/"
+    char prefix[MAX_PATH_LENGTH];
+    size_t dir_len = index_path_length(path);
+    if (dir_len + 2 > sizeof(prefix)) return true;
+    memcpy(prefix, path, dir_len);
+    if (prefix[dir_len - 1] != '/') {
+        prefix[dir_len++] = '/';
+    }
+    prefix[dir_len] = '\0';
+    
+    char lower_search[256] = "";
+    for (int i = 0; search_term[i] && i < 255; i++) {
+        lower_search[i] = tolower(search_term[i]);
+        lower_search[i + 1] = '\0';
+    }
+    
+    // Premier enregistrement >= préfixe
+    uint64_t low = 0;
+    uint64_t high = index->entry_count;
+    while (low < high) {
+        uint64_t mid = low + (high - low) / 2;
+        if (records[mid].path_offset >= header->strings_size ||
+            strcmp(strings + records[mid].path_offset, prefix) < 0) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    
+    // Mêmes règles que le parcours (profondeur, cachés, exclusions), avec la
+    // pile des dossiers englobants: les entrées suivent l'ordre des chemins
+    IndexSearchLevel levels[MAX_SEARCH_DEPTH + 2];
+    int top = 0;
+    ExcludeFrame* root = exclude_frame_root(exclusions, prefix, dir_len);
+    levels[0].length = dir_len;
+    levels[0].frame = NULL;
+    levels[0].skipped = false;
+    if (root && root->gitignore) {
+        int fd = open(prefix, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+        levels[0].skipped = fd < 0;
+        if (fd >= 0) {
+            levels[0].frame = exclude_frame_enter(root, fd, dir_len);
+            close(fd);
+        }
+    } else {
+        levels[0].frame = exclude_frame_retain(root);
+    }
+    exclude_frame_release(root);
+    
+    char current[MAX_PATH_LENGTH];  // Dernière entrée retenue: les préfixes de la pile
+    memcpy(current, prefix, dir_len + 1);
+    bool room = true;
+    for (uint64_t i = low; i < index->entry_count && room && !levels[0].skipped; i++) {
+        const FileIndexRecord* record = &records[i];
+        if (!index_record_valid(header, strings, record)) {
+            continue;  // Enregistrement corrompu
+        }
         
-        if (cancelled) {
-            closedir(dir);
-            return false;
+        const char* entry_path = strings + record->path_offset;
+        size_t path_len = record->path_length;
+        if (strncmp(entry_path, prefix, dir_len) != 0) {
+            break;  // Fin de la plage du dossier
         }
         
-        if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0) {
+        if (strstr(strings + record->lower_name_offset, lower_search) == NULL) {
             continue;
         }
         
-        if (!show_hidden && entry->d_name[0] == '.') {
-            continue;
+        // Quitter les dossiers qui ne contiennent pas cette entrée
+        while (top > 0 && (levels[top].length > path_len || memcmp(entry_path, current, levels[top].length) != 0)) {
+            exclude_frame_release(levels[top].frame);
+            top--;
         }
+        memcpy(current, entry_path, path_len + 1);
         
-        // Vérifier exclusion
-        bool excluded = false;
-        for (int i = 0; EXCLUDED_DIRS[i] != NULL; i++) {
-            if (strcmp(entry->d_name, EXCLUDED_DIRS[i]) == 0) {
-                excluded = true;
-                break;
+        // Entrer dans ses dossiers comme le parcours (.gitignore compris)
+        const char* slash;
+        while (!levels[top].skipped &&
+               (slash = (const char*)memchr(entry_path + levels[top].length, '/', path_len - levels[top].length)) != NULL) {
+            IndexSearchLevel* parent = &levels[top];
+            IndexSearchLevel* level = &levels[top + 1];
+            size_t sub_len = (size_t)(slash - entry_path);
+            level->length = sub_len + 1;
+            level->frame = NULL;
+            level->skipped = top + 1 > MAX_SEARCH_DEPTH ||
+                             (!show_hidden && entry_path[parent->length] == '.') ||
+                             exclude_frame_match(parent->frame, entry_path, sub_len, parent->length, true);
+            if (!level->skipped && parent->frame && parent->frame->gitignore) {
+                current[level->length] = '\0';
+                int fd = open(current, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+                current[level->length] = entry_path[level->length];
+                level->skipped = fd < 0;
+                if (fd >= 0) {
+                    level->frame = exclude_frame_enter(parent->frame, fd, level->length);
+                    close(fd);
+                }
+            } else if (!level->skipped) {
+                level->frame = exclude_frame_retain(parent->frame);
             }
+            top++;
         }
-        if (excluded) continue;
         
-        char full_path[MAX_PATH_LENGTH];
-        snprintf(full_path, sizeof(full_path), "%s/%s", path, entry->d_name);
-        
-        struct stat st;
-        if (stat(full_path, &st) == -1) {
+        size_t name_offset = levels[top].length;
+        if (levels[top].skipped || memchr(entry_path + name_offset, '/', path_len - name_offset) != NULL ||
+            (!show_hidden && entry_path[name_offset] == '.') ||
+            exclude_frame_match(levels[top].frame, entry_path, path_len, name_offset, S_ISDIR(record->mode))) {
             continue;
         }
         
-        // Incrémenter le compteur de fichiers scannés
-        if (!S_ISDIR(st.st_mode)) {
-            pthread_mutex_lock(&search->mutex);
-            search->files_scanned++;
-            pthread_mutex_unlock(&search->mutex);
-        }
+        struct stat st;
+        memset(&st, 0, sizeof(st));
+        st.st_mode = (mode_t)record->mode;
+        st.st_size = (off_t)record->size;
+        st.st_mtime = (time_t)record->mod_time;
+        st.st_uid = (uid_t)record->owner_uid;
+        st.st_gid = (gid_t)record->owner_gid;
         
-        // Vérifier si le nom correspond
-        char lower_name[256];
-        for (int i = 0; entry->d_name[i] && i < 255; i++) {
-            lower_name[i] = tolower(entry->d_name[i]);
-            lower_name[i + 1] = '\0';
+        room = file_list_add(results, entry_path, path_len, record->name_offset, &st, top);
+    }
+    
+    for (; top >= 0; top--) {
+        exclude_frame_release(levels[top].frame);
+    }
+    return room;
+}
+
+// Liste en cours d'écriture dans l'index (tri des chemins par qsort)
+static _Thread_local const FileList* index_sort_list = NULL;
+
+static int compare_index_paths(const void* a, const void* b) {
+    const FileEntry* entry_a = file_list_get(index_sort_list, *(const int*)a);
+    const FileEntry* entry_b = file_list_get(index_sort_list, *(const int*)b);
+    return strcmp(file_entry_path(index_sort_list, entry_a), file_entry_path(index_sort_list, entry_b));
+}
+
+// Crée les dossiers parents de path (mkdir -p sans le dernier composant)
+static bool make_parent_directories(const char* path) {
+    char buffer[MAX_PATH_LENGTH];
+    size_t len = strlen(path);
+    if (len >= sizeof(buffer)) return false;
+    memcpy(buffer, path, len + 1);
+    
+    for (char* p = buffer + 1; *p; p++) {
+        if (*p != '/') continue;
+        *p = '\0';
+        if (mkdir(buffer, 0755) != 0 && errno != EEXIST) {
+            return false;
         }
+        *p = '/';
+    }
+    return true;
+}
+
+// Enregistrements de list triés par chemin (indices dans list)
+static int* file_index_order(const FileList* list) {
+    int* order = (int*)malloc(sizeof(int) * (list->count > 0 ? list->count : 1));
+    if (!order) return NULL;
+    
+    for (int i = 0; i < list->count; i++) {
+        order[i] = i;
+    }
+    index_sort_list = list;
+    qsort(order, list->count, sizeof(int), compare_index_paths);
+    index_sort_list = NULL;
+    return order;
+}
+
+// Écrit l'index dans un fichier temporaire puis le renomme: un lecteur voit
+// toujours soit l'ancien index complet, soit le nouveau
+static bool file_index_write(const FileList* list, const int* order, const char* root, const IndexContent* content, const char* index_path) {
+    FileIndexRecord* records = (FileIndexRecord*)calloc(list->count > 0 ? list->count : 1, sizeof(FileIndexRecord));
+    if (!records) return false;
+    
+    // Disposition de la zone des chaînes: racine, puis chemin et nom minuscule
+    size_t root_length = strlen(root);
+    uint64_t strings_size = root_length + 1;
+    for (int i = 0; i < list->count; i++) {
+        const FileEntry* entry = file_list_get(list, order[i]);
+        FileIndexRecord* record = &records[i];
+        record->path_offset = strings_size;
+        record->path_length = entry->path_length;
+        record->name_offset = entry->name_offset;
+        record->flags = content ? content->flags[i] : 0;
+        record->lower_name_offset = strings_size + entry->path_length + 1;
+        record->mode = (uint32_t)entry->permissions;
+        record->owner_uid = (uint32_t)entry->owner_uid;
+        record->owner_gid = (uint32_t)entry->owner_gid;
+        record->size = entry->size;
+        record->mod_time = (int64_t)entry->mod_time;
+        strings_size += 2 * (uint64_t)entry->path_length - entry->name_offset + 2;
+    }
+    
+    FileIndexHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, FILE_INDEX_MAGIC, sizeof(header.magic));
+    header.version = FILE_INDEX_VERSION;
+    header.record_size = sizeof(FileIndexRecord);
+    header.entry_count = (uint64_t)list->count;
+    header.records_offset = sizeof(FileIndexHeader);
+    header.strings_offset = header.records_offset + header.entry_count * sizeof(FileIndexRecord);
+    header.strings_size = strings_size;
+    header.build_time = (int64_t)time(NULL);
+    header.root_length = (uint32_t)root_length;
+    header.flags = (list->truncated ? FILE_INDEX_FLAG_TRUNCATED : 0) | (content ? FILE_INDEX_FLAG_CONTENT : 0);
+    header.trigram_count = content ? content->trigram_count : 0;
+    header.trigrams_offset = (header.strings_offset + strings_size + 7) & ~(uint64_t)7;
+    header.postings_offset = header.trigrams_offset + header.trigram_count * sizeof(FileIndexTrigram);
+    header.postings_size = content ? content->postings_size : 0;
+    
+    char temp_path[MAX_PATH_LENGTH + 8];
+    snprintf(temp_path, sizeof(temp_path), "%s.tmp", index_path);
+    
+    bool ok = make_parent_directories(index_path);
+    FILE* file = ok ? fopen(temp_path, "wb") : NULL;
+    ok = file != NULL;
+    if (ok) {
+        ok = fwrite(&header, sizeof(header), 1, file) == 1 &&
+             (list->count == 0 || fwrite(records, sizeof(FileIndexRecord), list->count, file) == (size_t)list->count) &&
+             fwrite(root, 1, root_length + 1, file) == root_length + 1;
         
-        bool matches = strstr(lower_name, lower_search) != NULL;
-        
-        if (matches) {
-            FileEntry file_entry;
-            strncpy(file_entry.path, full_path, sizeof(file_entry.path) - 1);
-            file_entry.path[sizeof(file_entry.path) - 1] = '\0';
+        for (int i = 0; ok && i < list->count; i++) {
+            const FileEntry* entry = file_list_get(list, order[i]);
+            const char* entry_path = file_entry_path(list, entry);
             
-            strncpy(file_entry.name, entry->d_name, sizeof(file_entry.name) - 1);
-            file_entry.name[sizeof(file_entry.name) - 1] = '\0';
-            
-            file_entry.size = st.st_size;
-            file_entry.depth = depth;
-            
-            // Récupérer les métadonnées
-            get_file_metadata(full_path, &file_entry);
-            
-            if (S_ISDIR(st.st_mode)) {
-                file_entry.type = FILE_TYPE_DIRECTORY;
-            } else {
-                file_entry.type = FILE_TYPE_FILE;
+            char lower_name[MAX_PATH_LENGTH];
+            size_t name_length = entry->path_length - entry->name_offset;
+            for (size_t j = 0; j < name_length; j++) {
+                lower_name[j] = tolower((unsigned char)entry_path[entry->name_offset + j]);
             }
+            lower_name[name_length] = '\0';
             
-            file_list_add(list, &file_entry);
-            
-            pthread_mutex_lock(&search->mutex);
-            search->files_matched++;
-            pthread_mutex_unlock(&search->mutex);
+            ok = fwrite(entry_path, 1, entry->path_length + 1, file) == (size_t)entry->path_length + 1 &&
+                 fwrite(lower_name, 1, name_length + 1, file) == name_length + 1;
         }
         
-        // Continuer la recherche récursive
-        if (S_ISDIR(st.st_mode)) {
-            if (!search_recursive_with_stats(search, full_path, search_term, list, depth + 1, show_hidden)) {
-                closedir(dir);
-                return false;
-            }
+        static const char padding[8] = {0};
+        size_t padding_size = (size_t)(header.trigrams_offset - header.strings_offset - strings_size);
+        ok = ok && (padding_size == 0 || fwrite(padding, 1, padding_size, file) == padding_size);
+        if (ok && content) {
+            ok = (content->trigram_count == 0 ||
+                  fwrite(content->table, sizeof(FileIndexTrigram), content->trigram_count, file) == content->trigram_count) &&
+                 (content->postings_size == 0 ||
+                  fwrite(content->postings, 1, content->postings_size, file) == content->postings_size);
+        }
+        
+        ok = (fclose(file) == 0) && ok;
+        ok = ok && rename(temp_path, index_path) == 0;
+        if (!ok) {
+            unlink(temp_path);
         }
     }
     
-    closedir(dir);
-    return true;
+    free(records);
+    return ok;
 }
 
-static void* search_thread_function(void* arg) {
-    SearchThreadData* data = (SearchThreadData*)arg;
-    AsyncSearch* search = data->search;
+// Parcours complet de root (tous les fichiers, cachés compris), trigrammes
+// du contenu si demandés, puis écriture; run porte l'annulation
+static bool file_index_build_with(SearchRun* run, const char* root, const char* index_path, int thread_count, bool index_content) {
+    char real_root[PATH_MAX];
+    if (!realpath(root, real_root) || strlen(real_root) >= MAX_PATH_LENGTH) {
+        return false;
+    }
     
-    pthread_mutex_lock(&search->mutex);
-    if (search->status != SEARCH_RUNNING) {
-        pthread_mutex_unlock(&search->mutex);
-        free(data);
-        return NULL;
+    FileList* list = file_list_create();
+    if (!list) return false;
+    file_list_set_budget(list, FILE_INDEX_BUILD_BUDGET);
+    
+    pthread_mutex_lock(&run->mutex);
+    bool cancelled = atomic_load_explicit(&run->cancel_requested, memory_order_relaxed);
+    if (!cancelled) {
+        run->status = SEARCH_RUNNING;
     }
-    search->start_time = time(NULL);
-    pthread_mutex_unlock(&search->mutex);
+    pthread_mutex_unlock(&run->mutex);
     
-    // Effectuer la recherche
-    bool limit_reached;
-    if (search->search_by_content) {
-        limit_reached = !search_files_by_content(
-            search->path, 
-            search->search_term, 
-            search->results, 
-            0, 
-            search->show_hidden
-        );
-    } else {
-        limit_reached = !search_recursive_with_stats(
-            search,
-            search->path, 
-            search->search_term, 
-            search->results, 
-            0, 
-            search->show_hidden
-        );
+    // Un terme vide correspond à toutes les entrées
+    if (!cancelled) {
+        search_parallel_by_name(run, list, real_root, 0, "", true, thread_count);
     }
     
-    // Trier les résultats
-    file_list_sort(search->results);
+    pthread_mutex_lock(&run->mutex);
+    cancelled = run->status == SEARCH_CANCELLED;
+    run->status = SEARCH_IDLE;
+    pthread_mutex_unlock(&run->mutex);
     
-    pthread_mutex_lock(&search->mutex);
-    if (search->status == SEARCH_RUNNING) {
-        search->limit_reached = limit_reached;
-        search->elapsed_time = difftime(time(NULL), search->start_time);
-        search->status = SEARCH_COMPLETED;
+    int* order = cancelled ? NULL : file_index_order(list);
+    bool ok = order != NULL;
+    
+    // L'index précédent de la même racine fournit les trigrammes des
+    // fichiers inchangés
+    IndexContent content;
+    bool with_content = false;
+    if (ok && index_content) {
+        FileIndex* old = file_index_open(index_path);
+        if (old && strcmp(old->root, real_root) != 0) {
+            file_index_close(old);
+            old = NULL;
+        }
+        with_content = file_index_build_content(run, list, order, old, thread_count, &content);
+        file_index_close(old);
+        ok = with_content || !atomic_load_explicit(&run->cancel_requested, memory_order_relaxed);
     }
-    pthread_mutex_unlock(&search->mutex);
     
-    free(data);
+    ok = ok && file_index_write(list, order, real_root, with_content ? &content : NULL, index_path);
+    if (with_content) {
+        index_content_free(&content);
+    }
+    free(order);
+    file_list_destroy(list);
+    return ok;
+}
+
+bool file_index_build(const char* root, const char* index_path, int thread_count, bool index_content) {
+    if (!root || !index_path) return false;
+    
+    SearchRun* run = search_run_create();
+    if (!run) return false;
+    
+    bool ok = file_index_build_with(run, root, index_path,
+                                    thread_count > 0 ? thread_count : default_search_thread_count(), index_content);
+    search_run_release(run);
+    return ok;
+}
+
+static void* file_index_builder_function(void* arg) {
+    FileIndexBuilder* builder = (FileIndexBuilder*)arg;
+    builder->success = file_index_build_with(builder->run, builder->root, builder->index_path, builder->thread_count,
+                                             builder->index_content);
+    atomic_store_explicit(&builder->finished, true, memory_order_release);
     return NULL;
 }
 
-AsyncSearch* async_search_create(void) {
-    AsyncSearch* search = (AsyncSearch*)malloc(sizeof(AsyncSearch));
-    if (!search) return NULL;
+FileIndexBuilder* file_index_build_start(const char* root, const char* index_path, int thread_count, bool index_content) {
+    if (!root || !index_path || strlen(root) >= MAX_PATH_LENGTH || strlen(index_path) >= MAX_PATH_LENGTH) {
+        return NULL;
+    }
     
-    if (pthread_mutex_init(&search->mutex, NULL) != 0) {
-        free(search);
+    FileIndexBuilder* builder = (FileIndexBuilder*)calloc(1, sizeof(FileIndexBuilder));
+    if (!builder) return NULL;
+    
+    builder->run = search_run_create();
+    if (!builder->run) {
+        free(builder);
         return NULL;
     }
     
-    search->status = SEARCH_IDLE;
-    search->path[0] = '\0';
-    search->search_term[0] = '\0';
-    search->search_by_content = false;
-    search->show_hidden = false;
-    search->results = NULL;
-    search->limit_reached = false;
-    search->files_scanned = 0;
-    search->dirs_scanned = 0;
-    search->files_matched = 0;
-    search->start_time = 0;
-    search->elapsed_time = 0.0;
+    strcpy(builder->root, root);
+    strcpy(builder->index_path, index_path);
+    builder->thread_count = thread_count > 0 ? thread_count : default_search_thread_count();
+    builder->index_content = index_content;
+    atomic_init(&builder->finished, false);
     
-    return search;
+    if (pthread_create(&builder->thread, NULL, file_index_builder_function, builder) != 0) {
+        search_run_release(builder->run);
+        free(builder);
+        return NULL;
+    }
+    
+    return builder;
 }
 
-void async_search_start(AsyncSearch* search, const char* path, const char* search_term, bool search_by_content, bool show_hidden) {
-    if (!search || !path || !search_term) return;
+bool file_index_build_finished(FileIndexBuilder* builder, bool* success) {
+    if (!builder) return false;
     
-    pthread_mutex_lock(&search->mutex);
+    if (!atomic_load_explicit(&builder->finished, memory_order_acquire)) {
+        return false;
+    }
+    if (success) {
+        *success = builder->success;
+    }
+    return true;
+}
+
+void file_index_build_destroy(FileIndexBuilder* builder) {
+    if (!builder) return;
     
-    // Annuler toute recherche en cours
-    if (search->status == SEARCH_RUNNING) {
-        search->status = SEARCH_CANCELLED;
-        pthread_mutex_unlock(&search->mutex);
-        pthread_join(search->thread, NULL);
-        pthread_mutex_lock(&search->mutex);
+    // Les workers du parcours vérifient le drapeau entre deux entrées
+    search_run_cancel(builder->run);
+    
+    pthread_join(builder->thread, NULL);
+    search_run_release(builder->run);
+    free(builder);
+}
+
+// === Trigrammes du contenu ===
+// Option de l'index persistant: pour chaque trigramme (trois octets
+// consécutifs, en minuscules ASCII comme les motifs), la liste croissante
+// des enregistrements qui le contiennent, en écarts varint. Un terme d'au
+// moins trois octets ne peut se trouver que dans les fichiers qui
+// contiennent tous ses trigrammes: l'intersection de leurs listes désigne
+// les seuls fichiers à lire, et chacun est vérifié par la lecture. Les
+// binaires, que la recherche par contenu ignore, ne figurent nulle part.
+// Les listes décrivent le contenu lors de la construction: la recherche
+// parcourt toujours l'arborescence et ne se fie aux listes que pour un
+// fichier régulier dont la taille et la date de modification égalent
+// celles de son enregistrement; les fichiers nouveaux, modifiés ou non
+// indexés (trop gros, illisibles, budget atteint) sont toujours lus.
+#define FILE_INDEX_TRIGRAM_SPACE (1u << 24)
+#define FILE_INDEX_POSTING_COST 16          // Octets de construction par entrée de liste
+
+static inline uint32_t index_trigram_push(uint32_t window, unsigned char c) {
+    return ((window << 8) | ascii_lower(c)) & (FILE_INDEX_TRIGRAM_SPACE - 1);
+}
+
+static inline size_t index_varint_length(uint32_t value) {
+    size_t length = 1;
+    while (value >= 0x80) {
+        value >>= 7;
+        length++;
+    }
+    return length;
+}
+
+// 7 bits par octet, bit de poids fort: octet suivant
+static inline unsigned char* index_varint_write(unsigned char* out, uint32_t value) {
+    while (value >= 0x80) {
+        *out++ = (unsigned char)(value | 0x80);
+        value >>= 7;
+    }
+    *out++ = (unsigned char)value;
+    return out;
+}
+
+static inline bool index_varint_read(const unsigned char** cursor, const unsigned char* end, uint32_t* value) {
+    uint32_t result = 0;
+    for (int shift = 0; shift < 35 && *cursor < end; shift += 7) {
+        unsigned char byte = *(*cursor)++;
+        result |= (uint32_t)(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) {
+            *value = result;
+            return true;
+        }
+    }
+    return false;
+}
+
+// Lecture séquentielle d'une liste de fichiers
+typedef struct {
+    const unsigned char* cursor;
+    const unsigned char* end;
+    uint32_t remaining;
+    uint32_t current;
+    bool started;
+} IndexPostingCursor;
+
+static void index_posting_open(const FileIndex* index, const FileIndexTrigram* entry, IndexPostingCursor* cursor) {
+    const FileIndexHeader* header = (const FileIndexHeader*)index->data;
+    const unsigned char* postings = index->data + header->postings_offset;
+    cursor->cursor = postings + (entry->offset < header->postings_size ? entry->offset : header->postings_size);
+    cursor->end = postings + header->postings_size;
+    cursor->remaining = entry->count;
+    cursor->current = 0;
+    cursor->started = false;
+}
+
+// Enregistrement suivant (false à la fin ou si la liste est tronquée)
+static bool index_posting_next(IndexPostingCursor* cursor, uint32_t* id) {
+    uint32_t delta;
+    if (cursor->remaining == 0 || !index_varint_read(&cursor->cursor, cursor->end, &delta)) {
+        return false;
+    }
+    cursor->remaining--;
+    cursor->current = cursor->started ? cursor->current + delta : delta;
+    cursor->started = true;
+    *id = cursor->current;
+    return true;
+}
+
+static const FileIndexTrigram* index_trigram_find(const FileIndex* index, uint32_t trigram) {
+    const FileIndexHeader* header = (const FileIndexHeader*)index->data;
+    const FileIndexTrigram* table = (const FileIndexTrigram*)(index->data + header->trigrams_offset);
+    uint64_t low = 0;
+    uint64_t high = header->trigram_count;
+    while (low < high) {
+        uint64_t mid = low + (high - low) / 2;
+        if (table[mid].trigram < trigram) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    return low < header->trigram_count && table[low].trigram == trigram ? &table[low] : NULL;
+}
+
+// Trigrammes d'un lecteur (ou repris de l'ancien index), bout à bout
+typedef struct {
+    uint32_t* data;
+    size_t count;
+    size_t capacity;
+} IndexTrigramArray;
+
+static bool index_trigram_array_reserve(IndexTrigramArray* array, size_t extra) {
+    if (array->count + extra <= array->capacity) return true;
+    size_t capacity = array->capacity > 0 ? array->capacity : 4096;
+    while (capacity < array->count + extra) {
+        capacity *= 2;
+    }
+    uint32_t* data = (uint32_t*)realloc(array->data, capacity * sizeof(uint32_t));
+    if (!data) return false;
+    array->data = data;
+    array->capacity = capacity;
+    return true;
+}
+
+// Construction: les trigrammes de chaque enregistrement (ordre de l'index)
+// sont dans un des tableaux: 0 pour ceux repris de l'ancien index, 1 + n
+// pour ceux lus par le lecteur n
+typedef struct {
+    SearchRun* run;                 // Annulation
+    const FileList* list;
+    const int* order;               // Enregistrement -> entrée de list
+    int count;
+    uint16_t* flags;                // FILE_INDEX_RECORD_*
+    uint8_t* source;
+    size_t* start;
+    uint32_t* length;
+    IndexTrigramArray arrays[SEARCH_MAX_THREADS + 1];
+    int* pending;                   // Enregistrements à lire
+    int pending_count;
+    atomic_int next_pending;
+    atomic_llong budget;            // Entrées de listes encore admises
+} IndexContentBuild;
+
+typedef struct {
+    IndexContentBuild* build;
+    int slot;
+    pthread_t thread;
+} IndexContentReader;
+
+// Réserve amount entrées du budget; un refus le laisse intact (une
+// soustraction annulée après coup ferait refuser à tort les lecteurs voisins)
+static bool index_budget_reserve(IndexContentBuild* build, long long amount) {
+    long long available = atomic_load_explicit(&build->budget, memory_order_relaxed);
+    while (available >= amount) {
+        if (atomic_compare_exchange_weak_explicit(&build->budget, &available, available - amount,
+                                                  memory_order_relaxed, memory_order_relaxed)) {
+            return true;
+        }
     }
+    return false;
+}
+
+// Lit le fichier de l'enregistrement id et ajoute ses trigrammes distincts au
+// tableau slot (seen: un bit par trigramme, remis à zéro en sortie). Un
+// fichier illisible, qui a grossi au-delà de la limite ou qui dépasse le
+// budget reste non indexé.
+static void index_content_read(IndexContentBuild* build, int id, int slot, uint64_t* seen, unsigned char* buffer) {
+    IndexTrigramArray* array = &build->arrays[slot];
+    const FileEntry* entry = file_list_get(build->list, build->order[id]);
+    int fd = open(file_entry_path(build->list, entry), O_RDONLY | O_CLOEXEC | O_NOCTTY | O_NONBLOCK);
+    if (fd < 0) return;
     
-    // Nettoyer les anciens résultats
-    if (search->results) {
-        file_list_destroy(search->results);
+    size_t start = array->count;
+    bool complete = true;
+    bool binary = false;
+    uint32_t window = 0;
+    size_t total = 0;
+    for (;;) {
+        ssize_t bytes_read = read(fd, buffer, CONTENT_SEARCH_READ_BUFFER);
+        if (bytes_read < 0 && errno == EINTR) continue;
+        if (bytes_read <= 0) {
+            complete = bytes_read == 0;
+            break;
+        }
+        if (total == 0 && content_looks_binary(buffer, (size_t)bytes_read)) {
+            binary = true;
+            break;
+        }
+        if (total + (size_t)bytes_read > FILE_INDEX_CONTENT_MAX_FILE_SIZE ||
+            !index_trigram_array_reserve(array, (size_t)bytes_read)) {
+            complete = false;
+            break;
+        }
+        for (ssize_t i = 0; i < bytes_read; i++) {
+            window = index_trigram_push(window, buffer[i]);
+            uint64_t bit = 1ULL << (window & 63);
+            if (++total >= 3 && !(seen[window >> 6] & bit)) {
+                seen[window >> 6] |= bit;
+                array->data[array->count++] = window;
+            }
+        }
     }
+    close(fd);
     
-    // Créer une nouvelle liste de résultats
-    search->results = file_list_create();
-    if (!search->results) {
-        pthread_mutex_unlock(&search->mutex);
+    for (size_t i = start; i < array->count; i++) {
+        seen[array->data[i] >> 6] = 0;
+    }
+    size_t found = array->count - start;
+    if (binary) {
+        array->count = start;
+        build->flags[id] = FILE_INDEX_RECORD_BINARY;
         return;
     }
-    
-    // Copier les paramètres
-    strncpy(search->path, path, MAX_PATH_LENGTH - 1);
-    search->path[MAX_PATH_LENGTH - 1] = '\0';
-    
-    strncpy(search->search_term, search_term, 255);
-    search->search_term[255] = '\0';
-    
-    search->search_by_content = search_by_content;
-    search->show_hidden = show_hidden;
-    search->limit_reached = false;
-    search->files_scanned = 0;
-    search->dirs_scanned = 0;
-    search->files_matched = 0;
-    search->start_time = time(NULL);
-    search->elapsed_time = 0.0;
-    search->status = SEARCH_RUNNING;
-    
-    // Créer et lancer le thread
-    SearchThreadData* data = (SearchThreadData*)malloc(sizeof(SearchThreadData));
-    data->search = search;
-    
-    if (pthread_create(&search->thread, NULL, search_thread_function, data) != 0) {
-        free(data);
-        search->status = SEARCH_IDLE;
-        pthread_mutex_unlock(&search->mutex);
+    if (!complete || !index_budget_reserve(build, (long long)found)) {
+        array->count = start;
         return;
     }
-    
-    pthread_mutex_unlock(&search->mutex);
+    build->flags[id] = FILE_INDEX_RECORD_INDEXED;
+    build->source[id] = (uint8_t)slot;
+    build->start[id] = start;
+    build->length[id] = (uint32_t)found;
 }
 
-SearchStatus async_search_status(AsyncSearch* search) {
-    if (!search) return SEARCH_IDLE;
+static void* index_content_reader_function(void* arg) {
+    IndexContentReader* reader = (IndexContentReader*)arg;
+    IndexContentBuild* build = reader->build;
     
-    pthread_mutex_lock(&search->mutex);
-    SearchStatus status = search->status;
-    pthread_mutex_unlock(&search->mutex);
-    
-    return status;
+    uint64_t* seen = (uint64_t*)calloc(FILE_INDEX_TRIGRAM_SPACE / 64, sizeof(uint64_t));
+    unsigned char* buffer = (unsigned char*)malloc(CONTENT_SEARCH_READ_BUFFER);
+    while (seen && buffer && !atomic_load_explicit(&build->run->cancel_requested, memory_order_relaxed)) {
+        int next = atomic_fetch_add_explicit(&build->next_pending, 1, memory_order_relaxed);
+        if (next >= build->pending_count) break;
+        index_content_read(build, build->pending[next], reader->slot, seen, buffer);
+    }
+    free(buffer);
+    free(seen);
+    return NULL;
 }
 
-FileList* async_search_get_results(AsyncSearch* search, bool* limit_reached) {
-    if (!search) return NULL;
+// Reprend les trigrammes des fichiers inchangés depuis l'ancien index (même
+// chemin, même taille, même date): ils ne sont pas relus
+static void index_content_reuse(IndexContentBuild* build, const FileIndex* old) {
+    const FileIndexHeader* header = (const FileIndexHeader*)old->data;
+    const FileIndexRecord* records = (const FileIndexRecord*)(old->data + header->records_offset);
+    const FileIndexTrigram* table = (const FileIndexTrigram*)(old->data + header->trigrams_offset);
+    const char* strings = (const char*)old->data + header->strings_offset;
     
-    pthread_mutex_lock(&search->mutex);
+    // Ancien enregistrement -> nouveau (-1: non repris); les deux suivent
+    // l'ordre des chemins
+    int* mapping = (int*)malloc(sizeof(int) * (old->entry_count > 0 ? old->entry_count : 1));
+    if (!mapping) return;
+    uint64_t j = 0;
+    for (int id = 0; id < build->count; id++) {
+        const FileEntry* entry = file_list_get(build->list, build->order[id]);
+        const char* entry_path = file_entry_path(build->list, entry);
+        int compare = 1;
+        for (; j < old->entry_count; j++) {
+            mapping[j] = -1;
+            if (records[j].path_offset >= header->strings_size) continue;
+            compare = strcmp(strings + records[j].path_offset, entry_path);
+            if (compare >= 0) break;
+        }
+        if (j == old->entry_count) break;
+        if (compare != 0) continue;
+        
+        const FileIndexRecord* record = &records[j++];
+        if (S_ISREG(entry->permissions) && S_ISREG(record->mode) &&
+            record->size == entry->size && record->mod_time == (int64_t)entry->mod_time) {
+            if (record->flags & FILE_INDEX_RECORD_INDEXED) {
+                mapping[j - 1] = id;
+            } else if (record->flags & FILE_INDEX_RECORD_BINARY) {
+                build->flags[id] = FILE_INDEX_RECORD_BINARY;
+            }
+        }
+    }
+    for (; j < old->entry_count; j++) {
+        mapping[j] = -1;
+    }
     
-    if (search->status != SEARCH_COMPLETED) {
-        pthread_mutex_unlock(&search->mutex);
-        return NULL;
+    // Deux passes sur les anciennes listes: tailles, puis trigrammes
+    for (int pass = 0; pass < 2; pass++) {
+        for (uint64_t t = 0; t < header->trigram_count; t++) {
+            if (table[t].trigram >= FILE_INDEX_TRIGRAM_SPACE) continue;
+            IndexPostingCursor cursor;
+            index_posting_open(old, &table[t], &cursor);
+            uint32_t old_id;
+            while (index_posting_next(&cursor, &old_id)) {
+                if (old_id >= old->entry_count || mapping[old_id] < 0) continue;
+                int id = mapping[old_id];
+                if (pass == 1) {
+                    build->arrays[0].data[build->start[id] + build->length[id]] = table[t].trigram;
+                }
+                build->length[id]++;
+            }
+        }
+        
+        if (pass == 1) break;
+        size_t total = 0;
+        for (uint64_t k = 0; k < old->entry_count; k++) {
+            if (mapping[k] < 0) continue;
+            int id = mapping[k];
+            build->start[id] = total;
+            total += build->length[id];
+            build->length[id] = 0;
+        }
+        if (atomic_load_explicit(&build->budget, memory_order_relaxed) < (long long)total ||
+            !index_trigram_array_reserve(&build->arrays[0], total)) {
+            free(mapping);
+            return;  // Tout sera relu
+        }
+        atomic_fetch_sub_explicit(&build->budget, (long long)total, memory_order_relaxed);
+        build->arrays[0].count = total;
     }
     
-    FileList* results = search->results;
-    if (limit_reached) {
-        *limit_reached = search->limit_reached;
+    for (uint64_t k = 0; k < old->entry_count; k++) {
+        if (mapping[k] >= 0) {
+            build->flags[mapping[k]] = FILE_INDEX_RECORD_INDEXED;
+            build->source[mapping[k]] = 0;
+        }
     }
+    free(mapping);
+}
+
+// Inverse les trigrammes des enregistrements en listes par trigramme (tri
+// par comptage: les enregistrements sont vus dans l'ordre, chaque liste
+// est donc croissante)
+static bool index_content_invert(IndexContentBuild* build, IndexContent* content) {
+    uint32_t* positions = (uint32_t*)calloc(FILE_INDEX_TRIGRAM_SPACE, sizeof(uint32_t));
+    if (!positions) return false;
     
-    search->results = NULL;
-    search->status = SEARCH_IDLE;
+    size_t total = 0;
+    for (int id = 0; id < build->count; id++) {
+        if (!(build->flags[id] & FILE_INDEX_RECORD_INDEXED)) continue;
+        const uint32_t* trigrams = build->arrays[build->source[id]].data + build->start[id];
+        for (uint32_t k = 0; k < build->length[id]; k++) {
+            positions[trigrams[k]]++;
+        }
+        total += build->length[id];
+    }
     
-    pthread_mutex_unlock(&search->mutex);
+    uint64_t trigram_count = 0;
+    for (uint32_t t = 0; t < FILE_INDEX_TRIGRAM_SPACE; t++) {
+        trigram_count += positions[t] > 0;
+    }
+    FileIndexTrigram* table = (FileIndexTrigram*)malloc(sizeof(FileIndexTrigram) * (trigram_count > 0 ? trigram_count : 1));
+    uint32_t* ids = (uint32_t*)malloc(sizeof(uint32_t) * (total > 0 ? total : 1));
+    if (!table || !ids) {
+        free(positions);
+        free(table);
+        free(ids);
+        return false;
+    }
     
-    return results;
-}
-
-void async_search_get_progress(AsyncSearch* search, int* files_scanned, int* dirs_scanned, int* files_matched, double* elapsed_time) {
-    if (!search) return;
+    // Début de chaque liste, puis remplissage dans l'ordre des enregistrements
+    uint64_t entry = 0;
+    uint32_t offset = 0;
+    for (uint32_t t = 0; t < FILE_INDEX_TRIGRAM_SPACE; t++) {
+        if (positions[t] == 0) continue;
+        table[entry].trigram = t;
+        table[entry].count = positions[t];
+        entry++;
+        uint32_t count = positions[t];
+        positions[t] = offset;
+        offset += count;
+    }
+    for (int id = 0; id < build->count; id++) {
+        if (!(build->flags[id] & FILE_INDEX_RECORD_INDEXED)) continue;
+        const uint32_t* trigrams = build->arrays[build->source[id]].data + build->start[id];
+        for (uint32_t k = 0; k < build->length[id]; k++) {
+            ids[positions[trigrams[k]]++] = (uint32_t)id;
+        }
+    }
+    free(positions);
     
-    pthread_mutex_lock(&search->mutex);
+    // Taille exacte des listes codées, puis codage
+    uint64_t postings_size = 0;
+    size_t begin = 0;
+    for (uint64_t e = 0; e < entry; e++) {
+        for (uint32_t k = 0; k < table[e].count; k++) {
+            uint32_t id = ids[begin + k];
+            postings_size += index_varint_length(k > 0 ? id - ids[begin + k - 1] : id);
+        }
+        begin += table[e].count;
+    }
     
-    if (files_scanned) *files_scanned = search->files_scanned;
-    if (dirs_scanned) *dirs_scanned = search->dirs_scanned;
-    if (files_matched) *files_matched = search->files_matched;
-    if (elapsed_time) {
-        if (search->status == SEARCH_RUNNING) {
-            *elapsed_time = difftime(time(NULL), search->start_time);
-        } else {
-            *elapsed_time = search->elapsed_time;
+    unsigned char* postings = (unsigned char*)malloc(postings_size > 0 ? postings_size : 1);
+    if (!postings) {
+        free(table);
+        free(ids);
+        return false;
+    }
+    unsigned char* out = postings;
+    begin = 0;
+    for (uint64_t e = 0; e < entry; e++) {
+        table[e].offset = (uint64_t)(out - postings);
+        for (uint32_t k = 0; k < table[e].count; k++) {
+            uint32_t id = ids[begin + k];
+            out = index_varint_write(out, k > 0 ? id - ids[begin + k - 1] : id);
         }
+        begin += table[e].count;
     }
+    free(ids);
     
-    pthread_mutex_unlock(&search->mutex);
+    content->table = table;
+    content->trigram_count = trigram_count;
+    content->postings = postings;
+    content->postings_size = postings_size;
+    return true;
 }
 
-FileList* async_search_peek_results(AsyncSearch* search) {
-    if (!search) return NULL;
+static void index_content_free(IndexContent* content) {
+    free(content->flags);
+    free(content->table);
+    free(content->postings);
+    memset(content, 0, sizeof(*content));
+}
+
+// Trigrammes du contenu des fichiers de list (order: ordre de l'index),
+// repris de old pour les fichiers inchangés, lus par thread_count lecteurs
+// pour les autres. false si la construction est annulée ou échoue.
+static bool file_index_build_content(SearchRun* run, const FileList* list, const int* order, const FileIndex* old, int thread_count, IndexContent* content) {
+    memset(content, 0, sizeof(*content));
     
-    pthread_mutex_lock(&search->mutex);
+    IndexContentBuild* build = (IndexContentBuild*)calloc(1, sizeof(IndexContentBuild));
+    if (!build) return false;
+    build->run = run;
+    build->list = list;
+    build->order = order;
+    build->count = list->count;
+    atomic_init(&build->next_pending, 0);
+    atomic_init(&build->budget, (long long)(FILE_INDEX_CONTENT_BUDGET / FILE_INDEX_POSTING_COST));
     
-    if (!search->results || search->results->count == 0) {
-        pthread_mutex_unlock(&search->mutex);
-        return NULL;
+    size_t count = list->count > 0 ? (size_t)list->count : 1;
+    build->flags = (uint16_t*)calloc(count, sizeof(uint16_t));
+    build->source = (uint8_t*)calloc(count, sizeof(uint8_t));
+    build->start = (size_t*)calloc(count, sizeof(size_t));
+    build->length = (uint32_t*)calloc(count, sizeof(uint32_t));
+    build->pending = (int*)malloc(sizeof(int) * count);
+    bool ok = build->flags && build->source && build->start && build->length && build->pending;
+    
+    if (ok && old && old->content) {
+        index_content_reuse(build, old);
     }
     
-    // Créer une copie des résultats actuels
-    FileList* copy = file_list_create();
-    if (!copy) {
-        pthread_mutex_unlock(&search->mutex);
-        return NULL;
+    // Fichiers à lire: réguliers, ni repris ni trop gros; un fichier vide
+    // n'a aucun trigramme (et la recherche par contenu l'ignore)
+    for (int id = 0; ok && id < build->count; id++) {
+        const FileEntry* entry = file_list_get(list, order[id]);
+        if (build->flags[id] || !S_ISREG(entry->permissions)) continue;
+        if (entry->size == 0) {
+            build->flags[id] = FILE_INDEX_RECORD_INDEXED;
+        } else if (entry->size <= FILE_INDEX_CONTENT_MAX_FILE_SIZE) {
+            build->pending[build->pending_count++] = id;
+        }
     }
     
-    for (int i = 0; i < search->results->count && i < MAX_FILES; i++) {
-        if (copy->count >= copy->capacity) {
-            int new_capacity = copy->capacity * 2;
-            if (new_capacity > MAX_FILES) new_capacity = MAX_FILES;
-            FileEntry* new_entries = (FileEntry*)realloc(copy->entries, sizeof(FileEntry) * new_capacity);
-            if (!new_entries) break;
-            copy->entries = new_entries;
-            copy->capacity = new_capacity;
+    if (ok && build->pending_count > 0) {
+        if (thread_count < 1) thread_count = 1;
+        if (thread_count > SEARCH_MAX_THREADS) thread_count = SEARCH_MAX_THREADS;
+        IndexContentReader readers[SEARCH_MAX_THREADS];
+        int started = 0;
+        for (int i = 0; i < thread_count; i++) {
+            readers[started].build = build;
+            readers[started].slot = started + 1;
+            if (pthread_create(&readers[started].thread, NULL, index_content_reader_function, &readers[started]) != 0) {
+                break;
+            }
+            started++;
+        }
+        if (started == 0) {
+            readers[0].build = build;
+            readers[0].slot = 1;
+            index_content_reader_function(&readers[0]);
+        }
+        for (int i = 0; i < started; i++) {
+            pthread_join(readers[i].thread, NULL);
         }
-        copy->entries[copy->count++] = search->results->entries[i];
     }
     
-    pthread_mutex_unlock(&search->mutex);
+    ok = ok && !atomic_load_explicit(&run->cancel_requested, memory_order_relaxed) &&
+         index_content_invert(build, content);
+    if (ok) {
+        content->flags = build->flags;
+        build->flags = NULL;
+    }
     
-    return copy;
+    for (int i = 0; i <= SEARCH_MAX_THREADS; i++) {
+        free(build->arrays[i].data);
+    }
+    free(build->flags);
+    free(build->source);
+    free(build->start);
+    free(build->length);
+    free(build->pending);
+    free(build);
+    return ok;
 }
 
-void async_search_cancel(AsyncSearch* search) {
-    if (!search) return;
+// Marque dans selected (un bit par enregistrement) les fichiers qui
+// contiennent tous les trigrammes du terme (en minuscules): intersection des
+// listes, de la plus courte à la plus longue
+static bool index_mark_term(const FileIndex* index, const unsigned char* term, size_t length, uint64_t* selected) {
+    const FileIndexTrigram* entries[256];
+    int entry_count = 0;
+    uint32_t window = 0;
+    for (size_t i = 0; i < length && i < 256 + 2; i++) {
+        window = index_trigram_push(window, term[i]);
+        if (i < 2) continue;
+        const FileIndexTrigram* entry = index_trigram_find(index, window);
+        if (!entry) return true;  // Aucun fichier ne contient le terme
+        
+        // Insertion par nombre de fichiers croissant, sans doublon
+        int position = entry_count;
+        bool duplicate = false;
+        for (int k = 0; k < entry_count && !duplicate; k++) {
+            duplicate = entries[k] == entry;
+        }
+        if (duplicate) continue;
+        while (position > 0 && entries[position - 1]->count > entry->count) {
+            entries[position] = entries[position - 1];
+            position--;
+        }
+        entries[position] = entry;
+        entry_count++;
+    }
+    if (entry_count == 0) return true;
     
-    pthread_mutex_lock(&search->mutex);
+    uint32_t* ids = (uint32_t*)malloc(sizeof(uint32_t) * (entries[0]->count > 0 ? entries[0]->count : 1));
+    if (!ids) return false;
+    uint32_t id_count = 0;
+    IndexPostingCursor cursor;
+    index_posting_open(index, entries[0], &cursor);
+    while (index_posting_next(&cursor, &ids[id_count])) {
+        id_count++;
+    }
     
-    if (search->status == SEARCH_RUNNING) {
-        search->status = SEARCH_CANCELLED;
-        pthread_mutex_unlock(&search->mutex);
-        pthread_join(search->thread, NULL);
-    } else {
-        pthread_mutex_unlock(&search->mutex);
+    for (int k = 1; k < entry_count && id_count > 0; k++) {
+        index_posting_open(index, entries[k], &cursor);
+        uint32_t kept = 0;
+        uint32_t other = 0;
+        bool more = index_posting_next(&cursor, &other);
+        for (uint32_t i = 0; i < id_count && more; i++) {
+            while (more && other < ids[i]) {
+                more = index_posting_next(&cursor, &other);
+            }
+            if (more && other == ids[i]) {
+                ids[kept++] = ids[i];
+            }
+        }
+        id_count = kept;
+    }
+    
+    for (uint32_t i = 0; i < id_count; i++) {
+        if (ids[i] < index->entry_count) {
+            selected[ids[i] >> 6] |= 1ULL << (ids[i] & 63);
+        }
     }
+    free(ids);
+    return true;
 }
 
-void async_search_destroy(AsyncSearch* search) {
-    if (!search) return;
-    
-    async_search_cancel(search);
+// Enregistrements qui peuvent contenir une occurrence: ceux d'un des termes
+// requis par matcher. NULL si l'index ne peut pas
+// restreindre la recherche (terme de moins de trois octets, expression
+// régulière sans littéral requis).
+static uint64_t* index_select_candidates(const FileIndex* index, const ContentMatcher* matcher) {
+    const ContentMatcher* required = matcher->regex ? matcher->regex->prefilter : matcher;
+    if (!required || required->pattern_count == 0 || required->min_length < 3) {
+        return NULL;
+    }
     
-    if (search->results) {
-        file_list_destroy(search->results);
+    uint64_t* selected = (uint64_t*)calloc(index->entry_count / 64 + 1, sizeof(uint64_t));
+    if (!selected) return NULL;
+    for (int i = 0; i < required->pattern_count; i++) {
+        if (!index_mark_term(index, required->patterns[i], required->lengths[i], selected)) {
+            free(selected);
+            return NULL;
+        }
+    }
+    return selected;
+}
+
+// Enregistrement de path (-1: absent de l'index)
+static int64_t index_record_find(const FileIndex* index, const char* path) {
+    const FileIndexHeader* header = (const FileIndexHeader*)index->data;
+    const FileIndexRecord* records = (const FileIndexRecord*)(index->data + header->records_offset);
+    const char* strings = (const char*)index->data + header->strings_offset;
+    uint64_t low = 0;
+    uint64_t high = index->entry_count;
+    while (low < high) {
+        uint64_t mid = low + (high - low) / 2;
+        int compare = records[mid].path_offset < header->strings_size ? strcmp(strings + records[mid].path_offset, path) : -1;
+        if (compare == 0) return (int64_t)mid;
+        if (compare < 0) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
     }
+    return -1;
+}
+
+// Vrai si le fichier path (st: son fstatat lors du parcours) doit être lu:
+// absent de l'index, modifié depuis, jamais indexé, ou retenu par candidates
+static bool file_index_may_contain(const FileIndex* index, const uint64_t* candidates, const char* path, const struct stat* st) {
+    int64_t i = index_record_find(index, path);
+    if (i < 0) return true;
     
-    pthread_mutex_destroy(&search->mutex);
-    free(search);
+    const FileIndexHeader* header = (const FileIndexHeader*)index->data;
+    const FileIndexRecord* record = (const FileIndexRecord*)(index->data + header->records_offset) + i;
+    if (!S_ISREG(record->mode) || record->size != (int64_t)st->st_size || record->mod_time != (int64_t)st->st_mtime ||
+        !(record->flags & (FILE_INDEX_RECORD_INDEXED | FILE_INDEX_RECORD_BINARY))) {
+        return true;  // Modifié depuis la construction, ou jamais indexé
+    }
+    return (candidates[i >> 6] >> (i & 63)) & 1;
 }
@@ -2,55 +2,174 @@
 #define FILE_EXPLORER_H
 
 #include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdatomic.h>
 #include <time.h>
 #include <pthread.h>
 #include <sys/stat.h>
 
 #define MAX_PATH_LENGTH 1024
-#define MAX_FILES 10000
-#define MAX_SEARCH_RESULTS 5000  // Augmenté pour permettre plus de résultats
 #define MAX_SEARCH_DEPTH 15      // Augmenté pour chercher plus profond
-#define MAX_CACHE_ENTRIES 10
-#define MAX_CACHE_FILE_SIZE 1048576  // 1MB max pour le cache
+#define CACHE_DEFAULT_BUDGET (64UL * 1024 * 1024)  // Budget mémoire par défaut du cache de dossiers
+#define CACHE_INITIAL_BUCKETS 64                    // Taille initiale de la table de hachage du cache
+#define CACHE_WATCH_COALESCE_MS 20                  // Attente maximale de la suite d'une rafale d'événements inotify
+#define CACHE_WATCH_IN_PLACE 16                     // Au-delà (changements par lot), un listing surveillé est recopié
+#define CACHE_COMPACT_DEAD_BYTES (64 * 1024)        // Arène morte au-delà de laquelle un listing surveillé est compacté
+#define FILE_INDEX_VERSION 2                        // Version du format de l'index persistant
+#define FILE_INDEX_MAX_AGE (24 * 60 * 60)           // Au-delà (secondes), l'index est reconstruit
+#define FILE_INDEX_BUILD_BUDGET (1024UL * 1024 * 1024)  // Budget mémoire de la construction de l'index
+#define FILE_INDEX_CONTENT_BUDGET (1024UL * 1024 * 1024)  // Budget mémoire des trigrammes du contenu (au-delà: fichiers non indexés)
+#define FILE_INDEX_CONTENT_MAX_FILE_SIZE (16 * 1024 * 1024)  // Fichiers plus gros non indexés (toujours lus)
+#define CONTENT_SEARCH_WINDOW (8 * 1024 * 1024)    // Fenêtre projetée par la recherche par contenu
+#define CONTENT_SEARCH_READ_BUFFER (256 * 1024)    // Tampon du repli sans mmap
+#define CONTENT_SEARCH_MAX_FILE_SIZE 0              // Fichiers plus gros ignorés (0: aucune limite)
+#define CONTENT_PATTERN_SEPARATOR '|'               // Sépare les termes d'une recherche par contenu
+#define CONTENT_REGEX_MAX_SPAN (16 * 1024)          // Occurrence d'expression régulière la plus longue vue à cheval sur deux fenêtres
 #define SEARCH_UPDATE_INTERVAL 100  // Mettre à jour l'UI tous les 100 fichiers
+#define SEARCH_MAX_THREADS 64       // Nombre maximum de workers d'une recherche
+#define SEARCH_QUERY_CACHE_SIZE 8   // Recherches complètes gardées pour le raffinement
+#define SEARCH_QUERY_CACHE_BUDGET (64UL * 1024 * 1024)  // Mémoire maximale de leurs résultats
+#define SEARCH_FUZZY_MAX_RESULTS 1000  // Meilleures correspondances gardées par une recherche approximative
+#define SEARCH_QUERY_MAX_AGE 60     // Au-delà (secondes), des résultats ne sont plus réutilisés
+#define SEARCH_DEBOUNCE_MS 150      // Inactivité de la saisie avant de lancer un parcours
+#define CONTENT_QUEUE_CAPACITY 256  // Fichiers en attente entre parcours et lecteurs
+#define CONTENT_URING_BATCH 32      // Fichiers par lot io_uring (FILEX_HAVE_IO_URING)
+#define CONTENT_URING_READ_SIZE (16 * 1024)  // Premier bloc lu via io_uring
+#define FILE_LIST_CHUNK_ENTRIES 1024            // Entrées par segment de FileList
+#define FILE_LIST_STRING_BLOCK (64 * 1024)      // Taille d'un bloc de l'arène des chemins
+#define FILE_LIST_FIRST_CHUNK_ENTRIES 32        // Premier segment, doublé jusqu'à FILE_LIST_CHUNK_ENTRIES
+#define FILE_LIST_FIRST_BLOCK (1024)            // Premier bloc, doublé jusqu'à FILE_LIST_STRING_BLOCK
+#define FILE_LIST_DEFAULT_BUDGET (256UL * 1024 * 1024)  // Budget mémoire par défaut d'une liste
 
 typedef enum {
     FILE_TYPE_FILE,
     FILE_TYPE_DIRECTORY
 } FileType;
 
+// Entrée compacte: le chemin est stocké dans l'arène de la FileList et le nom
+// en est un suffixe. Utiliser file_entry_path()/file_entry_name() pour y accéder.
 typedef struct {
-    char path[MAX_PATH_LENGTH];
-    char name[256];
+    uint32_t path_offset;      // Offset du chemin dans l'arène de la liste
+    uint16_t path_length;      // Longueur du chemin (sans le '\0')
+    uint16_t name_offset;      // Début du nom dans le chemin
     FileType type;
-    long size;
     int depth;
+    long size;
     // Métadonnées
     time_t mod_time;           // Date de modification
     mode_t permissions;         // Permissions (mode)
     uid_t owner_uid;           // UID du propriétaire
     gid_t owner_gid;           // GID du groupe
+    // Première occurrence (recherche par contenu)
+    long match_offset;         // Octet de début dans le fichier
+    int match_line;            // Ligne, à partir de 1 (0: aucune ou inconnue)
+    int score;                 // Pertinence d'une recherche approximative (0 sinon)
 } FileEntry;
 
+// Liste segmentée: les entrées sont allouées par segments de taille fixe et
+// l'arène par blocs. Seuls le premier segment et le premier bloc, petits au
+// départ (une petite liste reste petite), sont agrandis par doublement
+// jusqu'à la taille fixe; au-delà, rien n'est plus déplacé lors d'un ajout.
+// La taille n'est bornée que par le budget.
+// Une liste partagée (refcount > 1, ex. entre le cache et la vue) est un
+// instantané immuable: la modifier impose file_list_make_writable().
 typedef struct {
-    FileEntry* entries;
+    FileEntry** chunks;        // Segments de FILE_LIST_CHUNK_ENTRIES entrées
+    int chunk_count;
+    int chunk_capacity;        // Taille de la table des segments
     int count;
-    int capacity;
+    int dir_count;             // Nombre d'entrées de type dossier (tenu à jour à l'ajout)
+    // Arène des chemins (terminés par '\0'), en blocs de FILE_LIST_STRING_BLOCK
+    char** blocks;
+    int block_count;
+    int block_capacity;
+    size_t block_used;         // Octets utilisés dans le dernier bloc
+    int first_chunk_entries;   // Entrées allouées dans le premier segment
+    size_t first_block_size;   // Octets alloués pour le premier bloc
+    bool pinned;               // Lue pendant les ajouts: premier segment et bloc alloués entiers
+    // Budget mémoire
+    size_t memory_used;        // Octets alloués pour les segments et les blocs
+    size_t memory_budget;      // Au-delà, les ajouts sont refusés
+    bool truncated;            // Au moins une entrée refusée faute de budget
+    atomic_int refcount;       // Nombre de détenteurs de la liste
 } FileList;
 
 // Structure pour le cache de répertoires
-typedef struct {
-    char path[MAX_PATH_LENGTH];
+// Chaque entrée est à la fois dans une chaîne de la table de hachage et dans
+// la liste LRU (tête: plus récemment utilisée, queue: prochaine évincée)
+typedef struct CacheEntry {
+    struct CacheEntry* hash_next;
+    struct CacheEntry* lru_prev;
+    struct CacheEntry* lru_next;
+    uint64_t hash;
     FileList* files;
-    time_t last_access;
+    size_t bytes;              // Coût de l'entrée imputé au budget du cache
     bool show_hidden;
+    int watch_descriptor;      // Watch inotify du dossier (-1 si aucun)
+    int* name_slots;           // Hachage des noms du listing: indice + 1 (0: libre; NULL: à construire)
+    int name_capacity;         // Puissance de 2, au moins le double des entrées
+    size_t dead_bytes;         // Arène occupée par les chemins d'entrées retirées
+    unsigned long version;     // Change à chaque mise à jour du listing
+    char path[];
 } CacheEntry;
 
+// Compteurs du cache (copie instantanée)
 typedef struct {
-    CacheEntry entries[MAX_CACHE_ENTRIES];
+    unsigned long hits;
+    unsigned long misses;
+    unsigned long evictions;
     int count;
+    size_t memory_used;
+    size_t memory_budget;
+} CacheStats;
+
+typedef struct {
+    CacheEntry** buckets;
+    int bucket_count;
+    int count;
+    CacheEntry* lru_head;
+    CacheEntry* lru_tail;
+    size_t memory_used;
+    size_t memory_budget;
+    unsigned long hits;
+    unsigned long misses;
+    unsigned long evictions;
+    // Protège les entrées: le watcher les modifie depuis son thread
+    pthread_mutex_t mutex;
+    unsigned long next_version;
+    // Surveillance inotify (Linux): invalide ou corrige les listings en cache
+    bool watching;
+    int inotify_fd;
+    int stop_pipe[2];
+    pthread_t watch_thread;
+    void (*change_callback)(void* user_data);
+    void* change_user_data;
 } DirectoryCache;
 
+// Index persistant des noms (et, en option, des trigrammes du contenu):
+// fichier versionné projeté en mémoire (lecture seule), partagé entre
+// threads par comptage de références
+typedef struct {
+    const unsigned char* data;  // Projection du fichier
+    size_t size;
+    const char* root;           // Dossier indexé (chemin absolu)
+    size_t root_length;
+    uint64_t entry_count;
+    time_t build_time;
+    bool truncated;             // Index partiel (budget de construction atteint)
+    bool content;               // Trigrammes du contenu présents (recherche par contenu)
+    uint64_t trigram_count;
+    atomic_int refcount;
+} FileIndex;
+
+// Construction de l'index en arrière-plan
+typedef struct FileIndexBuilder FileIndexBuilder;
+
+// Règles d'exclusion des parcours récursifs (syntaxe .gitignore), partagées
+// par comptage de références et immuables une fois confiées à une recherche
+typedef struct ExcludeRules ExcludeRules;
+
 // Structure pour la recherche asynchrone
 typedef enum {
     SEARCH_IDLE,
@@ -59,37 +178,160 @@ typedef enum {
     SEARCH_CANCELLED
 } SearchStatus;
 
+// Interprétation du terme d'une recherche
+typedef enum {
+    SEARCH_QUERY_TEXT,          // Sous-chaîne (termes séparés par CONTENT_PATTERN_SEPARATOR pour le contenu)
+    SEARCH_QUERY_REGEX,         // Expression régulière (voir content_matcher_create_regex)
+    SEARCH_QUERY_FUZZY          // Sous-séquence classée par pertinence (noms seulement)
+} SearchQueryType;
+
+// Tampon de résultats d'un worker: un seul thread (son propriétaire) y ajoute
+// des entrées, les autres lisent sans verrou les `published` premières
+typedef struct {
+    FileList* list;             // Tables de pointeurs réservées: jamais réallouées
+    atomic_int published;       // Entrées complètes (écrit en release, lu en acquire)
+} SearchResultBuffer;
+
+// Une exécution de recherche (génération): paramètres, progression et
+// résultats. Partagée par comptage de références entre l'AsyncSearch qui
+// l'a lancée et le thread qui l'exécute: une recherche abandonnée se termine
+// d'elle-même et libère ses résultats sans que personne ne l'attende.
 typedef struct {
-    pthread_t thread;
     pthread_mutex_t mutex;
+    atomic_int refcount;
+    unsigned long generation;   // Numéro attribué par async_search_start
     SearchStatus status;
     char path[MAX_PATH_LENGTH];
     char search_term[256];
+    SearchQueryType query_type;
     bool search_by_content;
     bool show_hidden;
-    FileList* results;
-    bool limit_reached;
-    // Statistiques de progression
+    FileList* results;          // Résultats complets, ou ceux de l'index pendant le parcours
+    SearchResultBuffer buffers[SEARCH_MAX_THREADS];  // Résultats du parcours en cours
+    int buffer_count;           // Tampons visibles des lecteurs (protégé par mutex)
+    atomic_bool cancel_requested;  // Lu sans verrou par les workers entre deux entrées
+    bool limit_reached;         // Résultats tronqués (budget mémoire atteint)
+    int thread_count;           // Nombre de workers (parcours par nom, lecteurs par contenu)
+    size_t memory_budget;       // Budget mémoire de la liste de résultats
+    FileIndex* index;           // Index persistant consulté avant le parcours, ou à sa place pour le contenu (optionnel)
+    ExcludeRules* exclusions;   // Règles d'exclusion (NULL: EXCLUDED_DIRS)
+    FileList* base;             // Résultats d'une recherche plus large à filtrer (sans parcours)
+    bool base_exact;            // base répond déjà exactement à la recherche
+    size_t content_max_size;    // Fichiers plus gros non lus (0: aucune limite)
+    atomic_int fuzzy_threshold; // Score qui n'entre plus dans les meilleurs (recherche approximative)
+    // Statistiques de progression (cumuls locaux des workers, versés par lots)
+    atomic_int files_scanned;
+    atomic_int dirs_scanned;
+    atomic_int files_matched;
+    atomic_llong bytes_read;    // Contenu lu (recherche par contenu)
+    atomic_int files_binary;    // Fichiers non lus: binaires
+    atomic_int files_oversized; // Fichiers non lus: plus gros que content_max_size
+    atomic_int files_pruned;    // Fichiers non lus: écartés par les trigrammes de l'index
+    struct timespec start_time; // CLOCK_MONOTONIC
+    double elapsed_time;
+} SearchRun;
+
+// Statistiques d'une recherche (copie instantanée)
+typedef struct {
     int files_scanned;
     int dirs_scanned;
     int files_matched;
-    time_t start_time;
-    double elapsed_time;
+    long long bytes_read;
+    int files_binary;
+    int files_oversized;
+    int files_pruned;
+    double elapsed_time;        // Secondes
+    double files_per_second;
+    double megabytes_per_second;
+} SearchStats;
+
+// Résultats complets d'une recherche passée, réutilisés quand une nouvelle
+// recherche en est un raffinement (son terme contient celui-ci)
+typedef struct {
+    char path[MAX_PATH_LENGTH];
+    char search_term[256];
+    SearchQueryType query_type;
+    bool search_by_content;
+    bool show_hidden;
+    FileList* results;          // Instantané trié et non tronqué (NULL: emplacement libre)
+    time_t completed_time;
+    unsigned long last_used;
+} SearchQuery;
+
+// Recherche asynchrone: ne fait qu'observer la génération courante.
+// Démarrer ou annuler abandonne l'ancienne sans jamais attendre son thread.
+// Un thread persistant (l'ordonnanceur) lance chaque génération dans un
+// thread détaché après un délai sans nouvelle demande: seule la dernière
+// compte, et une génération abandonnée mais bloquée ne retient pas la suivante.
+typedef struct {
+    pthread_mutex_t mutex;
+    SearchRun* run;             // Génération courante (NULL: aucune recherche)
+    unsigned long generation;   // Dernier numéro attribué
+    // Ordonnanceur
+    pthread_t scheduler;
+    pthread_cond_t wakeup;
+    SearchRun* pending;         // Prochaine génération à exécuter (référence de l'ordonnanceur)
+    struct timespec pending_deadline;  // Pas avant (CLOCK_MONOTONIC)
+    int debounce_ms;
+    bool shutdown;
+    // Réglages des prochaines recherches
+    SearchQueryType query_type;
+    int thread_count;
+    size_t memory_budget;
+    size_t content_max_size;
+    FileIndex* index;
+    ExcludeRules* exclusions;
+    // Recherches récentes (taper un caractère de plus filtre en mémoire)
+    SearchQuery queries[SEARCH_QUERY_CACHE_SIZE];
+    unsigned long query_clock;
 } AsyncSearch;
 
+// Position de lecture incrémentale des résultats d'une recherche en cours
+typedef struct {
+    unsigned long generation;   // Recherche lue (0: la prochaine lecture s'y rattache)
+    int results_read;           // Entrées déjà lues dans les résultats de l'index
+    int buffers_read[SEARCH_MAX_THREADS];  // Entrées déjà lues dans chaque tampon
+} SearchCursor;
+
 // Initialise une liste de fichiers
 FileList* file_list_create(void);
 
-// Libère la mémoire d'une liste de fichiers
+// Relâche une référence; la mémoire est libérée avec la dernière
 void file_list_destroy(FileList* list);
 
+// Prend une référence supplémentaire sur la liste (partage sans copie)
+FileList* file_list_retain(FileList* list);
+
+// Copie-sur-écriture: si *list est partagée, la remplace par une copie privée
+// (la référence sur l'original est relâchée). Retourne false si la copie échoue.
+bool file_list_make_writable(FileList** list);
+
+// Définit le budget mémoire de la liste (0: FILE_LIST_DEFAULT_BUDGET)
+void file_list_set_budget(FileList* list, size_t memory_budget);
+
+// Accès à une entrée par index (pointeur stable tant que la liste n'est pas vidée)
+FileEntry* file_list_get(const FileList* list, int index);
+
+// Crée une copie indépendante d'une liste (entrées et arène)
+FileList* file_list_copy(const FileList* list);
+
+// Remplace le contenu de dest par celui de src (réutilise les buffers de dest)
+bool file_list_assign(FileList* dest, const FileList* src);
+
+// Chemin complet d'une entrée de la liste
+const char* file_entry_path(const FileList* list, const FileEntry* entry);
+
+// Nom d'une entrée (suffixe de son chemin)
+const char* file_entry_name(const FileList* list, const FileEntry* entry);
+
 // Explore un répertoire de manière récursive
 bool explore_directory(const char* path, FileList* list, int depth, bool show_hidden);
 
 // Explore seulement le contenu direct d'un répertoire (non-récursif)
 bool explore_directory_shallow(const char* path, FileList* list, bool show_hidden);
 
-// Recherche récursive de fichiers par nom (retourne false si limite atteinte)
+// Recherche récursive de fichiers par nom dans le thread courant
+// (retourne false si la liste est tronquée)
 bool search_files_recursive(const char* path, const char* search_term, FileList* list, int depth, bool show_hidden);
 
 // Efface le contenu de la liste
@@ -98,6 +340,10 @@ void file_list_clear(FileList* list);
 // Trie la liste par nom
 void file_list_sort(FileList* list);
 
+// Trie la liste par pertinence décroissante (recherche approximative), puis
+// par longueur de nom
+void file_list_sort_by_score(FileList* list);
+
 // Crée un nouveau dossier dans le chemin parent
 bool create_directory(const char* parent_path, const char* name);
 
@@ -111,17 +357,80 @@ DirectoryCache* cache_create(void);
 // Libère le cache
 void cache_destroy(DirectoryCache* cache);
 
-// Récupère depuis le cache (NULL si non trouvé)
-FileList* cache_get(DirectoryCache* cache, const char* path, bool show_hidden);
+// Définit le budget mémoire du cache (0: CACHE_DEFAULT_BUDGET); évince au besoin
+void cache_set_budget(DirectoryCache* cache, size_t memory_budget);
 
-// Ajoute au cache
-void cache_put(DirectoryCache* cache, const char* path, FileList* files, bool show_hidden);
+// Lit les compteurs de succès, d'échecs et d'évictions
+void cache_get_stats(DirectoryCache* cache, CacheStats* stats);
+
+// Partage le listing en cache: *snapshot reçoit une référence (à relâcher avec
+// file_list_destroy) sur un instantané immuable; retourne sa version (0 si non trouvé)
+unsigned long cache_get(DirectoryCache* cache, const char* path, bool show_hidden, FileList** snapshot);
+
+// Ajoute au cache (le cache prend sa propre référence sur files, qui devient
+// immuable) et surveille le dossier; retourne la version du listing
+// (0 si le listing dépasse à lui seul le budget)
+unsigned long cache_put(DirectoryCache* cache, const char* path, FileList* files, bool show_hidden);
+
+// Version courante d'un listing en cache (0 si absent ou invalidé)
+unsigned long cache_get_version(DirectoryCache* cache, const char* path, bool show_hidden);
+
+// Retire du cache les listings d'un dossier (toutes variantes show_hidden)
+void cache_invalidate(DirectoryCache* cache, const char* path);
+
+// Appelé depuis le thread du watcher après chaque modification du cache
+void cache_set_change_callback(DirectoryCache* cache, void (*callback)(void* user_data), void* user_data);
 
 // === Recherche par contenu ===
-// Recherche dans le contenu des fichiers (grep-like)
+// Première occurrence de needle dans haystack, insensible à la casse (ASCII);
+// vectorisée (SSE2/AVX2/NEON) avec repli scalaire. NULL si absente.
+const char* memmem_icase(const char* haystack, size_t haystack_length, const char* needle, size_t needle_length);
+
+// Occurrence d'un des motifs d'une recherche par contenu
+typedef struct {
+    long offset;               // Octet de début (dans le texte ou le fichier)
+    int length;                // Longueur de l'occurrence
+    int line;                  // Ligne, à partir de 1 (0: inconnue)
+    int pattern;               // Indice du motif dans la requête
+} ContentMatch;
+
+// Motifs d'une requête "terme1|terme2|...", compilés une fois et cherchés en
+// une seule passe (insensible à la casse, ASCII). À plusieurs motifs:
+// automate d'Aho-Corasick, avec filtre Teddy (AVX2) s'ils sont peu nombreux.
+// Ou une expression régulière, dont les automates se construisent pendant
+// la recherche: un matcher par thread.
+typedef struct ContentMatcher ContentMatcher;
+
+// NULL si la requête ne contient aucun terme
+ContentMatcher* content_matcher_create(const char* query);
+
+// Expression régulière insensible à la casse, dont les occurrences restent
+// sur une ligne (^ et $: début et fin de ligne). Recherche en temps
+// linéaire, sans retour arrière: pas de références arrière ni de \b.
+// NULL si le motif est vide ou invalide; error (optionnel) reçoit alors
+// le message.
+ContentMatcher* content_matcher_create_regex(const char* pattern, char* error, size_t error_size);
+void content_matcher_destroy(ContentMatcher* matcher);
+int content_matcher_pattern_count(const ContentMatcher* matcher);
+
+// Occurrence la plus à gauche (la plus longue à position égale; pour une
+// expression régulière, la première à finir, étendue); NULL si aucune.
+// match_length et pattern sont optionnels.
+const char* content_matcher_find(ContentMatcher* matcher, const char* text, size_t length, size_t* match_length, int* pattern);
+
+// Occurrences disjointes de text, dans l'ordre, avec leur ligne (au plus
+// max); retourne leur nombre
+int content_matcher_find_all(ContentMatcher* matcher, const char* text, size_t length, ContentMatch* matches, int max);
+
+// Première occurrence dans un fichier régulier (binaires ignorés); match
+// est optionnel
+bool content_matcher_search_file(ContentMatcher* matcher, const char* file_path, ContentMatch* match);
+
+// Recherche dans le contenu des fichiers (grep-like); plusieurs termes
+// séparés par CONTENT_PATTERN_SEPARATOR: l'un d'eux suffit
 bool search_in_file_content(const char* file_path, const char* search_term);
 
-// Recherche récursive par contenu
+// Recherche récursive par contenu dans le thread courant
 bool search_files_by_content(const char* path, const char* search_term, FileList* list, int depth, bool show_hidden);
 
 // === Recherche asynchrone (threading) ===
@@ -131,6 +440,21 @@ AsyncSearch* async_search_create(void);
 // Démarre une recherche asynchrone
 void async_search_start(AsyncSearch* search, const char* path, const char* search_term, bool search_by_content, bool show_hidden);
 
+// Interprétation du terme des prochaines recherches. Une recherche
+// approximative ne garde que les SEARCH_FUZZY_MAX_RESULTS meilleurs noms,
+// déjà classés; par contenu, son terme est cherché comme du texte.
+void async_search_set_query_type(AsyncSearch* search, SearchQueryType query_type);
+
+// Définit le nombre de workers pour les prochaines recherches (<= 0: auto)
+void async_search_set_thread_count(AsyncSearch* search, int thread_count);
+
+// Définit le budget mémoire des résultats des prochaines recherches (0: défaut)
+void async_search_set_memory_budget(AsyncSearch* search, size_t memory_budget);
+
+// Délai sans nouvelle demande avant de lancer un parcours (< 0: SEARCH_DEBOUNCE_MS).
+// Les demandes rapprochées sont fusionnées: seule la dernière est exécutée.
+void async_search_set_debounce(AsyncSearch* search, int milliseconds);
+
 // Vérifie le statut de la recherche
 SearchStatus async_search_status(AsyncSearch* search);
 
@@ -140,13 +464,105 @@ FileList* async_search_get_results(AsyncSearch* search, bool* limit_reached);
 // Obtient les statistiques de progression (thread-safe)
 void async_search_get_progress(AsyncSearch* search, int* files_scanned, int* dirs_scanned, int* files_matched, double* elapsed_time);
 
+// Statistiques détaillées de la recherche courante: compteurs de
+// progression, octets lus, fichiers ignorés et débits (thread-safe)
+void async_search_get_stats(AsyncSearch* search, SearchStats* stats);
+
+// Taille au-delà de laquelle la recherche par contenu ignore un fichier
+// (0: aucune limite); s'applique aux prochaines recherches
+void async_search_set_content_max_size(AsyncSearch* search, size_t max_size);
+
 // Obtient une copie des résultats intermédiaires (pour affichage progressif)
 FileList* async_search_peek_results(AsyncSearch* search);
 
-// Annule une recherche en cours
+// Prépare un curseur pour async_search_read_results
+void async_search_cursor_init(SearchCursor* cursor);
+
+// Ajoute à results les résultats intermédiaires publiés depuis le curseur et
+// l'avance; retourne le nombre d'entrées ajoutées. Seules les nouvelles
+// entrées sont copiées. results ne doit contenir que ce que le curseur a lu:
+// si une autre recherche a démarré depuis, elle est vidée et la lecture
+// reprend au début. Les résultats finaux s'obtiennent par
+// async_search_get_results.
+int async_search_read_results(AsyncSearch* search, SearchCursor* cursor, FileList* results);
+
+// Index consulté par les prochaines recherches par nom, et par contenu s'il
+// contient les trigrammes (NULL: aucun); la recherche prend sa propre référence
+void async_search_set_index(AsyncSearch* search, FileIndex* index);
+
+// Règles d'exclusion des prochaines recherches (NULL: EXCLUDED_DIRS); la
+// recherche prend sa propre référence et les règles ne sont plus modifiables
+void async_search_set_exclusions(AsyncSearch* search, ExcludeRules* rules);
+
+// Annule la recherche en cours sans attendre son thread (qui s'arrête seul)
 void async_search_cancel(AsyncSearch* search);
 
+// Oublie les résultats gardés pour le raffinement (fichiers modifiés)
+void async_search_forget_results(AsyncSearch* search);
+
 // Libère les ressources
 void async_search_destroy(AsyncSearch* search);
 
+// === Règles d'exclusion ===
+// Crée des règles contenant les dossiers exclus par défaut
+ExcludeRules* exclude_rules_create(void);
+
+// Prend une référence supplémentaire sur les règles
+ExcludeRules* exclude_rules_retain(ExcludeRules* rules);
+
+// Relâche une référence; les règles sont libérées avec la dernière
+void exclude_rules_destroy(ExcludeRules* rules);
+
+// Ajoute une règle .gitignore: nom ou glob (*, ?, [...], **), "!motif"
+// réinclut, '/' final: dossiers seulement, '/' initial ou interne: chemin
+// relatif à la racine de la recherche. La dernière règle qui correspond
+// l'emporte. Retourne false si la règle est invalide ou déjà partagée.
+bool exclude_rules_add(ExcludeRules* rules, const char* pattern);
+
+// Ajoute les règles d'un fichier (une par ligne, '#' pour les commentaires)
+bool exclude_rules_add_file(ExcludeRules* rules, const char* file_path);
+
+// Applique aussi les .gitignore des dossiers parcourus (hérités par les
+// sous-dossiers) et ceux du dépôt englobant la racine de la recherche
+void exclude_rules_set_gitignore(ExcludeRules* rules, bool enabled);
+
+// Fichier de règles par défaut ($XDG_CONFIG_HOME/filex/exclude ou ~/.config/...)
+bool exclude_rules_default_path(char* buffer, size_t size);
+
+// === Index persistant ===
+// Chemin par défaut de l'index ($XDG_CACHE_HOME/filex/index.bin ou ~/.cache/...)
+bool file_index_default_path(char* buffer, size_t size);
+
+// Projette un index existant; NULL si absent, invalide ou d'une autre version
+FileIndex* file_index_open(const char* index_path);
+
+// Prend une référence supplémentaire sur l'index
+FileIndex* file_index_retain(FileIndex* index);
+
+// Relâche une référence; la projection est libérée avec la dernière
+void file_index_close(FileIndex* index);
+
+// Vrai si path est la racine de l'index ou un de ses sous-dossiers
+bool file_index_covers(const FileIndex* index, const char* path);
+
+// Recherche par nom dans l'index sous path, avec les règles du parcours
+// (profondeur, fichiers cachés, exclusions: EXCLUDED_DIRS si NULL).
+// Retourne false si results est tronquée.
+bool file_index_search(const FileIndex* index, const char* path, const char* search_term, bool show_hidden, ExcludeRules* exclusions, FileList* results);
+
+// Construit (ou remplace) l'index de root; bloquant. Avec index_content,
+// l'index contient aussi les trigrammes du contenu des fichiers: ceux dont
+// la taille et la date n'ont pas changé depuis l'index précédent (même
+// chemin, même racine) ne sont pas relus.
+bool file_index_build(const char* root, const char* index_path, int thread_count, bool index_content);
+
+// Lance la construction dans un thread
+FileIndexBuilder* file_index_build_start(const char* root, const char* index_path, int thread_count, bool index_content);
+
+// Vrai quand la construction est terminée; *success indique si l'index a été écrit
+bool file_index_build_finished(FileIndexBuilder* builder, bool* success);
+
+// Annule la construction si elle est en cours et libère le builder
+void file_index_build_destroy(FileIndexBuilder* builder);
+
 #endif // FILE_EXPLORER_H
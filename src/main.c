@@ -17,61 +17,194 @@ static void get_parent_directory(const char* path, char* parent) {
     parent[MAX_PATH_LENGTH - 1] = '\0';
 }
 
-// Fonction pour charger le contenu d'un répertoire
-static bool load_directory(const char* path, FileList* files, bool show_hidden, DirectoryCache* cache) {
+// Fonction pour charger le contenu d'un répertoire: *files est remplacée par
+// l'instantané partagé avec le cache (sans copie); version reçoit sa version
+// (0 s'il n'a pas pu être mis en cache)
+static bool load_directory(const char* path, FileList** files, bool show_hidden, DirectoryCache* cache, unsigned long* version) {
     // Vérifier le cache d'abord
-    FileList* cached = cache_get(cache, path, show_hidden);
-    if (cached) {
+    FileList* snapshot = NULL;
+    unsigned long cached_version = cache_get(cache, path, show_hidden, &snapshot);
+    if (cached_version) {
         printf("Cache hit pour %s\n", path);
-        file_list_clear(files);
-        // Copier les entrées du cache
-        for (int i = 0; i < cached->count && i < MAX_FILES; i++) {
-            if (files->count >= files->capacity) {
-                int new_capacity = files->capacity * 2;
-                if (new_capacity > MAX_FILES) new_capacity = MAX_FILES;
-                FileEntry* new_entries = (FileEntry*)realloc(files->entries, sizeof(FileEntry) * new_capacity);
-                if (!new_entries) break;
-                files->entries = new_entries;
-                files->capacity = new_capacity;
-            }
-            files->entries[files->count++] = cached->entries[i];
-        }
+        file_list_destroy(*files);
+        *files = snapshot;
+        *version = cached_version;
         return true;
     }
     
-    // Pas dans le cache, charger depuis le disque
+    // Pas dans le cache, charger depuis le disque dans une nouvelle liste
     printf("Cache miss pour %s\n", path);
-    file_list_clear(files);
+    FileList* loaded = file_list_create();
+    if (!loaded) {
+        return false;
+    }
+    
+    file_list_destroy(*files);
+    *files = loaded;
+    *version = 0;
     
-    if (!explore_directory_shallow(path, files, show_hidden)) {
+    if (!explore_directory_shallow(path, loaded, show_hidden)) {
         return false;
     }
     
-    file_list_sort(files);
-    
-    // Ajouter au cache (créer une copie)
-    FileList* to_cache = file_list_create();
-    if (to_cache) {
-        for (int i = 0; i < files->count; i++) {
-            if (to_cache->count >= to_cache->capacity) {
-                int new_capacity = to_cache->capacity * 2;
-                if (new_capacity > MAX_FILES) new_capacity = MAX_FILES;
-                FileEntry* new_entries = (FileEntry*)realloc(to_cache->entries, sizeof(FileEntry) * new_capacity);
-                if (!new_entries) break;
-                to_cache->entries = new_entries;
-                to_cache->capacity = new_capacity;
-            }
-            to_cache->entries[to_cache->count++] = files->entries[i];
+    file_list_sort(loaded);
+    
+    // Ajouter au cache (partagée avec la vue, plus modifiée ensuite)
+    *version = cache_put(cache, path, loaded, show_hidden);
+    
+    return true;
+}
+
+// Vue des résultats d'une recherche: les résultats intermédiaires sont
+// ajoutés par lots à la liste affichée, sans recopier ceux déjà reçus
+typedef struct {
+    SearchCursor cursor;
+    bool active;        // La liste affichée contient les résultats (sinon le listing)
+    bool ranked;        // Recherche approximative: meilleurs résultats en tête
+} SearchView;
+
+// Interprétation du terme selon les options de l'interface
+static SearchQueryType query_type_of(bool regex, bool fuzzy) {
+    if (regex) return SEARCH_QUERY_REGEX;
+    if (fuzzy) return SEARCH_QUERY_FUZZY;
+    return SEARCH_QUERY_TEXT;
+}
+
+// Lance une recherche; la vue passe à ses résultats dès le premier lot
+static void start_search(SearchView* view, AsyncSearch* search, const char* path, const char* text, bool by_content, SearchQueryType query_type, bool show_hidden) {
+    async_search_set_query_type(search, query_type);
+    async_search_start(search, path, text, by_content, show_hidden);
+    async_search_cursor_init(&view->cursor);
+    view->active = false;
+    view->ranked = query_type == SEARCH_QUERY_FUZZY && !by_content;
+}
+
+// Ajoute à *files les résultats publiés depuis la dernière image
+static void update_search_view(SearchView* view, AsyncSearch* search, FileList** files) {
+    if (view->active) {
+        // Les workers ne publient que des candidats aux meilleures places:
+        // la liste reste courte et peut être reclassée à chaque lot
+        if (async_search_read_results(search, &view->cursor, *files) > 0 && view->ranked) {
+            file_list_sort_by_score(*files);
         }
-        cache_put(cache, path, to_cache, show_hidden);
+        return;
     }
     
-    return true;
+    // Premier lot: remplacer le listing du dossier
+    FileList* first = file_list_create();
+    if (!first) return;
+    
+    if (async_search_read_results(search, &view->cursor, first) > 0) {
+        if (view->ranked) {
+            file_list_sort_by_score(first);
+        }
+        file_list_destroy(*files);
+        *files = first;
+        view->active = true;
+    } else {
+        file_list_destroy(first);
+    }
+}
+
+// Appelé par le watcher du cache: réveiller la boucle principale en attente
+static void on_cache_changed(void* user_data) {
+    (void)user_data;
+    ui_wakeup();
+}
+
+// Chemin de l'index persistant: FILEX_INDEX_PATH ou emplacement par défaut
+static bool get_index_path(char* buffer, size_t size) {
+    const char* index_env = getenv("FILEX_INDEX_PATH");
+    if (index_env && index_env[0] != '\0') {
+        if (strlen(index_env) >= size) return false;
+        strcpy(buffer, index_env);
+        return true;
+    }
+    return file_index_default_path(buffer, size);
+}
+
+// Trigrammes du contenu dans l'index (recherche par contenu) si
+// FILEX_INDEX_CONTENT est non nul
+static bool get_index_content(void) {
+    const char* content_env = getenv("FILEX_INDEX_CONTENT");
+    return content_env && atoi(content_env) != 0;
+}
+
+// Règles d'exclusion des recherches: fichier FILEX_SEARCH_EXCLUDE_FILE (ou
+// emplacement par défaut), motifs de FILEX_SEARCH_EXCLUDE séparés par ':',
+// et .gitignore des dossiers parcourus si FILEX_SEARCH_GITIGNORE est non nul
+static void configure_exclusions(AsyncSearch* search) {
+    ExcludeRules* rules = exclude_rules_create();
+    if (!rules) return;
+    
+    char rules_path[MAX_PATH_LENGTH];
+    const char* file_env = getenv("FILEX_SEARCH_EXCLUDE_FILE");
+    if (file_env && file_env[0] != '\0') {
+        if (!exclude_rules_add_file(rules, file_env)) {
+            fprintf(stderr, "Avertissement: règles d'exclusion illisibles: %s\n", file_env);
+        }
+    } else if (exclude_rules_default_path(rules_path, sizeof(rules_path))) {
+        exclude_rules_add_file(rules, rules_path);  // Absent: règles par défaut seules
+    }
+    
+    const char* patterns_env = getenv("FILEX_SEARCH_EXCLUDE");
+    for (const char* p = patterns_env; p && *p != '\0'; ) {
+        size_t length = strcspn(p, ":");
+        char pattern[MAX_PATH_LENGTH];
+        if (length > 0 && length < sizeof(pattern)) {
+            memcpy(pattern, p, length);
+            pattern[length] = '\0';
+            exclude_rules_add(rules, pattern);
+        }
+        p += length;
+        if (*p == ':') p++;
+    }
+    
+    const char* gitignore_env = getenv("FILEX_SEARCH_GITIGNORE");
+    exclude_rules_set_gitignore(rules, gitignore_env && atoi(gitignore_env) != 0);
+    
+    async_search_set_exclusions(search, rules);
+    exclude_rules_destroy(rules);
+}
+
+// filex --build-index [racine]: construit ou rafraîchit l'index puis quitte
+static int build_index_command(const char* root) {
+    if (!root) root = getenv("FILEX_INDEX_ROOT");
+    if (!root) root = getenv("HOME");
+    
+    char index_path[MAX_PATH_LENGTH];
+    if (!root || !get_index_path(index_path, sizeof(index_path))) {
+        fprintf(stderr, "Erreur: racine ou chemin de l'index introuvable\n");
+        return 1;
+    }
+    
+    const char* threads_env = getenv("FILEX_SEARCH_THREADS");
+    printf("Indexation de %s dans %s...\n", root, index_path);
+    if (!file_index_build(root, index_path, threads_env ? atoi(threads_env) : 0, get_index_content())) {
+        fprintf(stderr, "Erreur lors de la construction de l'index\n");
+        return 1;
+    }
+    
+    FileIndex* index = file_index_open(index_path);
+    if (index) {
+        printf("Index construit: %llu entrees%s\n", (unsigned long long)index->entry_count,
+               index->truncated ? " (partiel: budget atteint)" : "");
+        if (index->content) {
+            printf("Contenu indexe: %llu trigrammes\n", (unsigned long long)index->trigram_count);
+        }
+        file_index_close(index);
+    }
+    return 0;
 }
 
 int main(int argc, char** argv) {
     char current_path[MAX_PATH_LENGTH];
     
+    // Construction de l'index sans interface (ex: tâche planifiée)
+    if (argc > 1 && strcmp(argv[1], "--build-index") == 0) {
+        return build_index_command(argc > 2 ? argv[2] : NULL);
+    }
+    
     // Déterminer le chemin de départ
     if (argc > 1) {
         // Utiliser le chemin fourni en argument
@@ -94,6 +227,12 @@ int main(int argc, char** argv) {
         return 1;
     }
     
+    // Budget mémoire du cache de dossiers, en Mo
+    const char* cache_budget_env = getenv("FILEX_CACHE_BUDGET_MB");
+    if (cache_budget_env) {
+        cache_set_budget(cache, (size_t)atol(cache_budget_env) * 1024 * 1024);
+    }
+    
     // Créer la recherche asynchrone
     AsyncSearch* async_search = async_search_create();
     if (!async_search) {
@@ -102,6 +241,32 @@ int main(int argc, char** argv) {
         return 1;
     }
     
+    // Nombre de workers pour la recherche (par défaut: un par cœur)
+    const char* threads_env = getenv("FILEX_SEARCH_THREADS");
+    if (threads_env) {
+        async_search_set_thread_count(async_search, atoi(threads_env));
+    }
+    
+    // Délai de saisie avant de lancer un parcours, en millisecondes
+    const char* debounce_env = getenv("FILEX_SEARCH_DEBOUNCE_MS");
+    if (debounce_env) {
+        async_search_set_debounce(async_search, atoi(debounce_env));
+    }
+    
+    // Budget mémoire des résultats de recherche, en Mo
+    const char* budget_env = getenv("FILEX_MEMORY_BUDGET_MB");
+    if (budget_env) {
+        async_search_set_memory_budget(async_search, (size_t)atol(budget_env) * 1024 * 1024);
+    }
+    
+    // Taille maximale d'un fichier lu par la recherche par contenu, en Mo
+    const char* content_max_env = getenv("FILEX_CONTENT_MAX_SIZE_MB");
+    if (content_max_env) {
+        async_search_set_content_max_size(async_search, (size_t)atol(content_max_env) * 1024 * 1024);
+    }
+    
+    configure_exclusions(async_search);
+    
     // Créer la liste de fichiers
     FileList* files = file_list_create();
     if (!files) {
@@ -112,7 +277,8 @@ int main(int argc, char** argv) {
     }
     
     // Charger le contenu initial
-    if (!load_directory(current_path, files, false, cache)) {
+    unsigned long view_version = 0;
+    if (!load_directory(current_path, &files, false, cache, &view_version)) {
         fprintf(stderr, "Erreur lors du chargement du répertoire\n");
         file_list_destroy(files);
         async_search_destroy(async_search);
@@ -132,11 +298,40 @@ int main(int argc, char** argv) {
         return 1;
     }
     
+    // Rafraîchir la vue dès que le watcher modifie le cache
+    cache_set_change_callback(cache, on_cache_changed, NULL);
+    
+    // Index persistant (optionnel) consulté avant le parcours des recherches par nom
+    char index_path[MAX_PATH_LENGTH];
+    FileIndexBuilder* index_builder = NULL;
+    if (get_index_path(index_path, sizeof(index_path))) {
+        FileIndex* index = file_index_open(index_path);
+        async_search_set_index(async_search, index);
+        
+        // Reconstruction en arrière-plan si demandée et l'index absent, ancien
+        // ou sans le contenu demandé
+        const char* index_root = getenv("FILEX_INDEX_ROOT");
+        bool index_content = get_index_content();
+        if (index_root && (!index || difftime(time(NULL), index->build_time) > FILE_INDEX_MAX_AGE ||
+                           (index_content && !index->content))) {
+            index_builder = file_index_build_start(index_root, index_path, 0, index_content);
+        }
+        file_index_close(index);
+    }
+    
+    // Rendu continu (ancien comportement) si demandé
+    const char* continuous_env = getenv("FILEX_CONTINUOUS_RENDER");
+    if (continuous_env && atoi(continuous_env) != 0) {
+        ui_set_on_demand_rendering(ui, false);
+    }
+    
     char previous_search[256] = "";
     bool prev_show_hidden = false;
     bool prev_search_by_content = false;
+    SearchQueryType prev_query_type = SEARCH_QUERY_TEXT;
     char last_message[256] = "";
     bool search_in_progress = false;
+    SearchView search_view = {0};
     
     // Boucle principale
     while (!ui_should_close()) {
@@ -144,6 +339,7 @@ int main(int argc, char** argv) {
 
         bool current_show_hidden = ui_get_show_hidden(ui);
         bool current_search_by_content = ui_get_search_by_content(ui);
+        SearchQueryType current_query_type = query_type_of(ui_get_search_regex(ui), ui_get_search_fuzzy(ui));
 
         // Mettre à jour les statistiques de recherche si en cours
         if (search_in_progress) {
@@ -151,18 +347,12 @@ int main(int argc, char** argv) {
             
             if (status == SEARCH_RUNNING) {
                 // Obtenir les statistiques de progression
-                int files_scanned, dirs_scanned, files_matched;
-                double elapsed_time;
-                async_search_get_progress(async_search, &files_scanned, &dirs_scanned, &files_matched, &elapsed_time);
-                ui_set_search_stats(ui, files_scanned, dirs_scanned, files_matched, elapsed_time);
+                SearchStats stats;
+                async_search_get_stats(async_search, &stats);
+                ui_set_search_stats(ui, &stats);
                 
-                // Récupérer et afficher les résultats intermédiaires
-                FileList* peek = async_search_peek_results(async_search);
-                if (peek && peek->count > files->count) {
-                    // Copier les nouveaux résultats
-                    file_list_destroy(files);
-                    files = peek;
-                }
+                // Afficher les nouveaux résultats intermédiaires
+                update_search_view(&search_view, async_search, &files);
             } else if (status == SEARCH_COMPLETED) {
                 // Recherche terminée
                 bool limit_reached;
@@ -173,13 +363,17 @@ int main(int argc, char** argv) {
                     ui_set_search_limit_reached(ui, limit_reached);
                     
                     // Obtenir les statistiques finales
-                    int files_scanned, dirs_scanned, files_matched;
-                    double elapsed_time;
-                    async_search_get_progress(async_search, &files_scanned, &dirs_scanned, &files_matched, &elapsed_time);
-                    ui_set_search_stats(ui, files_scanned, dirs_scanned, files_matched, elapsed_time);
+                    SearchStats stats;
+                    async_search_get_stats(async_search, &stats);
+                    ui_set_search_stats(ui, &stats);
                     
-                    printf("Recherche terminee: %d resultats en %.1fs\n", files->count, elapsed_time);
-                    printf("Fichiers scannes: %d, Dossiers: %d\n", files_scanned, dirs_scanned);
+                    printf("Recherche terminee: %d resultats en %.1fs\n", files->count, stats.elapsed_time);
+                    printf("Fichiers scannes: %d, Dossiers: %d (%.0f fichiers/s)\n", stats.files_scanned, stats.dirs_scanned, stats.files_per_second);
+                    if (stats.bytes_read > 0 || stats.files_binary > 0 || stats.files_oversized > 0 || stats.files_pruned > 0) {
+                        printf("Contenu lu: %.1f Mo (%.1f Mo/s), ignores: %d binaires, %d trop gros, %d par l'index\n",
+                               (double)stats.bytes_read / (1024.0 * 1024.0), stats.megabytes_per_second,
+                               stats.files_binary, stats.files_oversized, stats.files_pruned);
+                    }
                     if (limit_reached) {
                         printf("Limite de resultats atteinte\n");
                     }
@@ -200,13 +394,19 @@ int main(int argc, char** argv) {
             }
             if (ok) {
                 snprintf(last_message, sizeof(last_message), "Creé: %s", name);
+                // Sans surveillance inotify, le listing en cache est périmé
+                if (!cache->watching) {
+                    cache_invalidate(cache, current_path);
+                }
+                // Les résultats gardés pour le raffinement aussi
+                async_search_forget_results(async_search);
                 // Recharger la vue courante
                 if (ui_is_searching(ui) && ui_get_search_text(ui)[0] != '\0') {
                     // Relancer la recherche asynchrone
-                    async_search_start(async_search, current_path, ui_get_search_text(ui), current_search_by_content, current_show_hidden);
+                    start_search(&search_view, async_search, current_path, ui_get_search_text(ui), current_search_by_content, current_query_type, current_show_hidden);
                     search_in_progress = true;
                 } else {
-                    load_directory(current_path, files, current_show_hidden, cache);
+                    load_directory(current_path, &files, current_show_hidden, cache, &view_version);
                 }
             } else {
                 snprintf(last_message, sizeof(last_message), "Echec creation: %s", name);
@@ -217,7 +417,8 @@ int main(int argc, char** argv) {
         // Gérer la recherche récursive
         const char* search_text = ui_get_search_text(ui);
         bool search_params_changed = (strcmp(search_text, previous_search) != 0) || 
-                                     (current_search_by_content != prev_search_by_content);
+                                     (current_search_by_content != prev_search_by_content) ||
+                                     (current_query_type != prev_query_type);
         
         if (search_text[0] != '\0' && search_params_changed) {
             // Nouvelle recherche - annuler l'ancienne si en cours
@@ -227,17 +428,20 @@ int main(int argc, char** argv) {
             }
             
             // Démarrer une nouvelle recherche asynchrone
-            printf("Recherche %s de '%s' dans %s...\n", 
+            printf("Recherche %s%s de '%s' dans %s...\n", 
                    current_search_by_content ? "par contenu" : "par nom",
+                   current_query_type == SEARCH_QUERY_REGEX ? " (expression reguliere)" :
+                   current_query_type == SEARCH_QUERY_FUZZY ? " (approximative)" : "",
                    search_text, current_path);
             
-            async_search_start(async_search, current_path, search_text, current_search_by_content, current_show_hidden);
+            start_search(&search_view, async_search, current_path, search_text, current_search_by_content, current_query_type, current_show_hidden);
             search_in_progress = true;
             ui_set_searching(ui, true);
             
             strncpy(previous_search, search_text, sizeof(previous_search) - 1);
             previous_search[sizeof(previous_search) - 1] = '\0';
             prev_search_by_content = current_search_by_content;
+            prev_query_type = current_query_type;
         } else if (search_text[0] == '\0' && previous_search[0] != '\0') {
             // Recherche annulée
             if (search_in_progress) {
@@ -245,7 +449,7 @@ int main(int argc, char** argv) {
                 search_in_progress = false;
             }
             printf("Recherche annulee\n");
-            load_directory(current_path, files, current_show_hidden, cache);
+            load_directory(current_path, &files, current_show_hidden, cache, &view_version);
             ui_set_searching(ui, false);
             ui_set_search_limit_reached(ui, false);
             previous_search[0] = '\0';
@@ -255,11 +459,11 @@ int main(int argc, char** argv) {
         if (current_show_hidden != prev_show_hidden) {
             if (search_text[0] != '\0' && !search_in_progress) {
                 // Relancer la recherche avec le nouveau paramètre
-                async_search_start(async_search, current_path, search_text, current_search_by_content, current_show_hidden);
+                start_search(&search_view, async_search, current_path, search_text, current_search_by_content, current_query_type, current_show_hidden);
                 search_in_progress = true;
                 ui_set_searching(ui, true);
             } else if (search_text[0] == '\0') {
-                load_directory(current_path, files, current_show_hidden, cache);
+                load_directory(current_path, &files, current_show_hidden, cache, &view_version);
                 ui_set_searching(ui, false);
                 ui_set_search_limit_reached(ui, false);
             }
@@ -282,7 +486,7 @@ int main(int argc, char** argv) {
             free(clicked_path);
             
             // Recharger le contenu et annuler la recherche
-            if (!load_directory(current_path, files, current_show_hidden, cache)) {
+            if (!load_directory(current_path, &files, current_show_hidden, cache, &view_version)) {
                 fprintf(stderr, "Erreur lors du chargement du répertoire\n");
             }
             ui_set_searching(ui, false);
@@ -309,7 +513,7 @@ int main(int argc, char** argv) {
                 current_path[sizeof(current_path) - 1] = '\0';
                 
                 // Recharger le contenu et annuler la recherche
-                if (!load_directory(current_path, files, current_show_hidden, cache)) {
+                if (!load_directory(current_path, &files, current_show_hidden, cache, &view_version)) {
                     fprintf(stderr, "Erreur lors du chargement du répertoire\n");
                 }
                 ui_set_searching(ui, false);
@@ -317,9 +521,40 @@ int main(int argc, char** argv) {
                 previous_search[0] = '\0';
             }
         }
+        
+        // Listing courant corrigé par le watcher: reprendre l'instantané du cache
+        if (!search_in_progress && ui_get_search_text(ui)[0] == '\0' &&
+            cache_get_version(cache, current_path, current_show_hidden) != view_version) {
+            load_directory(current_path, &files, current_show_hidden, cache, &view_version);
+            ui_request_redraw(ui);
+        }
+        
+        // Index reconstruit en arrière-plan: les prochaines recherches l'utilisent
+        bool index_built = false;
+        if (index_builder && file_index_build_finished(index_builder, &index_built)) {
+            file_index_build_destroy(index_builder);
+            index_builder = NULL;
+            if (index_built) {
+                FileIndex* index = file_index_open(index_path);
+                async_search_set_index(async_search, index);
+                file_index_close(index);
+                printf("Index de recherche mis a jour\n");
+            }
+        }
+        
+        // N'animer que pendant une recherche; sinon attendre les événements
+        ui_set_search_running(ui, search_in_progress);
     }
     
+    // Statistiques du cache de la session
+    CacheStats cache_stats;
+    cache_get_stats(cache, &cache_stats);
+    printf("Cache: %lu hits, %lu miss, %lu evictions, %d dossiers (%zu Ko / %zu Ko)\n",
+           cache_stats.hits, cache_stats.misses, cache_stats.evictions, cache_stats.count,
+           cache_stats.memory_used / 1024, cache_stats.memory_budget / 1024);
+    
     // Nettoyage
+    file_index_build_destroy(index_builder);
     async_search_destroy(async_search);
     cache_destroy(cache);
     ui_destroy(ui);
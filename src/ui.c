@@ -9,6 +9,7 @@
 #define LINE_HEIGHT 25
 #define PADDING 10
 #define INDENT_SIZE 20
+#define VIEWER_MAX_MATCHES 4096   // Occurrences mises en évidence dans la visionneuse
 
 static ThemeColors get_theme_colors(Theme theme) {
     ThemeColors colors;
@@ -79,18 +80,24 @@ UIState* ui_init(int width, int height, const char* title) {
     state->search_active = false;
     state->is_searching = false;
     state->search_limit_reached = false;
+    state->search_running = false;
     state->selected_file_path = NULL;
     state->file_content = NULL;
     state->is_binary_file = false;
     state->file_size = 0;
     state->file_scroll_offset = 0;
+    state->file_matches = NULL;
+    state->file_match_count = 0;
+    state->file_match_query[0] = '\0';
+    state->file_match_regex = false;
     state->initialized = false;
     state->show_hidden = false;
     state->search_by_content = false;
-    state->search_files_scanned = 0;
-    state->search_dirs_scanned = 0;
-    state->search_files_matched = 0;
-    state->search_elapsed_time = 0.0;
+    state->search_regex = false;
+    state->search_fuzzy = false;
+    state->regex_error[0] = '\0';
+    state->regex_error_query[0] = '\0';
+    memset(&state->search_stats, 0, sizeof(state->search_stats));
     state->current_theme = THEME_LIGHT;
     state->colors = get_theme_colors(THEME_LIGHT);
     state->menu_active = false;
@@ -100,6 +107,10 @@ UIState* ui_init(int width, int height, const char* title) {
     state->create_confirmed = false;
     state->create_type = CREATE_NONE;
     state->create_name[0] = '\0';
+    state->on_demand_rendering = true;
+    state->animating = false;
+    state->redraw_requested = false;
+    state->woke_from_wait = false;
     
     InitWindow(width, height, title);
     SetWindowState(FLAG_WINDOW_RESIZABLE);
@@ -122,6 +133,7 @@ void ui_destroy(UIState* state) {
         if (state->file_content) {
             free(state->file_content);
         }
+        free(state->file_matches);
         CloseWindow();
         free(state);
     }
@@ -183,12 +195,95 @@ static bool is_binary_content(const char* content, long size) {
     return false;
 }
 
-static bool load_file_content(UIState* state, const char* file_path) {
+// Oublie les occurrences calculées pour le contenu affiché
+static void clear_file_matches(UIState* state) {
+    free(state->file_matches);
+    state->file_matches = NULL;
+    state->file_match_count = 0;
+    state->file_match_query[0] = '\0';
+}
+
+// Occurrences de la recherche par contenu dans le fichier affiché, avec le
+// même moteur que la recherche: la visionneuse met en évidence exactement ce
+// qui a été trouvé. Recalculées seulement quand la requête change.
+static void update_file_matches(UIState* state) {
+    bool wanted = state->search_by_content && state->search_text[0] != '\0' && state->file_content;
+    if (!wanted) {
+        if (state->file_match_query[0] != '\0') {
+            clear_file_matches(state);
+        }
+        return;
+    }
+    if (strcmp(state->file_match_query, state->search_text) == 0 && state->file_match_regex == state->search_regex) {
+        return;
+    }
+    
+    clear_file_matches(state);
+    strcpy(state->file_match_query, state->search_text);
+    state->file_match_regex = state->search_regex;
+    
+    ContentMatcher* matcher = state->search_regex
+        ? content_matcher_create_regex(state->search_text, NULL, 0)
+        : content_matcher_create(state->search_text);
+    if (!matcher) return;
+    state->file_matches = (ContentMatch*)malloc(sizeof(ContentMatch) * VIEWER_MAX_MATCHES);
+    if (state->file_matches) {
+        state->file_match_count = content_matcher_find_all(matcher, state->file_content, strlen(state->file_content),
+                                                           state->file_matches, VIEWER_MAX_MATCHES);
+    }
+    content_matcher_destroy(matcher);
+}
+
+// Valide l'expression saisie pour signaler une erreur avant même que la
+// recherche ne démarre. Recompilée seulement quand le texte change.
+static void update_regex_error(UIState* state) {
+    if (!state->search_regex || state->search_text[0] == '\0') {
+        state->regex_error[0] = '\0';
+        state->regex_error_query[0] = '\0';
+        return;
+    }
+    if (strcmp(state->regex_error_query, state->search_text) == 0) {
+        return;
+    }
+    
+    strcpy(state->regex_error_query, state->search_text);
+    state->regex_error[0] = '\0';
+    ContentMatcher* matcher = content_matcher_create_regex(state->search_text, state->regex_error, sizeof(state->regex_error));
+    if (matcher) {
+        state->regex_error[0] = '\0';
+        content_matcher_destroy(matcher);
+    } else if (state->regex_error[0] == '\0') {
+        snprintf(state->regex_error, sizeof(state->regex_error), "expression invalide");
+    }
+}
+
+// Dessine length octets de text en x; retourne la largeur occupée
+static int draw_text_segment(const char* text, int length, int x, int y, Color color, bool highlighted, Color highlight) {
+    char segment[512];
+    if (length > (int)sizeof(segment) - 1) length = (int)sizeof(segment) - 1;
+    memcpy(segment, text, length);
+    segment[length] = '\0';
+    
+    int width = MeasureText(segment, 14);
+    if (highlighted) {
+        Rectangle highlight_box = { (float)x, (float)(y - 1), (float)width + 4, 14 + 2 };
+        DrawRectangleRec(highlight_box, highlight);
+        DrawText(segment, x + 2, y, 14, color);
+        return width + 4;
+    }
+    DrawText(segment, x, y, 14, color);
+    return width;
+}
+
+// match_line: ligne de la première occurrence d'une recherche par contenu
+// (0: aucune), amenée en haut de la vue
+static bool load_file_content(UIState* state, const char* file_path, int match_line) {
     // Libérer l'ancien contenu
     if (state->file_content) {
         free(state->file_content);
         state->file_content = NULL;
     }
+    clear_file_matches(state);
     if (state->selected_file_path) {
         free(state->selected_file_path);
     }
@@ -229,10 +324,34 @@ static bool load_file_content(UIState* state, const char* file_path) {
         strcpy(state->selected_file_path, file_path);
     }
     
-    state->file_scroll_offset = 0;
+    // Quelques lignes de contexte au-dessus de l'occurrence (16 px par ligne)
+    state->file_scroll_offset = match_line > 4 ? (match_line - 4) * 16 : 0;
     return true;
 }
 
+// Curseur clignotant seulement quand on anime déjà; au repos il reste affiché
+// pour ne pas réveiller la boucle deux fois par seconde
+static bool caret_visible(UIState* state) {
+    return !state->animating || ((int)(GetTime() * 2) % 2 == 0);
+}
+
+// Vue virtualisée: calcule l'intervalle [first, end) des lignes visibles entre
+// viewport_top et viewport_bottom à partir du défilement, sans parcourir la liste.
+// Une ligne partiellement masquée au-dessus de l'en-tête reste dessinée.
+static void list_view_visible_range(int count, int scroll_offset, int viewport_top, int viewport_bottom, int* first, int* end) {
+    // Ligne i dessinée en y = viewport_top - scroll_offset + i * LINE_HEIGHT
+    int start = (scroll_offset + LINE_HEIGHT - 1) / LINE_HEIGHT - 1;
+    if (start < 0) start = 0;
+    
+    int visible_height = viewport_bottom - viewport_top + scroll_offset;
+    int stop = visible_height > 0 ? (visible_height + LINE_HEIGHT - 1) / LINE_HEIGHT : 0;
+    if (stop > count) stop = count;
+    if (start > stop) start = stop;
+    
+    *first = start;
+    *end = stop;
+}
+
 static bool matches_search(const char* filename, const char* search) {
     if (search[0] == '\0') return true;
     
@@ -269,6 +388,15 @@ void ui_render(UIState* state, FileList* files, const char* current_path) {
     }
     state->go_back = false;
     
+    // Rendu à la demande: on n'anime (image suivante sans attente) que pendant
+    // une recherche ou sur demande. L'image qui suit un réveil est aussi rendue
+    // sans attente pour refléter les actions traitées par la boucle principale.
+    bool wait = state->on_demand_rendering && !state->search_running &&
+                !state->redraw_requested && !state->woke_from_wait;
+    state->redraw_requested = false;
+    state->woke_from_wait = wait;
+    state->animating = !wait;
+    
     // Gestion de l'input pour la création (prioritaire)
     if (state->create_active) {
         int key = GetCharPressed();
@@ -399,15 +527,14 @@ void ui_render(UIState* state, FileList* files, const char* current_path) {
     // Statistiques
     DrawRectangle(0, 75, state->window_width, 25, state->colors.bg_secondary);
     char stats[256];
-    int dir_count = 0, file_count = 0;
-    for (int i = 0; i < files->count; i++) {
-        if (files->entries[i].type == FILE_TYPE_DIRECTORY) {
-            dir_count++;
-        } else {
-            file_count++;
-        }
+    // Compteurs tenus à jour par la liste: pas de parcours des entrées
+    int dir_count = files->dir_count;
+    int file_count = files->count - files->dir_count;
+    if (files->truncated) {
+        snprintf(stats, sizeof(stats), "%d dossiers, %d fichiers (liste tronquee: budget memoire atteint)", dir_count, file_count);
+    } else {
+        snprintf(stats, sizeof(stats), "%d dossiers, %d fichiers", dir_count, file_count);
     }
-    snprintf(stats, sizeof(stats), "%d dossiers, %d fichiers", dir_count, file_count);
     DrawText(stats, PADDING, 80, 16, state->colors.text_primary);
 
     // Toggle 'Afficher fichiers cachés'
@@ -448,13 +575,13 @@ void ui_render(UIState* state, FileList* files, const char* current_path) {
         DrawText(state->search_text, PADDING + 35, search_y + 10, 16, state->colors.text_primary);
         
         // Curseur clignotant
-        if (state->search_active && ((int)(GetTime() * 2) % 2 == 0)) {
+        if (state->search_active && caret_visible(state)) {
             int text_width = MeasureText(state->search_text, 16);
             DrawText("|", PADDING + 35 + text_width, search_y + 10, 16, state->colors.text_primary);
         }
     } else if (state->search_active) {
         // Curseur seul
-        if ((int)(GetTime() * 2) % 2 == 0) {
+        if (caret_visible(state)) {
             DrawText("|", PADDING + 35, search_y + 10, 16, state->colors.text_primary);
         }
     } else {
@@ -462,8 +589,12 @@ void ui_render(UIState* state, FileList* files, const char* current_path) {
         DrawText("Rechercher... (Ctrl+F)", PADDING + 35, search_y + 10, 16, state->colors.text_disabled);
     }
     
-    // Compteur de résultats
-    if (state->search_text[0] != '\0') {
+    // Compteur de résultats (ou erreur de l'expression régulière)
+    update_regex_error(state);
+    if (state->regex_error[0] != '\0') {
+        int error_width = MeasureText(state->regex_error, 14);
+        DrawText(state->regex_error, state->window_width - error_width - PADDING - 10, search_y + 12, 14, RED);
+    } else if (state->search_text[0] != '\0') {
         char count_text[128];
         if (state->search_limit_reached) {
             snprintf(count_text, sizeof(count_text), "%d+ resultats (limite)", files->count);
@@ -499,30 +630,67 @@ void ui_render(UIState* state, FileList* files, const char* current_path) {
         }
     }
     
+    // Toggle expression régulière (à droite du précédent)
+    Rectangle regex_toggle = {content_toggle.x + content_toggle.width + 10, (float)toggle_content_y, 180, 20};
+    DrawRectangleRec(regex_toggle, toggle_content_bg);
+    DrawRectangleLinesEx(regex_toggle, 1, state->colors.border);
+    
+    Rectangle regex_cb = {regex_toggle.x + 6, regex_toggle.y + 3, 14, 14};
+    DrawRectangleLinesEx(regex_cb, 2, state->colors.text_secondary);
+    if (state->search_regex) {
+        DrawRectangle(regex_cb.x + 3, regex_cb.y + 3, regex_cb.width - 6, regex_cb.height - 6, ORANGE);
+    }
+    DrawText("Expression reguliere", (int)(regex_cb.x + 24), (int)(regex_toggle.y + 2), 14, state->colors.text_primary);
+    if (CheckCollisionPointRec(GetMousePosition(), regex_toggle) && IsMouseButtonPressed(MOUSE_LEFT_BUTTON)) {
+        state->search_regex = !state->search_regex;
+        if (state->search_regex) state->search_fuzzy = false;
+    }
+    
+    // Toggle recherche approximative (exclusive de l'expression régulière)
+    Rectangle fuzzy_toggle = {regex_toggle.x + regex_toggle.width + 10, (float)toggle_content_y, 190, 20};
+    DrawRectangleRec(fuzzy_toggle, toggle_content_bg);
+    DrawRectangleLinesEx(fuzzy_toggle, 1, state->colors.border);
+    
+    Rectangle fuzzy_cb = {fuzzy_toggle.x + 6, fuzzy_toggle.y + 3, 14, 14};
+    DrawRectangleLinesEx(fuzzy_cb, 2, state->colors.text_secondary);
+    if (state->search_fuzzy) {
+        DrawRectangle(fuzzy_cb.x + 3, fuzzy_cb.y + 3, fuzzy_cb.width - 6, fuzzy_cb.height - 6, ORANGE);
+    }
+    DrawText("Recherche approximative", (int)(fuzzy_cb.x + 24), (int)(fuzzy_toggle.y + 2), 14, state->colors.text_primary);
+    if (CheckCollisionPointRec(GetMousePosition(), fuzzy_toggle) && IsMouseButtonPressed(MOUSE_LEFT_BUTTON)) {
+        state->search_fuzzy = !state->search_fuzzy;
+        if (state->search_fuzzy) state->search_regex = false;
+    }
+    
     // Barre de progression si recherche en cours
     int progress_y = toggle_content_y + 25;
     if (state->is_searching) {
         DrawRectangle(PADDING, progress_y, state->window_width - 2 * PADDING, 25, Fade(state->colors.accent, 0.1f));
         
         char progress_text[256];
+        const SearchStats* stats = &state->search_stats;
         if (state->search_by_content) {
             snprintf(progress_text, sizeof(progress_text), 
-                    "Scan: %d fichiers, %d dossiers | Trouvés: %d | Temps: %.1fs",
-                    state->search_files_scanned, state->search_dirs_scanned, 
-                    state->search_files_matched, state->search_elapsed_time);
+                    "Scan: %d fichiers, %d dossiers | Trouvés: %d | Lus: %.1f Mo (%.1f Mo/s, %.0f fichiers/s) | Ignorés: %d binaires, %d trop gros, %d par l'index | Temps: %.1fs",
+                    stats->files_scanned, stats->dirs_scanned, stats->files_matched,
+                    (double)stats->bytes_read / (1024.0 * 1024.0), stats->megabytes_per_second,
+                    stats->files_per_second, stats->files_binary, stats->files_oversized,
+                    stats->files_pruned, stats->elapsed_time);
         } else {
             snprintf(progress_text, sizeof(progress_text), 
-                    "Scan: %d fichiers, %d dossiers | Trouvés: %d | Temps: %.1fs",
-                    state->search_files_scanned, state->search_dirs_scanned, 
-                    state->search_files_matched, state->search_elapsed_time);
+                    "Scan: %d fichiers, %d dossiers | Trouvés: %d | %.0f fichiers/s | Temps: %.1fs",
+                    stats->files_scanned, stats->dirs_scanned, stats->files_matched,
+                    stats->files_per_second, stats->elapsed_time);
         }
         DrawText(progress_text, PADDING + 5, progress_y + 5, 14, state->colors.accent);
         
-        // Animation de chargement
-        int spinner_x = state->window_width - 40;
-        int spinner_y = progress_y + 12;
-        float angle = (float)((int)(GetTime() * 500) % 360);
-        DrawCircleSector((Vector2){spinner_x, spinner_y}, 8, angle, angle + 270, 16, BLUE);
+        // Animation de chargement (seulement pendant la recherche)
+        if (state->search_running) {
+            int spinner_x = state->window_width - 40;
+            int spinner_y = progress_y + 12;
+            float angle = (float)((int)(GetTime() * 500) % 360);
+            DrawCircleSector((Vector2){spinner_x, spinner_y}, 8, angle, angle + 270, 16, BLUE);
+        }
     }
     
     // Détection du clic sur la barre de recherche
@@ -616,7 +784,7 @@ void ui_render(UIState* state, FileList* files, const char* current_path) {
         DrawText(text, (int)input_box.x + 10, (int)input_box.y + 9, 16, text_color);
         
         // Blinking cursor
-        if (state->create_name[0] != '\0' && ((int)(GetTime() * 2) % 2 == 0)) {
+        if (state->create_name[0] != '\0' && caret_visible(state)) {
             int tw = MeasureText(state->create_name, 16);
             DrawText("|", (int)input_box.x + 10 + tw, (int)input_box.y + 9, 16, state->colors.text_primary);
         }
@@ -688,94 +856,103 @@ void ui_render(UIState* state, FileList* files, const char* current_path) {
     int header_y = content_y + LINE_HEIGHT;
     y = header_y - state->scroll_offset;
     
-    // Dessiner les fichiers
-    for (int i = 0; i < files->count; i++) {
-        FileEntry* entry = &files->entries[i];
+    // Dessiner uniquement les lignes visibles (coût indépendant de la taille de la liste)
+    int first_visible, end_visible;
+    list_view_visible_range(files->count, state->scroll_offset, header_y, state->window_height, &first_visible, &end_visible);
+    y += first_visible * LINE_HEIGHT;
+    
+    for (int i = first_visible; i < end_visible; i++) {
+        FileEntry* entry = file_list_get(files, i);
         
-        // Ne dessiner que les éléments visibles
-        if (y >= header_y - LINE_HEIGHT && y < state->window_height) {
-            int x = PADDING + (entry->depth * INDENT_SIZE);
-            
-            // Fond de sélection
-            Color bg_color = BLANK;
-            Rectangle item_rect = { 0, (float)y, (float)file_list_width, LINE_HEIGHT };
-            
-            if (CheckCollisionPointRec(GetMousePosition(), item_rect)) {
-                bg_color = state->colors.highlight;
-                if (IsMouseButtonPressed(MOUSE_LEFT_BUTTON)) {
-                    state->selected_index = i;
-                    if (entry->type == FILE_TYPE_DIRECTORY) {
-                        // Navigation dans un dossier
-                        state->clicked_path = (char*)malloc(strlen(entry->path) + 1);
-                        if (state->clicked_path) {
-                            strcpy(state->clicked_path, entry->path);
-                        }
-                    } else {
-                        // Charger le contenu du fichier
-                        load_file_content(state, entry->path);
+        int x = PADDING + (entry->depth * INDENT_SIZE);
+        
+        // Fond de sélection
+        Color bg_color = BLANK;
+        Rectangle item_rect = { 0, (float)y, (float)file_list_width, LINE_HEIGHT };
+        
+        if (CheckCollisionPointRec(GetMousePosition(), item_rect)) {
+            bg_color = state->colors.highlight;
+            if (IsMouseButtonPressed(MOUSE_LEFT_BUTTON)) {
+                state->selected_index = i;
+                if (entry->type == FILE_TYPE_DIRECTORY) {
+                    // Navigation dans un dossier
+                    state->clicked_path = (char*)malloc(entry->path_length + 1);
+                    if (state->clicked_path) {
+                        strcpy(state->clicked_path, file_entry_path(files, entry));
                     }
+                } else {
+                    // Charger le contenu du fichier
+                    load_file_content(state, file_entry_path(files, entry), entry->match_line);
                 }
             }
-            
-            if (i == state->selected_index) {
-                bg_color = Fade(SKYBLUE, 0.4f);
-            }
-            
-            DrawRectangleRec(item_rect, bg_color);
-            
-            if (i == state->selected_index) {
-                bg_color = state->colors.highlight_hover;
-                DrawRectangleRec(item_rect, Fade(bg_color, 0.3f));
-            }
-            
-            // Opacité adaptée pour fichiers cachés
-            float alpha = get_entry_opacity(entry->name);
-            
-            // Icône dessinée
-            Color icon_color = (entry->type == FILE_TYPE_DIRECTORY) ? state->colors.accent : state->colors.text_secondary;
-            icon_color = Fade(icon_color, alpha);
-            
-            if (entry->type == FILE_TYPE_DIRECTORY) {
-                // Dossier : rectangle avec onglet
-                DrawRectangle(x + 2, y + 8, 18, 14, icon_color);
-                DrawRectangle(x + 2, y + 5, 8, 3, icon_color);
-            } else {
-                // Fichier : rectangle avec coin plié
-                DrawRectangle(x + 3, y + 5, 14, 17, Fade(icon_color, 0.5f));
-                DrawRectangle(x + 3, y + 5, 14, 1, icon_color);
-                DrawRectangle(x + 3, y + 5, 1, 17, icon_color);
-                DrawRectangle(x + 17, y + 5, 1, 17, icon_color);
-                DrawRectangle(x + 3, y + 22, 15, 1, icon_color);
-                // Coin plié
-                DrawTriangle(
-                    (Vector2){x + 17, y + 5},
-                    (Vector2){x + 12, y + 5},
-                    (Vector2){x + 17, y + 10},
-                    icon_color
-                );
-            }
-            
-            // Colonne 1: Nom - avec couleur adaptée pour fichiers cachés
-            Color name_color = get_text_color_for_entry(state, entry->name, i == state->selected_index);
-            name_color = Fade(name_color, alpha);
-            DrawText(entry->name, x + 28, y + 3, FONT_SIZE - 2, name_color);
-            
-            // Colonne 2: Taille (seulement pour les fichiers)
-            Color size_color = Fade(state->colors.text_secondary, alpha);
-            if (entry->type == FILE_TYPE_FILE) {
-                char size_str[64];
-                format_size(entry->size, size_str, sizeof(size_str));
-                DrawText(size_str, PADDING + col_name_width, y + 5, FONT_SIZE - 4, size_color);
-            } else {
-                DrawText("[dossier]", PADDING + col_name_width, y + 5, FONT_SIZE - 4, size_color);
-            }
-            
-            // Colonne 3: Date de modification
-            char date_str[32];
-            format_time(entry->mod_time, date_str, sizeof(date_str));
-            DrawText(date_str, PADDING + col_name_width + col_size_width, y + 5, FONT_SIZE - 4, size_color);
         }
         
+        if (i == state->selected_index) {
+            bg_color = Fade(SKYBLUE, 0.4f);
+        }
+        
+        DrawRectangleRec(item_rect, bg_color);
+        
+        if (i == state->selected_index) {
+            bg_color = state->colors.highlight_hover;
+            DrawRectangleRec(item_rect, Fade(bg_color, 0.3f));
+        }
+        
+        // Opacité adaptée pour fichiers cachés
+        const char* entry_name = file_entry_name(files, entry);
+        float alpha = get_entry_opacity(entry_name);
+        
+        // Icône dessinée
+        Color icon_color = (entry->type == FILE_TYPE_DIRECTORY) ? state->colors.accent : state->colors.text_secondary;
+        icon_color = Fade(icon_color, alpha);
+        
+        if (entry->type == FILE_TYPE_DIRECTORY) {
+            // Dossier : rectangle avec onglet
+            DrawRectangle(x + 2, y + 8, 18, 14, icon_color);
+            DrawRectangle(x + 2, y + 5, 8, 3, icon_color);
+        } else {
+            // Fichier : rectangle avec coin plié
+            DrawRectangle(x + 3, y + 5, 14, 17, Fade(icon_color, 0.5f));
+            DrawRectangle(x + 3, y + 5, 14, 1, icon_color);
+            DrawRectangle(x + 3, y + 5, 1, 17, icon_color);
+            DrawRectangle(x + 17, y + 5, 1, 17, icon_color);
+            DrawRectangle(x + 3, y + 22, 15, 1, icon_color);
+            // Coin plié
+            DrawTriangle(
+                (Vector2){x + 17, y + 5},
+                (Vector2){x + 12, y + 5},
+                (Vector2){x + 17, y + 10},
+                icon_color
+            );
+        }
+        
+        // Colonne 1: Nom - avec couleur adaptée pour fichiers cachés
+        Color name_color = get_text_color_for_entry(state, entry_name, i == state->selected_index);
+        name_color = Fade(name_color, alpha);
+        DrawText(entry_name, x + 28, y + 3, FONT_SIZE - 2, name_color);
+        
+        // Ligne de la première occurrence (recherche par contenu)
+        if (entry->match_line > 0) {
+            char line_str[32];
+            snprintf(line_str, sizeof(line_str), ":%d", entry->match_line);
+            DrawText(line_str, x + 28 + MeasureText(entry_name, FONT_SIZE - 2) + 4, y + 5, FONT_SIZE - 4, Fade(state->colors.text_secondary, alpha));
+        }
+        
+        // Colonne 2: Taille (seulement pour les fichiers)
+        Color size_color = Fade(state->colors.text_secondary, alpha);
+        if (entry->type == FILE_TYPE_FILE) {
+            char size_str[64];
+            format_size(entry->size, size_str, sizeof(size_str));
+            DrawText(size_str, PADDING + col_name_width, y + 5, FONT_SIZE - 4, size_color);
+        } else {
+            DrawText("[dossier]", PADDING + col_name_width, y + 5, FONT_SIZE - 4, size_color);
+        }
+        
+        // Colonne 3: Date de modification
+        char date_str[32];
+        format_time(entry->mod_time, date_str, sizeof(date_str));
+        DrawText(date_str, PADDING + col_name_width + col_size_width, y + 5, FONT_SIZE - 4, size_color);
+        
         y += LINE_HEIGHT;
     }
     
@@ -823,6 +1000,7 @@ void ui_render(UIState* state, FileList* files, const char* current_path) {
                     free(state->file_content);
                     state->file_content = NULL;
                 }
+                clear_file_matches(state);
             }
         }
         DrawRectangleRec(close_btn, close_color);
@@ -861,6 +1039,10 @@ void ui_render(UIState* state, FileList* files, const char* current_path) {
             // Afficher le contenu ligne par ligne
             BeginScissorMode(panel_x, text_y, panel_width, text_area_height);
             
+            update_file_matches(state);
+            const ContentMatch* matches = state->file_matches;
+            int match_index = 0;
+            
             int line_y = text_y - state->file_scroll_offset;
             int line_height = 16;
             char* line_start = state->file_content;
@@ -890,39 +1072,27 @@ void ui_render(UIState* state, FileList* files, const char* current_path) {
                     snprintf(num_str, sizeof(num_str), "%4d", line_num);
                     DrawText(num_str, panel_x + 5, line_y, 14, state->colors.text_secondary);
                     
-                    // Contenu de la ligne - avec highlight si recherche par contenu
-                    if (state->search_by_content && state->search_text[0] != '\0') {
-                        // Chercher et mettre en avant le texte trouvé
-                        const char* search_pos = strstr(line_buffer, state->search_text);
-                        if (search_pos) {
-                            // Afficher le début avant la correspondance
-                            int before_len = search_pos - line_buffer;
-                            char before_buf[512];
-                            strncpy(before_buf, line_buffer, before_len);
-                            before_buf[before_len] = '\0';
-                            DrawText(before_buf, panel_x + 45, line_y, 14, state->colors.text_primary);
-                            
-                            // Mettre en évidence la correspondance
-                            int match_width = MeasureText(before_buf, 14);
-                            Rectangle highlight_box = {
-                                (float)(panel_x + 45 + match_width),
-                                (float)(line_y - 1),
-                                (float)MeasureText(state->search_text, 14) + 4,
-                                14 + 2
-                            };
-                            DrawRectangleRec(highlight_box, Fade(state->colors.accent, 0.3f));
-                            DrawText(state->search_text, panel_x + 45 + match_width + 2, line_y, 14, ORANGE);
-                            
-                            // Afficher la fin après la correspondance
-                            const char* after_start = search_pos + strlen(state->search_text);
-                            int after_width = match_width + MeasureText(state->search_text, 14) + 2;
-                            DrawText(after_start, panel_x + 45 + after_width, line_y, 14, state->colors.text_primary);
-                        } else {
-                            DrawText(line_buffer, panel_x + 45, line_y, 14, state->colors.text_primary);
-                        }
-                    } else {
-                        DrawText(line_buffer, panel_x + 45, line_y, 14, state->colors.text_primary);
+                    // Contenu de la ligne, occurrences de la recherche par
+                    // contenu mises en avant telles qu'écrites dans le fichier
+                    long line_offset = line_start - state->file_content;
+                    while (match_index < state->file_match_count &&
+                           matches[match_index].offset + matches[match_index].length <= line_offset) {
+                        match_index++;
                     }
+                    
+                    int x = panel_x + 45;
+                    int cursor = 0;
+                    for (int m = match_index; m < state->file_match_count && matches[m].offset < line_offset + line_len; m++) {
+                        int start = (int)(matches[m].offset - line_offset);
+                        int end = start + matches[m].length;
+                        if (start < cursor) start = cursor;
+                        if (end > line_len) end = line_len;
+                        
+                        x += draw_text_segment(line_buffer + cursor, start - cursor, x, line_y, state->colors.text_primary, false, BLANK);
+                        x += draw_text_segment(line_buffer + start, end - start, x, line_y, ORANGE, true, Fade(state->colors.accent, 0.3f));
+                        cursor = end;
+                    }
+                    DrawText(line_buffer + cursor, x, line_y, 14, state->colors.text_primary);
                 }
                 
                 line_y += line_height;
@@ -951,6 +1121,13 @@ void ui_render(UIState* state, FileList* files, const char* current_path) {
     int text_width = MeasureText(instructions, 12);
     DrawText(instructions, state->window_width - text_width - PADDING, state->window_height - 25, 12, state->colors.text_secondary);
     
+    // Au repos, EndDrawing() bloque jusqu'au prochain événement
+    if (state->animating) {
+        DisableEventWaiting();
+    } else {
+        EnableEventWaiting();
+    }
+    
     EndDrawing();
 }
 
@@ -980,18 +1157,47 @@ void ui_set_searching(UIState* state, bool searching) {
     }
 }
 
+void ui_set_search_running(UIState* state, bool running) {
+    if (state) {
+        state->search_running = running;
+    }
+}
+
 void ui_set_search_limit_reached(UIState* state, bool reached) {
     if (state) {
         state->search_limit_reached = reached;
     }
 }
 
-void ui_set_search_stats(UIState* state, int files_scanned, int dirs_scanned, int files_matched, double elapsed_time) {
+void ui_set_search_stats(UIState* state, const SearchStats* stats) {
+    if (state && stats) {
+        state->search_stats = *stats;
+    }
+}
+
+void ui_request_redraw(UIState* state) {
+    if (state) {
+        state->redraw_requested = true;
+    }
+}
+
+#if defined(__ELF__)
+// raylib embarque GLFW: glfwPostEmptyEvent() débloque glfwWaitEvents().
+// Référence faible: sans ce symbole, la vue se met à jour au prochain événement.
+extern void glfwPostEmptyEvent(void) __attribute__((weak));
+#endif
+
+void ui_wakeup(void) {
+#if defined(__ELF__)
+    if (glfwPostEmptyEvent) {
+        glfwPostEmptyEvent();
+    }
+#endif
+}
+
+void ui_set_on_demand_rendering(UIState* state, bool enabled) {
     if (state) {
-        state->search_files_scanned = files_scanned;
-        state->search_dirs_scanned = dirs_scanned;
-        state->search_files_matched = files_matched;
-        state->search_elapsed_time = elapsed_time;
+        state->on_demand_rendering = enabled;
     }
 }
 
@@ -1025,6 +1231,14 @@ bool ui_get_search_by_content(UIState* state) {
     return state ? state->search_by_content : false;
 }
 
+bool ui_get_search_regex(UIState* state) {
+    return state ? state->search_regex : false;
+}
+
+bool ui_get_search_fuzzy(UIState* state) {
+    return state ? state->search_fuzzy : false;
+}
+
 bool ui_creation_confirmed(UIState* state) {
     return state ? state->create_confirmed : false;
 }
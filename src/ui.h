@@ -40,18 +40,24 @@ typedef struct {
     bool search_active;    // Si la barre de recherche est active
     bool is_searching;     // Si on affiche des résultats de recherche récursive
     bool search_limit_reached; // Si la limite de résultats a été atteinte
+    bool search_running;       // Si une recherche asynchrone est en cours
     char* selected_file_path;  // Chemin du fichier sélectionné pour visualisation
     char* file_content;        // Contenu du fichier sélectionné
     bool is_binary_file;       // Si le fichier sélectionné est binaire
     long file_size;            // Taille du fichier sélectionné
     int file_scroll_offset;    // Offset de scroll pour le contenu du fichier
+    ContentMatch* file_matches;    // Occurrences de la recherche par contenu dans file_content
+    int file_match_count;
+    char file_match_query[256];    // Requête de ces occurrences ("": à calculer)
+    bool file_match_regex;         // Requête interprétée comme expression régulière
     bool show_hidden;          // Afficher fichiers/dossiers cachés
     bool search_by_content;    // Rechercher dans le contenu (vs par nom)
+    bool search_regex;         // Requête interprétée comme expression régulière
+    bool search_fuzzy;         // Recherche approximative (noms classés par pertinence)
+    char regex_error[128];     // Erreur de compilation de l'expression ("": valide)
+    char regex_error_query[256]; // Expression pour laquelle regex_error a été calculée
     // Statistiques de recherche
-    int search_files_scanned;
-    int search_dirs_scanned;
-    int search_files_matched;
-    double search_elapsed_time;
+    SearchStats search_stats;
     // Thème
     Theme current_theme;
     ThemeColors colors;
@@ -64,6 +70,11 @@ typedef struct {
     bool create_confirmed;
     CreateType create_type;
     char create_name[256];
+    // Rendu à la demande
+    bool on_demand_rendering;  // Attendre un événement entre deux images au repos
+    bool animating;            // Image courante terminée sans attente (recherche en cours...)
+    bool redraw_requested;     // Une image de plus demandée par la boucle principale
+    bool woke_from_wait;       // L'image précédente s'est terminée en attente
 } UIState;
 
 // Initialise l'interface utilisateur
@@ -93,6 +104,12 @@ bool ui_get_show_hidden(UIState* state);
 // Récupère l'état de la recherche par contenu
 bool ui_get_search_by_content(UIState* state);
 
+// Récupère l'état de la recherche par expression régulière
+bool ui_get_search_regex(UIState* state);
+
+// Récupère l'état de la recherche approximative
+bool ui_get_search_fuzzy(UIState* state);
+
 // Création: vérifie si une création a été confirmée
 bool ui_creation_confirmed(UIState* state);
 
@@ -108,11 +125,23 @@ void ui_clear_creation_request(UIState* state);
 // Définit l'état de recherche
 void ui_set_searching(UIState* state, bool searching);
 
+// Indique si une recherche asynchrone est en cours (anime la barre de progression)
+void ui_set_search_running(UIState* state, bool running);
+
 // Définit si la limite de résultats a été atteinte
 void ui_set_search_limit_reached(UIState* state, bool reached);
 
 // Met à jour les statistiques de recherche
-void ui_set_search_stats(UIState* state, int files_scanned, int dirs_scanned, int files_matched, double elapsed_time);
+void ui_set_search_stats(UIState* state, const SearchStats* stats);
+
+// Demande une image supplémentaire sans attendre d'événement (données modifiées)
+void ui_request_redraw(UIState* state);
+
+// Réveille la boucle principale bloquée en attente d'événements (thread-safe)
+void ui_wakeup(void);
+
+// Active/désactive le rendu à la demande (désactivé: redessin continu à 60 FPS)
+void ui_set_on_demand_rendering(UIState* state, bool enabled);
 
 // Gère le thème
 void ui_set_theme(UIState* state, Theme theme);